@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <string.h>
+
+// SDL2main isn't linked, so main has to stay main on every platform.
+#define SDL_MAIN_HANDLED
+#include <input_manager.h>
+#include <action_manager.h>
+
+/*
+    Measures action_manager_update with 1000 actions, comparing the
+    incremental update against evaluating every action, while the input
+    is idle and while it's busy.
+
+    The InputManager is filled in directly, so no input devices are needed.
+*/
+
+#define ACTION_COUNT 1000
+#define FRAMES 20000
+
+static double bench_run(ActionManager* actions, InputManager* input, SDL_bool busy) {
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    for(int frame = 0; frame < FRAMES; frame++) {
+        if(busy) {
+            // Taps a handful of keys and a mouse button every frame.
+            for(int i = 0; i < 4; i++) {
+                int key = (frame * 7 + i * 31) % 256;
+                input->keyboard_current[key >> 6] ^= (Uint64)1 << (key & 63);
+            }
+            input->mouse_current ^= SDL_BUTTON(SDL_BUTTON_LEFT);
+        }
+
+        action_manager_update(actions, input);
+    }
+
+    Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+    return (double)elapsed * 1e9 / (double)SDL_GetPerformanceFrequency() / FRAMES;
+}
+
+int main(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+
+    static InputManager input;
+    memset(&input, 0, sizeof(input));
+    input.gamepad_first_slot = -1;
+
+    ActionManager* actions = action_manager_create(ACTION_COUNT);
+    if(!actions)
+        return 1;
+
+    for(int i = 0; i < ACTION_COUNT; i++) {
+        action_manager_add_key(actions, i, (SDL_Scancode)(i % 256));
+        action_manager_add_key(actions, i, (SDL_Scancode)((i * 13) % 256));
+        action_manager_add_mouse_button(actions, i, SDL_BUTTON(1 + i % 3));
+        action_manager_add_gamepad_button(actions, i, i % SDL_CONTROLLER_BUTTON_MAX, -1);
+    }
+
+    action_manager_compile(actions);
+
+    for(int incremental = 0; incremental < 2; incremental++) {
+        action_manager_set_incremental(actions, (SDL_bool)incremental);
+        for(int busy = 0; busy < 2; busy++) {
+            double ns = bench_run(actions, &input, (SDL_bool)busy);
+            printf("%-12s %-5s %10.1f ns/update\n",
+                   incremental ? "incremental" : "full",
+                   busy ? "busy" : "idle",
+                   ns);
+        }
+    }
+
+    action_manager_free(actions);
+    return 0;
+}
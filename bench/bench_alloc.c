@@ -0,0 +1,28 @@
+#include "bench_alloc.h"
+
+#include <stdlib.h>
+
+static unsigned long long allocations;
+
+void* bench_malloc(size_t size) {
+    allocations++;
+    return malloc(size);
+}
+
+void* bench_calloc(size_t count, size_t size) {
+    allocations++;
+    return calloc(count, size);
+}
+
+void* bench_realloc(void* ptr, size_t size) {
+    allocations++;
+    return realloc(ptr, size);
+}
+
+void bench_free(void* ptr) {
+    free(ptr);
+}
+
+unsigned long long bench_alloc_count(void) {
+    return allocations;
+}
@@ -0,0 +1,21 @@
+#ifndef SDL_INPUT_BENCH_ALLOC_H
+#define SDL_INPUT_BENCH_ALLOC_H
+
+#include <stddef.h>
+
+/*
+    Counting allocator used by the benchmarks.
+    The library sources are compiled into the benchmark with the input_* allocation
+    macros pointing here (see bench/meson.build), so every allocation the library
+    makes is counted.
+*/
+
+void* bench_malloc(size_t size);
+void* bench_calloc(size_t count, size_t size);
+void* bench_realloc(void* ptr, size_t size);
+void bench_free(void* ptr);
+
+// Gets the amount of allocations and reallocations made so far.
+unsigned long long bench_alloc_count(void);
+
+#endif
@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <string.h>
+
+// SDL2main isn't linked, so main has to stay main on every platform.
+#define SDL_MAIN_HANDLED
+#include <input_manager.h>
+#include <action_manager.h>
+
+#include "bench_alloc.h"
+
+/*
+    Measures the per-frame cost of input_manager_update + action_manager_update.
+
+    Runs headless using SDL's dummy video driver, with gamepads provided by
+    virtual joysticks and touch/wheel events pushed into the SDL event queue.
+    Each sweep varies one parameter from the baseline configuration.
+
+    Usage: input_bench [--output results.json] [--frames count]
+
+    Results are printed as a table, and optionally written as one JSON object
+    per line so different runs can be compared.
+*/
+
+typedef struct BenchConfig {
+    const char* sweep;
+    int actions;
+    int bindings;
+    int gamepads;
+    int touch_rate;
+    int wheel_rate;
+} BenchConfig;
+
+typedef struct BenchResult {
+    double ns_per_update;
+    double allocs_per_update;
+} BenchResult;
+
+static const BenchConfig bench_baseline = { "baseline", 256, 2, 1, 0, 0 };
+
+static const int bench_action_counts[] = { 16, 64, 256, 1024, 4096 };
+static const int bench_binding_counts[] = { 1, 2, 4, 8 };
+static const int bench_gamepad_counts[] = { 0, 1, 2, 4, 16, 64 };
+static const int bench_touch_rates[] = { 0, 2, 10, 40 };
+static const int bench_wheel_rates[] = { 0, 1, 4, 16 };
+
+#define BENCH_WARMUP_FRAMES 100
+#define BENCH_MAX_GAMEPADS 64
+
+static int bench_frames = 2000;
+
+static void bench_add_bindings(ActionManager* actions, const BenchConfig* config) {
+    for(int i = 0; i < config->actions; i++) {
+        for(int j = 0; j < config->bindings; j++) {
+            switch((i + j) % 3) {
+                case 0:
+                    action_manager_add_key(actions, i, (SDL_Scancode)(SDL_SCANCODE_A + (i * 7 + j) % 100));
+                    break;
+                case 1:
+                    action_manager_add_gamepad_button(actions, i, (i + j) % SDL_CONTROLLER_BUTTON_MAX, j % 2 == 0 ? -1 : 0);
+                    break;
+                case 2:
+                    action_manager_add_mouse_button(actions, i, SDL_BUTTON(1 + (i + j) % 3));
+                    break;
+            }
+        }
+    }
+}
+
+static void bench_route_events(InputManager* input) {
+    input_manager_poll_events(input);
+
+    // Nothing else is used by the benchmarks.
+    SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+}
+
+static void bench_push_events(const BenchConfig* config, int frame) {
+    for(int i = 0; i < config->touch_rate; i++) {
+        SDL_Event e;
+        SDL_zero(e);
+        e.type = SDL_FINGERMOTION;
+        e.tfinger.touchId = 1;
+        e.tfinger.fingerId = i % 10;
+        e.tfinger.x = (float)(frame % 100) / 100.0f;
+        e.tfinger.y = (float)i / (float)config->touch_rate;
+        SDL_PushEvent(&e);
+    }
+
+    for(int i = 0; i < config->wheel_rate; i++) {
+        SDL_Event e;
+        SDL_zero(e);
+        e.type = SDL_MOUSEWHEEL;
+        e.wheel.y = (frame + i) % 2 == 0 ? 1 : -1;
+        SDL_PushEvent(&e);
+    }
+}
+
+static SDL_bool bench_run(const BenchConfig* config, BenchResult* result) {
+    SDL_Joystick* joysticks[BENCH_MAX_GAMEPADS] = { 0 };
+    int joystick_indices[BENCH_MAX_GAMEPADS];
+
+    for(int i = 0; i < config->gamepads; i++) {
+        joystick_indices[i] = SDL_JoystickAttachVirtual(SDL_JOYSTICK_TYPE_GAMECONTROLLER,
+                                                        SDL_CONTROLLER_AXIS_MAX,
+                                                        SDL_CONTROLLER_BUTTON_MAX,
+                                                        0);
+        if(joystick_indices[i] < 0)
+            return SDL_FALSE;
+
+        joysticks[i] = SDL_JoystickOpen(joystick_indices[i]);
+    }
+
+    InputManager* input = input_manager_create();
+    ActionManager* actions = action_manager_create(config->actions);
+    if(!input || !actions)
+        return SDL_FALSE;
+
+    bench_add_bindings(actions, config);
+    bench_route_events(input);
+
+    Uint64 elapsed = 0;
+    unsigned long long allocations = 0;
+
+    for(int frame = 0; frame < BENCH_WARMUP_FRAMES + bench_frames; frame++) {
+        SDL_bool measured = frame >= BENCH_WARMUP_FRAMES;
+
+        // Presses a different button on each pad every few frames.
+        for(int i = 0; i < config->gamepads; i++) {
+            if(joysticks[i])
+                SDL_JoystickSetVirtualButton(joysticks[i], (frame / 4 + i) % SDL_CONTROLLER_BUTTON_MAX, (frame / 2) % 2);
+        }
+
+        unsigned long long allocations_start = bench_alloc_count();
+
+        bench_push_events(config, frame);
+        bench_route_events(input);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        input_manager_update(input);
+        action_manager_update(actions, input);
+        Uint64 end = SDL_GetPerformanceCounter();
+
+        if(measured) {
+            elapsed += end - start;
+            allocations += bench_alloc_count() - allocations_start;
+        }
+    }
+
+    result->ns_per_update = (double)elapsed * 1e9 / (double)SDL_GetPerformanceFrequency() / bench_frames;
+    result->allocs_per_update = (double)allocations / bench_frames;
+
+    action_manager_free(actions);
+    input_manager_free(input);
+
+    for(int i = 0; i < config->gamepads; i++) {
+        if(joysticks[i])
+            SDL_JoystickClose(joysticks[i]);
+    }
+
+    // Virtual joysticks are detached from the last index so the earlier indices stay valid.
+    for(int i = config->gamepads - 1; i >= 0; i--)
+        SDL_JoystickDetachVirtual(joystick_indices[i]);
+
+    SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+    return SDL_TRUE;
+}
+
+static void bench_report(FILE* output, const BenchConfig* config, const BenchResult* result) {
+    printf("%-10s %8d %9d %9d %6d %6d %12.1f %14.3f\n",
+           config->sweep,
+           config->actions,
+           config->bindings,
+           config->gamepads,
+           config->touch_rate,
+           config->wheel_rate,
+           result->ns_per_update,
+           result->allocs_per_update);
+
+    if(output) {
+        fprintf(output,
+                "{\"sweep\":\"%s\",\"actions\":%d,\"bindings\":%d,\"gamepads\":%d,"
+                "\"touch_rate\":%d,\"wheel_rate\":%d,\"ns_per_update\":%.1f,\"allocs_per_update\":%.3f}\n",
+                config->sweep,
+                config->actions,
+                config->bindings,
+                config->gamepads,
+                config->touch_rate,
+                config->wheel_rate,
+                result->ns_per_update,
+                result->allocs_per_update);
+    }
+}
+
+#define BENCH_SWEEP(name, field, values) \
+    for(int i = 0; i < (int)SDL_arraysize(values); i++) { \
+        BenchConfig config = bench_baseline; \
+        config.sweep = name; \
+        config.field = values[i]; \
+        BenchResult result; \
+        if(!bench_run(&config, &result)) { \
+            fprintf(stderr, "Failed to run %s sweep: %s\n", name, SDL_GetError()); \
+            failed = 1; \
+            continue; \
+        } \
+        bench_report(output, &config, &result); \
+    }
+
+int main(int argc, char* argv[]) {
+    FILE* output = NULL;
+    int failed = 0;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = fopen(argv[++i], "w");
+            if(!output) {
+                fprintf(stderr, "Failed to open %s\n", argv[i]);
+                return 1;
+            }
+        } else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            bench_frames = SDL_atoi(argv[++i]);
+            if(bench_frames <= 0)
+                bench_frames = 1;
+        }
+    }
+
+    SDL_SetMainReady();
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    SDL_SetHint(SDL_HINT_JOYSTICK_ALLOW_BACKGROUND_EVENTS, "1");
+    if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) != 0) {
+        fprintf(stderr, "Failed to initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    printf("%-10s %8s %9s %9s %6s %6s %12s %14s\n",
+           "sweep", "actions", "bindings", "gamepads", "touch", "wheel", "ns/update", "allocs/update");
+
+    BENCH_SWEEP("actions", actions, bench_action_counts);
+    BENCH_SWEEP("bindings", bindings, bench_binding_counts);
+    BENCH_SWEEP("gamepads", gamepads, bench_gamepad_counts);
+    BENCH_SWEEP("touch", touch_rate, bench_touch_rates);
+    BENCH_SWEEP("wheel", wheel_rate, bench_wheel_rates);
+
+    if(output)
+        fclose(output);
+
+    SDL_Quit();
+    return failed;
+}
@@ -0,0 +1,111 @@
+#ifndef SDL_INPUT_ACTION_COMBO_H
+#define SDL_INPUT_ACTION_COMBO_H
+
+#include <SDL.h>
+
+/*
+    Types used to match sequences of actions, such as motion inputs, charge inputs and chords.
+
+    Every registered combo is compiled into a single trie of steps, where steps that are the
+    same in different combos are shared. Each update only looks at the steps that reference an
+    action that changed, and advances a fixed amount of partial matches, so the cost doesn't
+    depend on the amount of combos.
+*/
+
+// When compiling, can be used to change the amount of actions a single combo step can reference.
+#ifndef ACTION_COMBO_MAX_STEP_ACTIONS
+#define ACTION_COMBO_MAX_STEP_ACTIONS 4
+#endif
+
+// When compiling, can be used to change the amount of partial matches tracked at once.
+#ifndef ACTION_COMBO_MAX_ACTIVE
+#define ACTION_COMBO_MAX_ACTIVE 32
+#endif
+
+typedef enum ActionComboStepType {
+    // Happens on the update where every action in actions is down and none in excluded are.
+    ACTION_COMBO_STEP_PRESS,
+    // Happens on the update where the press condition stops being true,
+    // after having been true for at least hold updates.
+    ACTION_COMBO_STEP_CHARGE
+} ActionComboStepType;
+
+typedef struct ActionComboStep {
+    ActionComboStepType type;
+    // The actions that have to be down. More than one makes a chord.
+    Uint32 actions[ACTION_COMBO_MAX_STEP_ACTIONS];
+    int action_count;
+    // The actions that have to be up, i.e. the other directions of a motion input.
+    Uint32 excluded[ACTION_COMBO_MAX_STEP_ACTIONS];
+    int excluded_count;
+    // The most updates after the previous step this step can happen on. Ignored for the first step.
+    Uint16 window;
+    // For charge steps, how many updates the condition has to be true for.
+    Uint16 hold;
+} ActionComboStep;
+
+typedef struct ActionCombo {
+    ActionComboStep* steps;
+    int step_count;
+} ActionCombo;
+
+// A distinct step condition shared by every combo that uses it.
+typedef struct ActionComboSymbol {
+    ActionComboStepType type;
+    Uint16 hold;
+    int action_count;
+    int excluded_count;
+    Uint32 actions[ACTION_COMBO_MAX_STEP_ACTIONS];
+    Uint32 excluded[ACTION_COMBO_MAX_STEP_ACTIONS];
+} ActionComboSymbol;
+
+typedef struct ActionComboEdge {
+    int symbol;
+    Uint16 window;
+    int target;
+} ActionComboEdge;
+
+typedef struct ActionComboNode {
+    // The steps that can follow this one are edges[edge_start] up to edges[edge_start + edge_count].
+    int edge_start;
+    int edge_count;
+    // The combos that finish at this node are matches[match_start] up to matches[match_start + match_count].
+    int match_start;
+    int match_count;
+    // The longest window of the following steps. Partial matches older than this are dropped.
+    Uint16 max_window;
+} ActionComboNode;
+
+// A partial match, waiting for the next step.
+typedef struct ActionComboActive {
+    int node;
+    // The update the last step happened on.
+    Uint32 frame;
+} ActionComboActive;
+
+/*
+    The compiled combos of an <ActionManager>.
+    Everything except the partial matches lives in one block owned by symbols.
+*/
+typedef struct ActionComboMatcher {
+    ActionComboSymbol* symbols;
+    int symbol_count;
+    ActionComboNode* nodes;
+    int node_count;
+    ActionComboEdge* edges;
+    int* matches;
+    // Reverse index from each action to the symbols that reference it.
+    // The symbols for action n are action_symbols[action_offsets[n]] up to action_symbols[action_offsets[n + 1]].
+    int* action_offsets;
+    int* action_symbols;
+    // Scratch space for the symbols that happened during an update.
+    Uint64* evaluated;
+    int* fired;
+    ActionComboActive active[ACTION_COMBO_MAX_ACTIVE];
+    int active_count;
+    // The combos that finished during the last update.
+    int* matched;
+    int matched_count;
+} ActionComboMatcher;
+
+#endif
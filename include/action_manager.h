@@ -3,11 +3,20 @@
 
 #include <SDL.h>
 #include "input_manager.h"
+#include "action_combo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef enum InputActionType {
     INPUT_ACTION_KEYBOARD,
     INPUT_ACTION_GAMEPAD,
-    INPUT_ACTION_MOUSE
+    INPUT_ACTION_MOUSE,
+    INPUT_ACTION_GESTURE,
+    // Analog bindings. These only count as down once their value reaches the analog threshold.
+    INPUT_ACTION_GAMEPAD_AXIS,
+    INPUT_ACTION_GAMEPAD_STICK
 } InputActionType;
 
 typedef struct InputAction {
@@ -15,47 +24,466 @@ typedef struct InputAction {
     union {
         SDL_Scancode key;
         MouseButton mouse;
+        InputGesture gesture;
         struct {
             GamepadButton button;
             int controller_index;
         } gamepad;
+        struct {
+            SDL_GameControllerAxis axis;
+            int controller_index;
+        } axis;
+        struct {
+            // The pair of axes used for x and y. Triggers use the left trigger for x.
+            InputAxisGroup group;
+            int controller_index;
+        } stick;
     };
+    // What the binding adds to the value of the action. Buttons add (x, y) while they're down,
+    // axes add their value multiplied by (x, y), and sticks multiply each axis by its own component.
+    float x;
+    float y;
 } InputAction;
 
+typedef enum ActionValueMode {
+    // The value comes from the binding with the largest magnitude.
+    ACTION_VALUE_MAX_MAGNITUDE,
+    // The value is the sum of every binding, limited to a magnitude of 1.
+    ACTION_VALUE_SUM
+} ActionValueMode;
+
 typedef struct InputActionMap {
+    // The bindings of the action while it has an array of its own, or NULL once <action_manager_pack> moved them.
     InputAction* actions;
     int action_count;
     int action_capacity;
-    SDL_bool previous;
-    SDL_bool current;
+    // Where the bindings start in <ActionManager.bindings> once they're packed.
+    int binding_offset;
+    // How the bindings are combined into the value of the action.
+    // Buttons are always summed together first, so WASD style bindings make diagonals.
+    ActionValueMode value_mode;
 } InputActionMap;
 
+/*
+    A contiguous range of actions that can be enabled and disabled as a group, i.e. the
+    gameplay, menu or chat actions. The actions of a disabled layer are always up and aren't evaluated.
+    Actions that aren't part of a layer are always enabled, below every layer.
+*/
+typedef struct ActionLayer {
+    Uint32 first_action;
+    Uint32 action_count;
+    // Layers with a higher priority come first. Layers with the same priority are ordered by when they were pushed.
+    int priority;
+    // When set, the inputs bound to the layer are hidden from the layers below it while it's enabled.
+    SDL_bool consume;
+    SDL_bool enabled;
+    // When the layer was last pushed.
+    Uint32 order;
+} ActionLayer;
+
+// The inputs bound to a layer, or hidden from it.
+typedef struct ActionInputMask {
+    Uint64 keys[INPUT_KEYBOARD_WORDS];
+    MouseButton mouse;
+    GestureMask gestures;
+    // One mask per gamepad slot.
+    GamepadButtonMask* gamepad;
+} ActionInputMask;
+
+// A range of actions that belong to the same layer.
+typedef struct ActionLayerSpan {
+    int start;
+    int end;
+    int layer;
+} ActionLayerSpan;
+
+/*
+    The bindings of every action compiled into per-device masks, so that all
+    actions can be evaluated with a few AND operations over the device state.
+    Each array is laid out device-word-major, i.e. keys[word * action_count + action],
+    so the evaluation of one word runs linearly over every action.
+*/
+typedef struct ActionBindingMasks {
+    // INPUT_KEYBOARD_WORDS masks per action.
+    Uint64* keys;
+    // Bitmask of the keyboard words that have at least one key bound.
+    Uint32 key_words;
+    MouseButton* mouse;
+    // gamepad_slots masks per action. Slot 0 is the first controller (index -1),
+    // slot n is the controller at index n - 1.
+    GamepadButtonMask* gamepad;
+    int gamepad_slots;
+    GestureMask* gestures;
+    // Actions with bindings that can't be represented as a single bit (i.e. mouse button chords).
+    // These are evaluated one binding at a time.
+    Uint64* fallback;
+    // Scratch space holding the combined mask hits of each action.
+    Uint64* hits;
+    // Scratch bitset of the actions that need to be evaluated during an incremental update.
+    Uint64* dirty;
+
+    /*
+        Reverse index from each input to the actions bound to it.
+        The actions bound to input n are *_actions[*_offsets[n]] up to *_actions[*_offsets[n + 1]].
+    */
+
+    // SDL_NUM_SCANCODES + 1 offsets.
+    int* key_offsets;
+    int* key_actions;
+    // One offset per mouse button bit + 1.
+    int* mouse_offsets;
+    int* mouse_actions;
+    // One offset per button per gamepad slot + 1.
+    int* gamepad_offsets;
+    int* gamepad_actions;
+    // One offset per gesture + 1.
+    int* gesture_offsets;
+    int* gesture_actions;
+
+    // The actions that can have a value other than 0 or 1, which are evaluated every update.
+    int* value_actions;
+    int value_count;
+
+    // The layer of each action. Actions outside of every layer use the index after the last layer.
+    int* action_layers;
+    // The actions split into runs of the same layer, ordered by action.
+    ActionLayerSpan* spans;
+    int span_count;
+    // The inputs bound to each layer, and the inputs consumed by the enabled layers above each layer.
+    ActionInputMask* layer_inputs;
+    ActionInputMask* layer_blocked;
+    // Bitset of the actions in enabled layers.
+    Uint64* active;
+
+    /*
+        Copies of the reverse index, the value actions and the fallback actions that only hold the actions in enabled layers.
+        Rebuilt whenever a layer changes, so the updates never visit the actions of a disabled layer.
+    */
+
+    int* active_key_offsets;
+    int* active_key_actions;
+    int* active_mouse_offsets;
+    int* active_mouse_actions;
+    int* active_gamepad_offsets;
+    int* active_gamepad_actions;
+    int* active_gesture_offsets;
+    int* active_gesture_actions;
+    int* active_value_actions;
+    int active_value_count;
+    Uint64* active_fallback;
+
+    // The device state seen by the last update, used to find the inputs that changed.
+    Uint64 key_state[INPUT_KEYBOARD_WORDS];
+    MouseButton mouse_state;
+    GamepadButtonMask* gamepad_state;
+    GestureMask gesture_state;
+    // Set once every action has been evaluated against the device state above.
+    SDL_bool primed;
+} ActionBindingMasks;
+
 typedef struct ActionManager {
     InputActionMap* actions;
     int action_count;
+    // The state of every action, packed into one bit per action.
+    Uint64* current;
+    Uint64* previous;
+    // The value of every action, laid out so systems can read all of them in one pass.
+    // Actions without analog or directional bindings are 1 while they're down, and 0 otherwise.
+    float* value_x;
+    float* value_y;
+    // How far an analog binding has to be pushed for it to count as down.
+    float analog_threshold;
+    ActionBindingMasks masks;
+    // Set when a binding changes so the masks are rebuilt during the next update.
+    SDL_bool masks_dirty;
+    // When set, an update only evaluates the actions bound to inputs that changed since the last update.
+    SDL_bool incremental;
+    // The registered combos, and the automaton they're compiled into.
+    ActionCombo* combos;
+    int combo_count;
+    int combo_capacity;
+    ActionComboMatcher combo_matcher;
+    SDL_bool combos_dirty;
+    // A ring of the action states from the last history_length updates. The newest is at frame.
+    // Only allocated once it's needed by a combo or <action_manager_set_history_length>.
+    Uint64* history;
+    int history_length;
+    // The amount of updates so far.
+    Uint32 frame;
+    ActionLayer* layers;
+    int layer_count;
+    int layer_capacity;
+    // Set when a layer is enabled or disabled so the consumed inputs are recalculated during the next update.
+    SDL_bool layers_dirty;
+    // Counts the pushes, to order the layers.
+    Uint32 layer_order;
+    // Used for every allocation made by the manager.
+    InputAllocator allocator;
+#if INPUT_ENABLE_STATS
+    InputStats stats;
+    // The time from the events behind each action change until the update that made it visible,
+    // split by the kind of device that caused it.
+    InputLatencyHistogram latency[INPUT_LATENCY_DEVICE_MAX];
+#endif
+    // The bindings of every action after <action_manager_pack>, stored one action after another.
+    // Actions refer to their bindings by offset, so the block can be copied or moved as a whole.
+    InputAction* bindings;
+    int binding_count;
+    // The last 64 updates of each action, see <input_history_bits>.
+    Uint64* action_history;
+    Uint32* action_history_frames;
 } ActionManager;
 
 static inline SDL_bool action_check(ActionManager* action_manager, Uint32 action) {
-    return action_manager->actions[action].current;
+    return input_bitset_test(action_manager->current, action);
 }
 
 static inline SDL_bool action_pressed(ActionManager* action_manager, Uint32 action) {
-    return action_manager->actions[action].current && 
-           !action_manager->actions[action].previous;
+    return (SDL_bool)(input_bitset_test(action_manager->current, action) && 
+                      !input_bitset_test(action_manager->previous, action));
 }
 
 static inline SDL_bool action_released(ActionManager* action_manager, Uint32 action) {
-    return !action_manager->actions[action].current && 
-           action_manager->actions[action].previous;
+    return (SDL_bool)(!input_bitset_test(action_manager->current, action) && 
+                      input_bitset_test(action_manager->previous, action));
+}
+
+/*
+    Checks if an action was down a number of updates ago, where 0 is the last update.
+    Returns SDL_FALSE if the update is older than the history kept by the <ActionManager>.
+*/
+static inline SDL_bool action_history_check(ActionManager* action_manager, Uint32 action, int frames_ago) {
+    if(frames_ago < 0 || frames_ago >= action_manager->history_length)
+        return SDL_FALSE;
+
+    int words = INPUT_BITSET_WORDS(action_manager->action_count);
+    Uint32 frame = action_manager->frame - (Uint32)frames_ago;
+    return input_bitset_test(action_manager->history + (frame & (action_manager->history_length - 1)) * words, action);
+}
+
+// Gets the state of an action over the last 64 updates, where bit 0 is the last update.
+static inline Uint64 action_history_bits(ActionManager* action_manager, Uint32 action) {
+    return input_history_bits(action_manager->action_history[action], action_manager->action_history_frames[action], action_manager->frame);
+}
+
+// Checks if an action was pressed during any of the last frames updates, up to 63.
+static inline SDL_bool action_pressed_within(ActionManager* action_manager, Uint32 action, int frames) {
+    return input_history_pressed_within(action_history_bits(action_manager, action), frames);
+}
+
+// Checks if an action has been down for at least the last frames updates, up to 64.
+static inline SDL_bool action_held_for(ActionManager* action_manager, Uint32 action, int frames) {
+    return input_history_held_for(action_history_bits(action_manager, action), frames);
+}
+
+// Checks if an action was released during any of the last frames updates, up to 63.
+static inline SDL_bool action_released_within(ActionManager* action_manager, Uint32 action, int frames) {
+    return input_history_released_within(action_history_bits(action_manager, action), frames);
+}
+
+// Gets the value of an action. For 2D actions this is the x component.
+static inline float action_value(ActionManager* action_manager, Uint32 action) {
+    return action_manager->value_x[action];
+}
+
+// Gets the value of a 2D action.
+static inline void action_value_2d(ActionManager* action_manager, Uint32 action, float* x, float* y) {
+    *x = action_manager->value_x[action];
+    *y = action_manager->value_y[action];
+}
+
+// Sets how the bindings of an action are combined into its value.
+static inline void action_manager_set_value_mode(ActionManager* action_manager, Uint32 action, ActionValueMode mode) {
+    action_manager->actions[action].value_mode = mode;
+}
+
+// Sets how far an analog binding has to be pushed for it to count as down. Defaults to 0.5.
+static inline void action_manager_set_analog_threshold(ActionManager* action_manager, float threshold) {
+    action_manager->analog_threshold = threshold;
+}
+
+// Checks if a layer is enabled.
+static inline SDL_bool action_manager_layer_enabled(ActionManager* action_manager, int layer) {
+    return action_manager->layers[layer].enabled;
+}
+
+/*
+    Starts or stops collecting the stats of an <ActionManager>.
+    Starting clears the counters. Does nothing when the stats are compiled out.
+*/
+static inline void action_manager_set_stats_enabled(ActionManager* action_manager, SDL_bool enabled) {
+#if INPUT_ENABLE_STATS
+    if(enabled && !action_manager->stats.enabled) {
+        SDL_zero(action_manager->stats.total);
+        SDL_zero(action_manager->stats.frame);
+        SDL_zero(action_manager->stats.pending);
+        for(int i = 0; i < INPUT_LATENCY_DEVICE_MAX; i++)
+            SDL_zero(action_manager->latency[i]);
+    }
+    action_manager->stats.enabled = enabled;
+#else
+    (void)action_manager;
+    (void)enabled;
+#endif
+}
+
+// Gets the stats of an <ActionManager>, or NULL when the stats are compiled out.
+static inline const InputStats* action_manager_get_stats(ActionManager* action_manager) {
+#if INPUT_ENABLE_STATS
+    return &action_manager->stats;
+#else
+    (void)action_manager;
+    return NULL;
+#endif
+}
+
+/*
+    Gets the latency of the action changes caused by a kind of device, measured while the stats are enabled.
+    Each change is timed from the timestamp of the newest event behind it to the end of the update, using
+    the clock of the <InputManager> backend. Only the events passed to the manager since the update before
+    it count, and analog bindings only count when they crossed the threshold. Polled inputs are measured
+    as long as their events are passed along, and changes without an event, i.e. long presses that finish
+    from the clock, aren't measured. Returns NULL when the stats are compiled out.
+*/
+static inline const InputLatencyHistogram* action_manager_get_latency(ActionManager* action_manager, InputLatencyDevice device) {
+#if INPUT_ENABLE_STATS
+    return &action_manager->latency[device];
+#else
+    (void)action_manager;
+    (void)device;
+    return NULL;
+#endif
+}
+
+/*
+    Writes the latency of every kind of device with <input_latency_write>, one line each.
+    Returns SDL_FALSE if the stats are compiled out or the file couldn't be written.
+*/
+SDL_bool action_manager_write_latency(ActionManager* action_manager, SDL_RWops* file);
+
+// Sets a function that's called around every update, or NULL to remove it. Does nothing when the stats are compiled out.
+static inline void action_manager_set_trace_hook(ActionManager* action_manager, InputTraceHook hook, void* userdata) {
+#if INPUT_ENABLE_STATS
+    action_manager->stats.trace = hook;
+    action_manager->stats.trace_userdata = userdata;
+#else
+    (void)action_manager;
+    (void)hook;
+    (void)userdata;
+#endif
+}
+
+// Gets the ids of the combos that finished during the last update.
+static inline const int* action_manager_combo_matches(ActionManager* action_manager, int* out_count) {
+    *out_count = action_manager->combo_matcher.matched_count;
+    return action_manager->combo_matcher.matched;
+}
+
+// Checks if a combo finished during the last update.
+static inline SDL_bool action_combo_matched(ActionManager* action_manager, int combo) {
+    for(int i = 0; i < action_manager->combo_matcher.matched_count; i++) {
+        if(action_manager->combo_matcher.matched[i] == combo)
+            return SDL_TRUE;
+    }
+
+    return SDL_FALSE;
+}
+
+/*
+    Sets whether updates only evaluate the actions bound to inputs that changed (the default),
+    or every action every update.
+*/
+static inline void action_manager_set_incremental(ActionManager* action_manager, SDL_bool incremental) {
+    action_manager->incremental = incremental;
+    action_manager->masks.primed = SDL_FALSE;
 }
 
 SDL_bool action_manager_add_key(ActionManager* action_manager, Uint32 action, SDL_Scancode key);
 SDL_bool action_manager_add_mouse_button(ActionManager* action_manager, Uint32 action, MouseButton button);
 SDL_bool action_manager_add_gamepad_button(ActionManager* action_manager, Uint32 action, GamepadButton gamepad, int controller_index);
+SDL_bool action_manager_add_gesture(ActionManager* action_manager, Uint32 action, InputGesture gesture);
+
+/*
+    Binds a key or button that adds (x, y) to the value of an action while it's down,
+    i.e. one direction of a 2D action.
+*/
+SDL_bool action_manager_add_key_direction(ActionManager* action_manager, Uint32 action, SDL_Scancode key, float x, float y);
+SDL_bool action_manager_add_gamepad_button_direction(ActionManager* action_manager, Uint32 action, GamepadButton button, int controller_index, float x, float y);
+
+/*
+    Binds a gamepad axis that adds its value multiplied by (x, y) to the value of an action.
+    The value comes from <input_gamepad_axis>, so it has the deadzones and response curve applied.
+    @controller_index The player slot of the gamepad, or -1 to use the first controller plugged in.
+*/
+SDL_bool action_manager_add_gamepad_axis(ActionManager* action_manager, Uint32 action, SDL_GameControllerAxis axis, int controller_index, float x, float y);
+
+/*
+    Binds both axes of a stick to a 2D action. Each axis is multiplied by the matching scale,
+    so a negative y_scale turns the stick's down into positive y.
+    @controller_index The player slot of the gamepad, or -1 to use the first controller plugged in.
+*/
+SDL_bool action_manager_add_gamepad_stick(ActionManager* action_manager, Uint32 action, InputAxisGroup stick, int controller_index, float x_scale, float y_scale);
 void action_manager_clear_action(ActionManager* action_manager, Uint32 action);
 
+/*
+    Groups a range of actions into a layer that starts out disabled.
+    Layers can't overlap. Returns the id of the layer, or -1 if the range is invalid or memory couldn't be allocated.
+*/
+int action_manager_add_layer(ActionManager* action_manager, Uint32 first_action, Uint32 action_count, int priority, SDL_bool consume);
+
+// Enables a layer, placing it above the other enabled layers with the same priority.
+void action_manager_push_layer(ActionManager* action_manager, int layer);
+
+// Disables the most recently pushed layer that's still enabled. Returns its id, or -1 if no layer is enabled.
+int action_manager_pop_layer(ActionManager* action_manager);
+
+// Enables or disables a layer. Enabling a layer this way keeps its place from the last time it was pushed.
+void action_manager_set_layer_enabled(ActionManager* action_manager, int layer, SDL_bool enabled);
+
+/*
+    Registers a sequence of steps that's reported by <action_manager_combo_matches> on the update it finishes.
+    The steps are copied. Returns the id of the combo, or -1 if a step is invalid or memory couldn't be allocated.
+*/
+int action_manager_add_combo(ActionManager* action_manager, const ActionComboStep* steps, int step_count);
+
+// Removes every combo. Ids start from 0 again afterwards.
+void action_manager_clear_combos(ActionManager* action_manager);
+
+/*
+    Keeps the action states of at least the specified amount of updates, for <action_history_check>.
+    The history only ever grows. Returns SDL_FALSE if it couldn't be allocated.
+*/
+SDL_bool action_manager_set_history_length(ActionManager* action_manager, int frames);
+
+/*
+    Compiles the bindings of every action into per-device masks.
+    This happens automatically during <action_manager_update> after a binding changes,
+    but can be called ahead of time (i.e. after loading) to keep the cost off of the first frame.
+    If this fails, the actions are evaluated one binding at a time instead.
+*/
+SDL_bool action_manager_compile(ActionManager* action_manager);
+
 ActionManager* action_manager_create(Uint32 action_count);
+
+/*
+    Creates an <ActionManager> that makes every allocation through an allocator.
+    The allocator is copied. Pass NULL to use the default allocation methods.
+*/
+ActionManager* action_manager_create_with_allocator(Uint32 action_count, const InputAllocator* allocator);
+
+/*
+    Moves the bindings of every action into one block, in action order, so they can be read in one pass.
+    Each action then refers to its bindings by their offset in the block instead of a pointer.
+    Meant to be called once the bindings are loaded, followed by <action_manager_compile>,
+    after which updates don't allocate. Bindings added afterwards move that action back into its own array.
+    Returns SDL_FALSE if the block couldn't be allocated, leaving the bindings where they were.
+*/
+SDL_bool action_manager_pack(ActionManager* action_manager);
 void action_manager_free(ActionManager* action_manager);
 void action_manager_update(ActionManager* action_manager, InputManager* input);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef SDL_INPUT_ACTION_PROFILE_H
+#define SDL_INPUT_ACTION_PROFILE_H
+
+#include <SDL.h>
+#include "action_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    A set of bindings for every action that can be loaded into an <ActionManager> in one go,
+    i.e. the player's rebinds, and saved back out of one.
+
+    Profiles have a text form that's meant to be edited by hand:
+
+        # Anything after a hash is a comment.
+        sdl_input_profile 1
+        0 key Space
+        0 gamepad a
+        1 key A -1 0
+        1 key D 1 0
+        1 stick leftstick -1 1 -1
+        1 mode sum
+        2 mouse left+right
+        3 gamepad rightstickup 0
+        4 axis lefttrigger -1 1 0
+        5 gesture swipe_left
+
+    Each line starts with the index of an action, followed by what's bound to it:
+        key <scancode name> [x y]            Spaces in the name are written as underscores, i.e. Left_Shift.
+        mouse <button>[+<button>...]         left, middle, right, x1, x2 and scroll_left/right/up/down.
+                                             Every button has to be down, like <action_manager_add_mouse_button>.
+        gamepad <button> [index [x y]]       SDL's button names, plus the stick directions, i.e. leftstickupleft,
+                                             and lefttrigger/righttrigger[full]. The index defaults to -1.
+        gesture <gesture>                    tap, double_tap, long_press, swipe_*, pinch_in/out, rotate_[counter_]clockwise.
+        axis <axis> <index> <x> <y>          SDL's axis names.
+        stick <leftstick|rightstick|triggers> <index> <x scale> <y scale>
+        mode <max|sum>                       See <ActionValueMode>.
+    Any name can also be given as its number. Key numbers below 10 need a leading zero, i.e. 05,
+    since 0 to 9 are the names of the number keys. Keys whose name has a hash or an underscore in it,
+    or is shared with another key, are written as numbers. The x and y of buttons default to 1 and 0.
+
+    The binary form is smaller and quicker to read, and is what <action_profile_write_binary> makes.
+    <action_profile_load> accepts either.
+*/
+
+// The version written to and expected from both forms.
+#define ACTION_PROFILE_VERSION 1
+
+typedef struct ActionProfile {
+    // The bindings of every action, stored one action after another.
+    // The bindings of action n are bindings[action_offsets[n]] up to bindings[action_offsets[n + 1]].
+    InputAction* bindings;
+    int binding_count;
+    int* action_offsets;
+    ActionValueMode* value_modes;
+    Uint32 action_count;
+    InputAllocator allocator;
+} ActionProfile;
+
+/*
+    Parses the text form of a profile. The text doesn't need to be null terminated.
+    Returns NULL if it couldn't be parsed, with the line at fault in SDL_GetError.
+    @allocator Used for the profile, or NULL to use the default allocation methods.
+*/
+ActionProfile* action_profile_parse(const char* text, size_t length, const InputAllocator* allocator);
+
+// Reads the binary form of a profile. Returns NULL if it's invalid.
+ActionProfile* action_profile_decode(const void* data, size_t size, const InputAllocator* allocator);
+
+// Loads a profile in either form from a file.
+ActionProfile* action_profile_load(const char* path, const InputAllocator* allocator);
+
+// Copies the bindings of every action in an <ActionManager> into a new profile.
+ActionProfile* action_profile_from_manager(ActionManager* action_manager, const InputAllocator* allocator);
+
+void action_profile_free(ActionProfile* profile);
+
+// Writes the text form of a profile.
+SDL_bool action_profile_write_text(const ActionProfile* profile, SDL_RWops* file);
+
+// Writes the binary form of a profile.
+SDL_bool action_profile_write_binary(const ActionProfile* profile, SDL_RWops* file);
+
+/*
+    Replaces the bindings and value modes of every action with the ones in a profile,
+    then compiles them with <action_manager_compile>.
+    The bindings go into one block that's sized up front, the same as after <action_manager_pack>.
+    Actions past the end of the profile are left without bindings, and actions in the profile past
+    the end of the manager are ignored. Returns SDL_FALSE if the block couldn't be allocated,
+    leaving the bindings unchanged.
+*/
+SDL_bool action_manager_apply_profile(ActionManager* action_manager, const ActionProfile* profile);
+
+/*
+    Watches a profile file on a background thread, so it can be edited while the game is running.
+    The file is read every interval, and when its contents change it's parsed on the watcher thread.
+    The parsed profile is handed over atomically and applied with <action_profile_watcher_apply>
+    between updates, so the frame thread never waits on the file. Profiles that can't be parsed
+    are logged with SDL_LogWarn and the last good one is kept.
+*/
+typedef struct ActionProfileWatcher ActionProfileWatcher;
+
+/*
+    Starts watching a profile file. The file is read right away, and then once every interval milliseconds.
+    @allocator Used for the watcher and the profiles it parses, or NULL to use the default allocation methods.
+               Profiles are allocated on the watcher thread and freed on the thread that applies them.
+*/
+ActionProfileWatcher* action_profile_watch(const char* path, Uint32 interval, const InputAllocator* allocator);
+
+// Stops the watcher thread and frees an <ActionProfileWatcher>.
+void action_profile_watcher_free(ActionProfileWatcher* watcher);
+
+// Makes the watcher read the file now instead of waiting for the rest of the interval.
+void action_profile_watcher_check(ActionProfileWatcher* watcher);
+
+/*
+    Applies the newest profile parsed by the watcher with <action_manager_apply_profile>, if there is one.
+    Call this between updates. Returns SDL_TRUE if the bindings changed.
+*/
+SDL_bool action_profile_watcher_apply(ActionProfileWatcher* watcher, ActionManager* action_manager);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SDL_INPUT_ACTION_SNAPSHOT_H
+#define SDL_INPUT_ACTION_SNAPSHOT_H
+
+#include <SDL.h>
+#include "action_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Snapshots of the action states of an <ActionManager>, i.e. for rollback netcode.
+
+    A snapshot is a fixed size block of memory owned by the caller, <action_snapshot_size> bytes long,
+    holding the state of every action and its value quantized to 8 bits per component.
+    Snapshots have to be 8 byte aligned. The size is a multiple of 8, so an array of them, i.e. a rollback
+    ring at ring + frame * <action_snapshot_size>, stays aligned as long as the array itself is.
+    Snapshots can be bit-packed into a few bytes to send over the network, either on their own
+    or as a delta against an earlier snapshot that the receiver already has.
+
+    None of the functions allocate, so they can be run every update for every player.
+    Snapshots are only compatible between managers with the same amount of actions.
+*/
+
+// Gets the size of a snapshot of an <ActionManager>, in bytes. Always a multiple of 8.
+size_t action_snapshot_size(ActionManager* action_manager);
+
+// Gets the most bytes <action_snapshot_encode> can write for an <ActionManager>.
+size_t action_snapshot_max_encoded_size(ActionManager* action_manager);
+
+// Saves the state and value of every action as of the last update into a snapshot.
+void action_snapshot_save(ActionManager* action_manager, void* snapshot);
+
+/*
+    Restores the state and value of every action from a snapshot, as if it came from an update.
+    This doesn't rewind the history, combos or anything else that depends on earlier updates.
+    @previous The snapshot of the update before, which <action_pressed> and <action_released> compare against.
+              When NULL, the state from before the restore is used, so restoring snapshots in order works without it.
+*/
+void action_snapshot_restore(ActionManager* action_manager, const void* snapshot, const void* previous);
+
+/*
+    Bit-packs a snapshot into a buffer.
+    @base An earlier snapshot to encode the changes against, or NULL to encode everything.
+          The same snapshot has to be passed to <action_snapshot_decode>.
+    Returns the amount of bytes written, or 0 if the buffer is too small.
+*/
+size_t action_snapshot_encode(ActionManager* action_manager, const void* snapshot, const void* base, Uint8* buffer, size_t capacity);
+
+/*
+    Unpacks a snapshot written by <action_snapshot_encode>.
+    @base The snapshot the data was encoded against, or NULL if it was encoded on its own.
+    Returns SDL_FALSE if the data is corrupt or needs a base that wasn't given.
+*/
+SDL_bool action_snapshot_decode(ActionManager* action_manager, const Uint8* data, size_t size, const void* base, void* snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef SDL_INPUT_ACTION_TABLE_HPP
+#define SDL_INPUT_ACTION_TABLE_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "input_manager.h"
+#include "action_manager.h"
+
+/*
+    A C++17 front-end for actions whose default bindings are known at compile time.
+
+    The bindings are declared as a constexpr table, and <ActionTable> turns it into an update
+    that reads the bound bits straight out of the <InputManager> state. There's nothing to set up
+    or allocate, and since every binding is a constant the compiler can inline and fold the whole
+    evaluation into a handful of loads, shifts and ORs without any branches on the binding type.
+
+        enum Actions : Uint32 { ACTION_JUMP, ACTION_FIRE, ACTION_SIZE };
+
+        static constexpr sdl_input::ActionBinding<Actions> bindings[] = {
+            sdl_input::bind_key(ACTION_JUMP, SDL_SCANCODE_SPACE),
+            sdl_input::bind_gamepad(ACTION_JUMP, SDL_CONTROLLER_BUTTON_A),
+            sdl_input::bind_mouse(ACTION_FIRE, SDL_BUTTON(SDL_BUTTON_LEFT))
+        };
+
+        static sdl_input::ActionTable<Actions, ACTION_SIZE, bindings> actions;
+
+    Only digital bindings (keys, mouse buttons, gamepad buttons and gestures) can live in a table.
+    Actions that are rebound at runtime, or that need analog values, layers or combos, can be handed
+    over to a regular <ActionManager> with <ActionTable::set_override>.
+*/
+
+namespace sdl_input {
+
+enum class BindingDevice : Uint8 {
+    Key,
+    Mouse,
+    Gamepad,
+    Gesture
+};
+
+// One input bound to an action, made with the bind_* functions below.
+template<typename Action>
+struct ActionBinding {
+    Action action;
+    BindingDevice device;
+    // The scancode, mouse button mask, gamepad button or gesture, depending on the device.
+    Uint32 code;
+    // The player slot of the gamepad, or -1 for the first controller plugged in.
+    int controller_index;
+};
+
+template<typename Action>
+constexpr ActionBinding<Action> bind_key(Action action, SDL_Scancode key) {
+    return { action, BindingDevice::Key, (Uint32)key, -1 };
+}
+
+// Like <action_manager_add_mouse_button>, every button in the mask has to be down.
+template<typename Action>
+constexpr ActionBinding<Action> bind_mouse(Action action, MouseButton button) {
+    return { action, BindingDevice::Mouse, button, -1 };
+}
+
+template<typename Action>
+constexpr ActionBinding<Action> bind_gamepad(Action action, GamepadButton button, int controller_index = -1) {
+    return { action, BindingDevice::Gamepad, button, controller_index };
+}
+
+template<typename Action>
+constexpr ActionBinding<Action> bind_gesture(Action action, InputGesture gesture) {
+    return { action, BindingDevice::Gesture, (Uint32)gesture, -1 };
+}
+
+/*
+    The state of Count actions, evaluated from a constexpr array of <ActionBinding> with static storage.
+    Holds no pointers, so it can be copied freely, i.e. to keep the state of earlier frames.
+*/
+template<typename Action, Uint32 Count, const auto& Table>
+class ActionTable {
+    using TableType = std::remove_reference_t<decltype(Table)>;
+    static constexpr std::size_t binding_count = std::extent_v<TableType>;
+    static constexpr int words = INPUT_BITSET_WORDS(Count);
+
+    static_assert(std::is_same_v<std::remove_cv_t<std::remove_extent_t<TableType>>, ActionBinding<Action>>,
+                  "The binding table must be an array of ActionBinding<Action>");
+    static_assert(Count > 0, "An ActionTable needs at least one action");
+
+    static constexpr bool binding_valid(const ActionBinding<Action>& binding) {
+        if((Uint32)binding.action >= Count)
+            return false;
+
+        switch(binding.device) {
+            case BindingDevice::Key:
+                return binding.code < SDL_NUM_SCANCODES;
+            case BindingDevice::Mouse:
+                return binding.code != 0;
+            case BindingDevice::Gamepad:
+                return binding.code < INPUT_GAMEPAD_BUTTON_BITS && binding.controller_index >= -1;
+            case BindingDevice::Gesture:
+                return binding.code < INPUT_GESTURE_MAX;
+        }
+
+        return false;
+    }
+
+    static constexpr bool table_valid() {
+        for(std::size_t i = 0; i < binding_count; i++) {
+            if(!binding_valid(Table[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    static_assert(table_valid(), "A binding is out of range");
+
+    // The amount of gamepad slots read by the table. Slot 0 is the first controller (index -1),
+    // slot n is the controller at index n - 1, the same as <ActionBindingMasks>.
+    static constexpr int gamepad_slots() {
+        int slots = 0;
+        for(std::size_t i = 0; i < binding_count; i++) {
+            if(Table[i].device == BindingDevice::Gamepad && Table[i].controller_index + 2 > slots)
+                slots = Table[i].controller_index + 2;
+        }
+
+        return slots;
+    }
+
+    static constexpr bool gamepad_slot_used(int slot) {
+        for(std::size_t i = 0; i < binding_count; i++) {
+            if(Table[i].device == BindingDevice::Gamepad && Table[i].controller_index + 1 == slot)
+                return true;
+        }
+
+        return false;
+    }
+
+    static constexpr int slots = gamepad_slots();
+
+    template<std::size_t I>
+    static Uint64 binding_down(const InputManager* input, const GamepadButtonMask* pads) {
+        constexpr ActionBinding<Action> binding = Table[I];
+        if constexpr(binding.device == BindingDevice::Key)
+            return (input->keyboard_current[binding.code >> 6] >> (binding.code & 63)) & 1;
+        else if constexpr(binding.device == BindingDevice::Mouse)
+            return (input->mouse_current & binding.code) == binding.code;
+        else if constexpr(binding.device == BindingDevice::Gamepad)
+            return (pads[binding.controller_index + 1] >> binding.code) & 1;
+        else
+            return (input->gesture_current >> binding.code) & 1;
+    }
+
+    template<std::size_t... I>
+    static void evaluate(const InputManager* input, const GamepadButtonMask* pads, Uint64* state, std::index_sequence<I...>) {
+        ((state[(Uint32)Table[I].action >> 6] |= binding_down<I>(input, pads) << ((Uint32)Table[I].action & 63)), ...);
+    }
+
+    template<int... Slot>
+    static void read_gamepads(InputManager* input, GamepadButtonMask* pads, std::integer_sequence<int, Slot...>) {
+        ((pads[Slot] = gamepad_slot_used(Slot) ? gamepad_state(input, Slot - 1) : 0), ...);
+    }
+
+    static GamepadButtonMask gamepad_state(InputManager* input, int index) {
+        InputGamepad* gamepad = input_gamepad_get(input, index);
+        return gamepad ? gamepad->button_current : 0;
+    }
+
+    Uint64 current[words] = {};
+    Uint64 previous[words] = {};
+    // The actions that are read from an ActionManager instead of the table.
+    Uint64 overridden[words] = {};
+    bool has_overrides = false;
+
+public:
+    static constexpr Uint32 action_count = Count;
+
+    /*
+        Evaluates every action against the state of an <InputManager>, after <input_manager_update>.
+        When overrides is set, it's updated with <action_manager_update> and the overridden actions
+        take their state from it. It has to have at least Count actions, and shouldn't be updated separately.
+    */
+    void update(InputManager* input, ActionManager* overrides = nullptr) {
+        GamepadButtonMask pads[slots > 0 ? slots : 1] = {};
+        Uint64 state[words] = {};
+
+        read_gamepads(input, pads, std::make_integer_sequence<int, slots>{});
+        evaluate(input, pads, state, std::make_index_sequence<binding_count>{});
+
+        if(overrides)
+            action_manager_update(overrides, input);
+
+        for(int word = 0; word < words; word++) {
+            previous[word] = current[word];
+            if(overrides && has_overrides)
+                state[word] = (state[word] & ~overridden[word]) | (overrides->current[word] & overridden[word]);
+            current[word] = state[word];
+        }
+    }
+
+    /*
+        Hands an action over to the <ActionManager> passed to <update>, i.e. once the player rebinds it.
+        The default bindings of the action are ignored until the override is removed.
+    */
+    void set_override(Action action, bool enabled) {
+        if(enabled)
+            input_bitset_set(overridden, (int)action);
+        else
+            input_bitset_clear(overridden, (int)action);
+
+        has_overrides = false;
+        for(int word = 0; word < words; word++)
+            has_overrides |= overridden[word] != 0;
+    }
+
+    bool overridden_by_manager(Action action) const {
+        return input_bitset_test(overridden, (int)action);
+    }
+
+    // Adds the default bindings of an action to an <ActionManager>, i.e. to start a rebind from the defaults.
+    static SDL_bool add_defaults(ActionManager* action_manager, Action action) {
+        for(std::size_t i = 0; i < binding_count; i++) {
+            const ActionBinding<Action>& binding = Table[i];
+            if(binding.action != action)
+                continue;
+
+            SDL_bool added = SDL_FALSE;
+            switch(binding.device) {
+                case BindingDevice::Key:
+                    added = action_manager_add_key(action_manager, (Uint32)action, (SDL_Scancode)binding.code);
+                    break;
+                case BindingDevice::Mouse:
+                    added = action_manager_add_mouse_button(action_manager, (Uint32)action, binding.code);
+                    break;
+                case BindingDevice::Gamepad:
+                    added = action_manager_add_gamepad_button(action_manager, (Uint32)action, binding.code, binding.controller_index);
+                    break;
+                case BindingDevice::Gesture:
+                    added = action_manager_add_gesture(action_manager, (Uint32)action, (InputGesture)binding.code);
+                    break;
+            }
+
+            if(!added)
+                return SDL_FALSE;
+        }
+
+        return SDL_TRUE;
+    }
+
+    bool check(Action action) const {
+        return input_bitset_test(current, (int)action);
+    }
+
+    bool pressed(Action action) const {
+        return input_bitset_test(current, (int)action) && !input_bitset_test(previous, (int)action);
+    }
+
+    bool released(Action action) const {
+        return !input_bitset_test(current, (int)action) && input_bitset_test(previous, (int)action);
+    }
+
+    // The state of every action packed into one bit per action, laid out like <ActionManager::current>.
+    const Uint64* state() const {
+        return current;
+    }
+};
+
+} // namespace sdl_input
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SDL_INPUT_INPUT_ALLOCATOR_H
+#define SDL_INPUT_INPUT_ALLOCATOR_H
+
+#include <SDL.h>
+
+/*
+    An allocator that can be given to a manager when it's created, i.e. to place its
+    state in a frame arena. Every allocation the manager makes goes through it.
+
+    Either all of the functions are set, or alloc is NULL to use the input_* allocation
+    methods from when the library was compiled.
+*/
+typedef struct InputAllocator {
+    // Passed to every function.
+    void* ctx;
+    void* (*alloc)(void* ctx, size_t size);
+    void* (*realloc)(void* ctx, void* ptr, size_t size);
+    void (*free)(void* ctx, void* ptr);
+} InputAllocator;
+
+#endif
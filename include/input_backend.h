@@ -0,0 +1,35 @@
+#ifndef SDL_INPUT_INPUT_BACKEND_H
+#define SDL_INPUT_INPUT_BACKEND_H
+
+#include <SDL.h>
+
+/*
+    Where an <InputManager> reads the device state from. SDL is used by default.
+
+    Any of the functions can be NULL, in which case the matching state is only built
+    from events and the input_manager_set_* functions, as if the matching <InputManagerFlags>
+    were set. A backend with every function NULL is fully virtual: it doesn't need SDL to be
+    initialized, and many managers using it can be updated from any thread at once.
+*/
+typedef struct InputBackend {
+    // Passed to every function.
+    void* ctx;
+    // Called when a manager is created. Returns SDL_FALSE if the backend can't be used.
+    SDL_bool (*init)(void* ctx);
+    // The current time in milliseconds, used for gestures that finish without any events.
+    // When NULL, the timestamp of the newest touch event is used instead.
+    Uint32 (*get_ticks)(void* ctx);
+    // Fills in one bit per scancode.
+    void (*get_keyboard)(void* ctx, Uint64* keys, int words);
+    // Returns the mouse buttons and fills in the position.
+    Uint32 (*get_mouse)(void* ctx, int* x, int* y);
+    // Fills in the buttons and axes of a controller returned by open_gamepad.
+    void (*get_gamepad)(void* ctx, SDL_GameController* controller, Uint32* buttons, Sint16* axes);
+    // Opens the controller at the device index of an added event. Returns NULL if it can't be opened.
+    SDL_GameController* (*open_gamepad)(void* ctx, int device_index, SDL_JoystickID* instance_id);
+    void (*close_gamepad)(void* ctx, SDL_GameController* controller);
+    // Turns relative mouse mode on or off. Returns SDL_FALSE if it couldn't be changed.
+    SDL_bool (*set_mouse_relative)(void* ctx, SDL_bool enabled);
+} InputBackend;
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef SDL_INPUT_INPUT_BATCH_H
+#define SDL_INPUT_INPUT_BATCH_H
+
+#include <SDL.h>
+#include "input_manager.h"
+#include "action_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Updates many <InputManager> and <ActionManager> pairs at once, i.e. for bots or simulations
+    that drive thousands of virtual players through the same bindings.
+
+    The pairs are split into chunks that the calling thread and a fixed set of worker threads
+    take turns claiming, so uneven pairs still balance out. Every manager should use a backend
+    that doesn't read from SDL, see <input_backend_virtual>, which also means SDL doesn't have
+    to be initialized.
+*/
+
+// When compiling, can be used to change the amount of pairs a thread claims at a time.
+#ifndef INPUT_BATCH_CHUNK
+#define INPUT_BATCH_CHUNK 64
+#endif
+
+typedef struct InputBatch {
+    SDL_Thread** threads;
+    int thread_count;
+    SDL_mutex* lock;
+    // Signalled when a new update starts, and when the last worker finishes it.
+    SDL_cond* start;
+    SDL_cond* done;
+    // Changes every update, so the workers can tell a new update from a spurious wakeup.
+    Uint32 generation;
+    // The amount of workers still working on the current update.
+    int running;
+    SDL_bool quit;
+    // The current update.
+    InputManager** inputs;
+    ActionManager** actions;
+    int count;
+    // The first pair that hasn't been claimed yet.
+    SDL_atomic_t next;
+    InputAllocator allocator;
+} InputBatch;
+
+/*
+    Creates a new <InputBatch>.
+    @threads The amount of worker threads to start, on top of the thread calling <input_batch_update>.
+             Pass 0 to do all of the work on the calling thread.
+    @allocator Used for the batch itself, or NULL to use the default allocation methods.
+*/
+InputBatch* input_batch_create(int threads, const InputAllocator* allocator);
+
+// Stops the worker threads and frees an <InputBatch>.
+void input_batch_free(InputBatch* batch);
+
+/*
+    Runs <input_manager_update> and then <action_manager_update> for every pair, returning once all of them are done.
+    Only one update can run on a batch at a time.
+    @actions The action manager to update with each input manager. Can be NULL, as can any of its entries.
+*/
+void input_batch_update(InputBatch* batch, InputManager** inputs, ActionManager** actions, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef SDL_INPUT_INPUT_BITS_H
+#define SDL_INPUT_INPUT_BITS_H
+
+#include <SDL.h>
+
+/*
+    Small helpers for the packed bitsets used to store input state.
+    A bitset is an array of Uint64 words, where bit n lives in word n / 64.
+*/
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Gets the amount of words needed to store the specified amount of bits.
+#define INPUT_BITSET_WORDS(bits) (((bits) + 63) / 64)
+
+// Checks if a bit is set in a bitset.
+static inline SDL_bool input_bitset_test(const Uint64* set, int bit) {
+    return (SDL_bool)((set[bit >> 6] >> (bit & 63)) & 1);
+}
+
+static inline void input_bitset_set(Uint64* set, int bit) {
+    set[bit >> 6] |= (Uint64)1 << (bit & 63);
+}
+
+static inline void input_bitset_clear(Uint64* set, int bit) {
+    set[bit >> 6] &= ~((Uint64)1 << (bit & 63));
+}
+
+// Gets the index of the lowest set bit. The value must not be 0.
+static inline int input_bits_lowest(Uint64 value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#else
+    int index = 0;
+    while(!(value & 1)) {
+        value >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// Counts the amount of set bits.
+static inline int input_bits_count(Uint64 value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(value);
+#else
+    value = value - ((value >> 1) & 0x5555555555555555ull);
+    value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+    value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (int)((value * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/*
+    Finds the first set bit in a bitset at or after start.
+    Returns -1 if there are no more set bits.
+
+    @words The amount of words in the bitset.
+*/
+static inline int input_bitset_next(const Uint64* set, int words, int start) {
+    int word = start >> 6;
+    if(word >= words)
+        return -1;
+
+    Uint64 bits = set[word] & (~(Uint64)0 << (start & 63));
+    while(!bits) {
+        if(++word == words)
+            return -1;
+        bits = set[word];
+    }
+
+    return (word << 6) + input_bits_lowest(bits);
+}
+
+/*
+    Shift register histories of a single button. Bit n is the state of the button
+    n updates ago, so bit 0 is the latest update.
+
+    Histories are only written when the button changes. The frame they were written
+    on is kept alongside, and the bits are shifted up to the current frame when read,
+    repeating the last known state.
+*/
+
+// Gets the history of a button as of the specified frame.
+static inline Uint64 input_history_bits(Uint64 history, Uint32 history_frame, Uint32 frame) {
+    Uint32 age = frame - history_frame;
+    if(age == 0)
+        return history;
+
+    Uint64 fill = (history & 1) ? ~(Uint64)0 : 0;
+    if(age >= 64)
+        return fill;
+
+    return (history << age) | (fill >> (64 - age));
+}
+
+// Records the state of a button that changed on the specified frame.
+static inline void input_history_push(Uint64* history, Uint32* history_frame, Uint32 frame, SDL_bool down) {
+    *history = (input_history_bits(*history, *history_frame, frame - 1) << 1) | (down ? 1 : 0);
+    *history_frame = frame;
+}
+
+// Gets a mask of the last frames updates of a history.
+static inline Uint64 input_history_mask(int frames) {
+    if(frames <= 0)
+        return 0;
+    if(frames >= 64)
+        return ~(Uint64)0;
+    return ((Uint64)1 << frames) - 1;
+}
+
+// Gets the state of the button one update before each bit of a history.
+// The update before the oldest bit isn't known, so it's treated as unchanged.
+static inline Uint64 input_history_before(Uint64 bits) {
+    return (bits >> 1) | (bits & ((Uint64)1 << 63));
+}
+
+// Checks if the button went down during any of the last frames updates. At most 63 updates can be checked.
+static inline SDL_bool input_history_pressed_within(Uint64 bits, int frames) {
+    return (SDL_bool)((bits & ~input_history_before(bits) & input_history_mask(frames)) != 0);
+}
+
+// Checks if the button went up during any of the last frames updates. At most 63 updates can be checked.
+static inline SDL_bool input_history_released_within(Uint64 bits, int frames) {
+    return (SDL_bool)((~bits & input_history_before(bits) & input_history_mask(frames)) != 0);
+}
+
+// Checks if the button has been down for at least the last frames updates. At most 64 updates can be checked.
+static inline SDL_bool input_history_held_for(Uint64 bits, int frames) {
+    Uint64 mask = input_history_mask(frames);
+    return (SDL_bool)(frames > 0 && frames <= 64 && (bits & mask) == mask);
+}
+
+// Counts how many times the button went down during the last frames updates.
+static inline int input_history_press_count(Uint64 bits, int frames) {
+    return input_bits_count(bits & ~input_history_before(bits) & input_history_mask(frames));
+}
+
+#endif
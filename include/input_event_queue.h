@@ -0,0 +1,140 @@
+#ifndef SDL_INPUT_INPUT_EVENT_QUEUE_H
+#define SDL_INPUT_INPUT_EVENT_QUEUE_H
+
+#include <SDL.h>
+#include "input_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    A single-producer/single-consumer lock-free queue of input events.
+
+    The thread that polls SDL events pushes into the queue, and a simulation
+    thread drains it into its own <InputManager> once per tick. Events carry
+    their SDL timestamp, so each tick only applies the events that happened
+    before it. The simulation's <InputManager> should use <INPUT_MANAGER_ALL_EVENTS>,
+    so presses shorter than a tick are still seen for one tick and SDL is never
+    read from the simulation thread.
+
+    Controllers are opened and closed by <input_event_queue_push_sdl> on the producer
+    thread. The simulation only sees gamepads without a controller, like the ones from
+    <input_manager_add_virtual_gamepad>, whose state comes from the queued events.
+*/
+
+typedef enum InputEventType {
+    INPUT_EVENT_KEY,
+    INPUT_EVENT_MOUSE_BUTTON,
+    INPUT_EVENT_MOUSE_MOTION,
+    INPUT_EVENT_MOUSE_WHEEL,
+    INPUT_EVENT_GAMEPAD_BUTTON,
+    INPUT_EVENT_GAMEPAD_AXIS,
+    INPUT_EVENT_GAMEPAD_ADDED,
+    INPUT_EVENT_GAMEPAD_REMOVED,
+    INPUT_EVENT_TOUCH,
+    // A controller that the <InputManager> opens or closes itself, like <input_manager_controller_event>.
+    // Down is set when it's added, in which case which is the device index.
+    INPUT_EVENT_CONTROLLER_DEVICE
+} InputEventType;
+
+/*
+    An input event reduced to the values the <InputManager> uses.
+*/
+typedef struct InputEvent {
+    // The SDL event timestamp in milliseconds.
+    Uint32 timestamp;
+    Uint8 type;
+    Uint8 down;
+    // The scancode, button, or axis.
+    Uint16 code;
+    // The joystick instance id for gamepad events, except <INPUT_EVENT_CONTROLLER_DEVICE>.
+    Sint32 which;
+    union {
+        struct {
+            // Mouse position, or the wheel amount with the direction already applied.
+            SDL_Point point;
+            // The relative motion of a mouse motion event.
+            SDL_Point delta;
+        };
+        Sint16 axis;
+        SDL_TouchFingerEvent touch;
+    };
+} InputEvent;
+
+// A controller opened by the producer of an <InputEventQueue>.
+typedef struct InputQueueController {
+    SDL_GameController* controller;
+    SDL_JoystickID instance_id;
+} InputQueueController;
+
+typedef struct InputEventQueue {
+    InputEvent* events;
+    Uint32 mask;
+    Uint32 dropped;
+    // Only used by the producer, to close the controllers it opened when they're removed.
+    InputQueueController* controllers;
+    int controller_count;
+    int controller_capacity;
+    // The head is only written by the consumer, and the tail only by the producer.
+    // They're kept on separate cache lines so the threads don't contend.
+    Uint8 padding0[64];
+    SDL_atomic_t head;
+    Uint8 padding1[64];
+    SDL_atomic_t tail;
+    Uint8 padding2[64];
+} InputEventQueue;
+
+/*
+    Creates a new <InputEventQueue>.
+    @capacity The maximum amount of events waiting in the queue. Rounded up to a power of two.
+*/
+InputEventQueue* input_event_queue_create(Uint32 capacity);
+
+// Frees an <InputEventQueue>, closing the controllers opened by <input_event_queue_push_sdl>.
+void input_event_queue_free(InputEventQueue* queue);
+
+/*
+    Adds an event to the queue. Only call this from the producer thread.
+    Returns SDL_FALSE if the queue is full, in which case the event is dropped.
+*/
+SDL_bool input_event_queue_push(InputEventQueue* queue, const InputEvent* event);
+
+/*
+    Converts an SDL event and adds it to the queue. Only call this from the producer thread.
+    Controllers are opened here when they're added, followed by events for their current state,
+    and closed again when they're removed.
+    Returns SDL_FALSE if the event isn't an input event, the controller couldn't be opened, or the queue is full.
+*/
+SDL_bool input_event_queue_push_sdl(InputEventQueue* queue, const SDL_Event* event);
+
+/*
+    Removes the oldest event from the queue. Only call this from the consumer thread.
+    Returns SDL_FALSE if the queue is empty.
+*/
+SDL_bool input_event_queue_pop(InputEventQueue* queue, InputEvent* event);
+
+/*
+    Applies a single event to an <InputManager>, the same way the matching input_manager_*_event function would.
+    Added and removed gamepads are the exception: they add and remove a gamepad without a controller,
+    since the controller is kept open by the producer.
+*/
+void input_manager_apply_event(InputManager* input, const InputEvent* event);
+
+/*
+    Applies every queued event with a timestamp at or before the specified time to an <InputManager>.
+    Call this before <input_manager_update> on the consumer thread.
+    Returns the amount of events applied.
+*/
+int input_event_queue_drain(InputEventQueue* queue, InputManager* input, Uint32 until);
+
+// Gets the amount of events that were dropped because the queue was full.
+static inline Uint32 input_event_queue_dropped(InputEventQueue* queue) {
+    return queue->dropped;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
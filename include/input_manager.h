@@ -2,16 +2,30 @@
 #define SDL_INPUT_INPUT_MANAGER_H
 
 #include <SDL.h>
+#include "input_allocator.h"
+#include "input_backend.h"
+#include "input_bits.h"
+#include "input_stats.h"
+#include "input_touch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
-// When compiling, can be used to change the amount of
-// gamepads that can be detected by the gamepad manager.
-// Rarely does this need to be > 4, but if you want a massive
-// local co-op game like 16 player Halo LAN games, it can be increased
-// accordingly.
+// When compiling, can be used to change the amount of gamepads
+// space is reserved for when an <InputManager> is created.
+// More gamepads than this can still be connected, the gamepad table
+// just grows to fit them. See <input_manager_reserve_gamepads>.
 #ifndef INPUT_MAX_GAMEPADS
 #define INPUT_MAX_GAMEPADS 4
 #endif
 
+// When compiling, can be used to change the amount of mouse motion samples
+// kept per update when <INPUT_MANAGER_MOUSE_SAMPLES> is set.
+#ifndef INPUT_MAX_MOUSE_SAMPLES
+#define INPUT_MAX_MOUSE_SAMPLES 32
+#endif
+
 /*
     Defines some extra values to allow specific stick directions to be
     used like other controller buttons by the input manager.
@@ -28,6 +42,18 @@ typedef enum SDL_GameControllerButtonExtension {
     SDL_CONTROLLER_BUTTON_RIGHTSTICKRIGHT,
     SDL_CONTROLLER_BUTTON_LEFTTRIGGER,
     SDL_CONTROLLER_BUTTON_RIGHTTRIGGER,
+    // Stick diagonals are down while both of their directions are.
+    SDL_CONTROLLER_BUTTON_LEFTSTICKUPLEFT,
+    SDL_CONTROLLER_BUTTON_LEFTSTICKUPRIGHT,
+    SDL_CONTROLLER_BUTTON_LEFTSTICKDOWNLEFT,
+    SDL_CONTROLLER_BUTTON_LEFTSTICKDOWNRIGHT,
+    SDL_CONTROLLER_BUTTON_RIGHTSTICKUPLEFT,
+    SDL_CONTROLLER_BUTTON_RIGHTSTICKUPRIGHT,
+    SDL_CONTROLLER_BUTTON_RIGHTSTICKDOWNLEFT,
+    SDL_CONTROLLER_BUTTON_RIGHTSTICKDOWNRIGHT,
+    // Down while a trigger is pulled past the full press threshold, see <input_gamepad_set_trigger_threshold>.
+    SDL_CONTROLLER_BUTTON_LEFTTRIGGERFULL,
+    SDL_CONTROLLER_BUTTON_RIGHTTRIGGERFULL,
     SDL_CONTROLLER_BUTTON_EXTENSION_MAX
 } SDL_GameControllerButtonExtension;
 
@@ -52,29 +78,187 @@ typedef Uint32 MouseButton;
 */
 typedef Uint32 GamepadButton;
 
+/*
+    Represents a set of gamepad buttons, one bit per button. Wide enough for every
+    SDL button (including the paddles, touchpad and misc buttons) and every extension.
+*/
+typedef Uint64 GamepadButtonMask;
+
 /*
     Represents a gamepad stick or trigger value.
 */
 typedef Uint16 GamepadAxis;
 
+// When compiling, can be used to change the amount of events <input_manager_poll_events> reads from SDL at a time.
+#ifndef INPUT_EVENT_BATCH
+#define INPUT_EVENT_BATCH 128
+#endif
+
+// When compiling, can be used to change the amount of events from other threads <input_manager_watch_events> holds on to between updates.
+#ifndef INPUT_WATCH_QUEUE_SIZE
+#define INPUT_WATCH_QUEUE_SIZE 256
+#endif
+
+// The amount of real mouse buttons that presses are counted for, see <input_mouse_press_count>.
+#define INPUT_MOUSE_BUTTONS SDL_BUTTON_X2
+
+// A single mouse motion event.
+typedef struct InputMouseSample {
+    // The SDL event timestamp in milliseconds.
+    Uint32 timestamp;
+    SDL_Point position;
+    SDL_Point delta;
+} InputMouseSample;
+
+// The amount of words needed to store one bit per key.
+#define INPUT_KEYBOARD_WORDS INPUT_BITSET_WORDS(SDL_NUM_SCANCODES)
+
+// The amount of buttons that fit in a <GamepadButtonMask>, including the ones made from axes.
+#define INPUT_GAMEPAD_BUTTON_BITS (sizeof(GamepadButtonMask) * 8)
+
+SDL_COMPILE_TIME_ASSERT(gamepad_button_bits, SDL_CONTROLLER_BUTTON_EXTENSION_MAX <= INPUT_GAMEPAD_BUTTON_BITS);
+
 typedef struct InputGamepad {
     SDL_GameController* controller;
-    GamepadButton button_current;
-    GamepadButton button_previous;
+    SDL_JoystickID instance_id;
+    // The player slot of the gamepad. This stays the same for as long as the gamepad is connected.
+    int slot;
+    GamepadButtonMask button_current;
+    GamepadButtonMask button_previous;
+    // Buttons that went down/up during the last update.
+    GamepadButtonMask button_pressed;
+    GamepadButtonMask button_released;
+    // The raw button and axis state, either polled from SDL during the update
+    // or cached from controller events, depending on the <InputManager> flags.
+    GamepadButtonMask button_state;
+    // Buttons that went down since the last update, so presses shorter than an update aren't lost.
+    GamepadButtonMask button_taps;
+    Sint16 axes[SDL_CONTROLLER_AXIS_MAX];
     SDL_bool active;
+    // The history of each button, see <input_history_bits>.
+    Uint64 button_history[INPUT_GAMEPAD_BUTTON_BITS];
+    Uint32 button_history_frames[INPUT_GAMEPAD_BUTTON_BITS];
+    // The buttons as of the last time the history was written.
+    GamepadButtonMask button_history_state;
+#if INPUT_ENABLE_STATS
+    // The timestamp of the newest event for each button and axis since the last update.
+    Uint32 button_event_times[SDL_CONTROLLER_BUTTON_MAX];
+    Uint32 axis_event_times[SDL_CONTROLLER_AXIS_MAX];
+    // The event timestamps handed to the last update, used to measure latency. 0 when there wasn't an event.
+    Uint32 button_times[SDL_CONTROLLER_BUTTON_MAX];
+    Uint32 axis_times[SDL_CONTROLLER_AXIS_MAX];
+    // The axis values of the update before the last one, so analog bindings can tell when they crossed the threshold.
+    float axis_values_previous[SDL_CONTROLLER_AXIS_MAX];
+#endif
 } InputGamepad;
 
+// The shape of the response curve applied to an axis once it's outside of the deadzone.
+typedef enum InputAxisCurve {
+    INPUT_AXIS_CURVE_LINEAR,
+    INPUT_AXIS_CURVE_QUADRATIC,
+    INPUT_AXIS_CURVE_CUBIC,
+    // Raises the value to <InputAxisSettings>.exponent.
+    INPUT_AXIS_CURVE_POWER
+} InputAxisCurve;
+
+// The axes that share <InputAxisSettings>.
+typedef enum InputAxisGroup {
+    INPUT_AXIS_GROUP_LEFT_STICK,
+    INPUT_AXIS_GROUP_RIGHT_STICK,
+    INPUT_AXIS_GROUP_TRIGGERS,
+    INPUT_AXIS_GROUP_MAX
+} InputAxisGroup;
+
+/*
+    Controls how raw axis values are turned into the normalized values
+    returned by <input_gamepad_axis>. All of the magnitudes are in the range [0, 1].
+*/
+typedef struct InputAxisSettings {
+    // Magnitudes at or below this are reported as 0.
+    float deadzone;
+    // Magnitudes at or above this are reported as 1.
+    float outer_deadzone;
+    // The smallest magnitude reported once the axis leaves the deadzone.
+    // Used to cancel out a deadzone the game applies on its own.
+    float anti_deadzone;
+    InputAxisCurve curve;
+    // The exponent used by <INPUT_AXIS_CURVE_POWER>.
+    float exponent;
+    // Determines if a stick deadzone uses the length of the stick instead of each axis separately.
+    // Ignored for triggers.
+    SDL_bool radial;
+} InputAxisSettings;
+
+// An entry in the table used to find a gamepad by its joystick instance id.
+typedef struct InputGamepadLookup {
+    SDL_JoystickID instance_id;
+    // The index into <InputManager>.gamepads, or -1 if the entry is empty.
+    int index;
+} InputGamepadLookup;
+
+/*
+    Flags that change how an <InputManager> gathers its state.
+
+    Whichever way the state is gathered, every button, key and mouse button press passed to the
+    manager is also kept as a tap until the next update. Taps are added to the state of that update,
+    so a press that's released again before the update still shows up as down for one update, even
+    when the state itself is polled.
+*/
+typedef enum InputManagerFlags {
+    // Gamepad buttons and axes are taken from the events passed to
+    // <input_manager_controller_button_event> and <input_manager_controller_axis_event>
+    // instead of being polled from SDL every update.
+    INPUT_MANAGER_GAMEPAD_EVENTS = 1 << 0,
+    // The keyboard state is taken from the events passed to <input_manager_key_event>
+    // instead of SDL_GetKeyboardState.
+    INPUT_MANAGER_KEYBOARD_EVENTS = 1 << 1,
+    // The mouse buttons and position are taken from the events passed to <input_manager_mouse_button_event>
+    // and <input_manager_mouse_motion_event> instead of SDL_GetMouseState.
+    INPUT_MANAGER_MOUSE_EVENTS = 1 << 2,
+    // Every mouse motion event during an update is kept, see <input_mouse_samples>.
+    INPUT_MANAGER_MOUSE_SAMPLES = 1 << 3,
+    // Nothing is read from the backend directly. This is required when updating from a thread other than the main thread.
+    INPUT_MANAGER_ALL_EVENTS = INPUT_MANAGER_GAMEPAD_EVENTS | INPUT_MANAGER_KEYBOARD_EVENTS | INPUT_MANAGER_MOUSE_EVENTS
+} InputManagerFlags;
+
 typedef struct InputManager {
     MouseButton mouse_current;
     MouseButton mouse_previous;
     SDL_Point mouse_position_current;
     SDL_Point mouse_position_previous;
-    const Uint8* keyboard_current;
-    const Uint8* keyboard_previous;
-    InputGamepad gamepads[INPUT_MAX_GAMEPADS];
-    unsigned int controllers[INPUT_MAX_GAMEPADS];
-    unsigned int controller_count;
+    // Keyboard state packed into one bit per scancode.
+    Uint64 keyboard_current[INPUT_KEYBOARD_WORDS];
+    Uint64 keyboard_previous[INPUT_KEYBOARD_WORDS];
+    // Keys that went down/up during the last update.
+    Uint64 keyboard_pressed[INPUT_KEYBOARD_WORDS];
+    Uint64 keyboard_released[INPUT_KEYBOARD_WORDS];
+    // The history of each key, see <input_history_bits>.
+    Uint64 keyboard_history[SDL_NUM_SCANCODES];
+    Uint32 keyboard_history_frames[SDL_NUM_SCANCODES];
+    // The amount of updates so far.
+    Uint32 frame;
+    // The connected gamepads, densely packed. The order changes when a gamepad is removed,
+    // so gamepads should be referred to by slot or instance id rather than by pointer.
+    InputGamepad* gamepads;
+    int gamepad_count;
+    int gamepad_capacity;
+    // Maps each player slot to an index into gamepads, or -1 if the slot is empty.
+    int* gamepad_slots;
+    int gamepad_slot_capacity;
+    // The lowest slot with a gamepad in it, or -1 if there are none.
+    int gamepad_first_slot;
+    // Open addressing hash table from instance id to gamepad. The capacity is a power of two.
+    InputGamepadLookup* gamepad_lookup;
+    int gamepad_lookup_capacity;
+    // Axis values after the deadzones and response curves are applied, stored one axis at a time
+    // so each one can be processed for every gamepad at once. The value of an axis for
+    // gamepads[i] is at [axis * gamepad_capacity + i]. The rows after the last axis are scratch space.
+    float* gamepad_axis_values;
+    InputAxisSettings axis_settings[INPUT_AXIS_GROUP_MAX];
     GamepadAxis deadzone;
+    // How far a trigger has to be pulled for its full press button.
+    GamepadAxis trigger_threshold;
+    Uint32 flags;
     SDL_TouchFingerEvent* touch_previous;
     SDL_TouchFingerEvent* touch_current;
     unsigned int touch_current_count;
@@ -82,49 +266,124 @@ typedef struct InputManager {
     unsigned int touch_previous_count;
     unsigned int touch_previous_capacity;
     unsigned int touch_event_poll_count;
+    // The fingers that are down, or were lifted during the last update, densely packed.
+    InputFinger fingers[INPUT_MAX_FINGERS];
+    int finger_count;
+    InputGestureState gesture;
+    InputGestureSettings gesture_settings;
+    GestureMask gesture_current;
+    GestureMask gesture_previous;
     int mouse_wheel_x;
     int mouse_wheel_y;
     int mouse_poll_scroll_x;
     int mouse_poll_scroll_y;
+    // The relative mouse motion during the last update, and since the last update.
+    // Always built from motion events, so it keeps working in relative mouse mode.
+    SDL_Point mouse_delta;
+    SDL_Point mouse_poll_delta;
+    // The amount of times each button went down during the last update, and since the last update.
+    Uint8 mouse_presses[INPUT_MOUSE_BUTTONS];
+    Uint8 mouse_poll_presses[INPUT_MOUSE_BUTTONS];
+    // The motion events from the last update, and since the last update, when <INPUT_MANAGER_MOUSE_SAMPLES> is set.
+    InputMouseSample mouse_samples[INPUT_MAX_MOUSE_SAMPLES];
+    InputMouseSample mouse_poll_samples[INPUT_MAX_MOUSE_SAMPLES];
+    int mouse_sample_count;
+    int mouse_poll_sample_count;
+    // The state built from events when the matching <InputManagerFlags> are set.
+    // Taps hold everything that went down since the last update, so a press and release
+    // between two updates still shows up as down for one update, in either mode.
+    Uint64 keyboard_state[INPUT_KEYBOARD_WORDS];
+    Uint64 keyboard_taps[INPUT_KEYBOARD_WORDS];
+    MouseButton mouse_state;
+    MouseButton mouse_taps;
+    SDL_Point mouse_position_state;
+    // Used for every allocation made by the manager.
+    InputAllocator allocator;
+    // Where the device state is read from.
+    InputBackend backend;
+    // Set while the manager is registered with SDL_AddEventWatch, see <input_manager_watch_events>.
+    SDL_bool watching;
+    // The thread that registered the watch, and the events the watch saw on any other thread.
+    SDL_threadID watch_thread;
+    struct InputEventQueue* watch_queue;
+#if INPUT_ENABLE_STATS
+    InputStats stats;
+    // The timestamp of the newest event for each key and mouse button since the last update.
+    Uint32 keyboard_event_times[SDL_NUM_SCANCODES];
+    Uint32 mouse_event_times[sizeof(MouseButton) * 8];
+    // The event timestamps handed to the last update, used to measure latency. 0 when there wasn't an event.
+    Uint32 keyboard_times[SDL_NUM_SCANCODES];
+    Uint32 mouse_times[sizeof(MouseButton) * 8];
+#endif
 } InputManager;
 
-#define ___INPUT_GAMEPAD_BUTTON(x) (1 << (x))
+#define ___INPUT_GAMEPAD_BUTTON(x) ((GamepadButtonMask)1 << (x))
 
 // Checks if the specified key is currently down.
 static inline SDL_bool input_key_check(InputManager* input, SDL_Scancode key) {
-    return input->keyboard_current[key] == 1;
+    return input_bitset_test(input->keyboard_current, key);
 }
 
 // Checks if the specified key was just pressed during the last update.
 static inline SDL_bool input_key_pressed(InputManager* input, SDL_Scancode key) {
-    return input->keyboard_current[key] == 1 && input->keyboard_previous[key] == 0;
+    return input_bitset_test(input->keyboard_pressed, key);
 }
 
 // Checks if the specified key was just released during the last update.
 static inline SDL_bool input_key_released(InputManager* input, SDL_Scancode key) {
-    return input->keyboard_current[key] == 0 && input->keyboard_previous[key] == 1;
+    return input_bitset_test(input->keyboard_released, key);
+}
+
+// Checks if the specified key went down during any of the last frames updates, up to 63.
+static inline SDL_bool input_key_pressed_within(InputManager* input, SDL_Scancode key, int frames) {
+    return input_history_pressed_within(input_history_bits(input->keyboard_history[key], input->keyboard_history_frames[key], input->frame), frames);
+}
+
+// Checks if the specified key has been down for at least the last frames updates, up to 64.
+static inline SDL_bool input_key_held_for(InputManager* input, SDL_Scancode key, int frames) {
+    return input_history_held_for(input_history_bits(input->keyboard_history[key], input->keyboard_history_frames[key], input->frame), frames);
+}
+
+// Checks if the specified key went up during any of the last frames updates, up to 63.
+static inline SDL_bool input_key_released_within(InputManager* input, SDL_Scancode key, int frames) {
+    return input_history_released_within(input_history_bits(input->keyboard_history[key], input->keyboard_history_frames[key], input->frame), frames);
+}
+
+/*
+    Gets the next key at or after start that was pressed during the last update,
+    or -1 if there are no more. Can be used to visit every pressed key like so:
+
+    for(int key = input_key_next_pressed(input, 0); key != -1; key = input_key_next_pressed(input, key + 1))
+*/
+static inline int input_key_next_pressed(InputManager* input, int start) {
+    return input_bitset_next(input->keyboard_pressed, INPUT_KEYBOARD_WORDS, start);
+}
+
+// Gets the next key at or after start that was released during the last update, or -1 if there are no more.
+static inline int input_key_next_released(InputManager* input, int start) {
+    return input_bitset_next(input->keyboard_released, INPUT_KEYBOARD_WORDS, start);
 }
 
 // Checks if the specified button is currently down.
 static inline SDL_bool input_mouse_check(InputManager* input, MouseButton button) {
-    return (input->mouse_current & button) == button;
+    return (SDL_bool)((input->mouse_current & button) == button);
 }
 
 
 // Checks if the specified button was just pressed during the last update.
 static inline SDL_bool input_mouse_pressed(InputManager* input, MouseButton button) {
-    return ((input->mouse_current & button) == button) && ((input->mouse_previous & button) != button);
+    return (SDL_bool)(((input->mouse_current & button) == button) && ((input->mouse_previous & button) != button));
 }
 
 // Checks if the specified button was just released during the last update.
 static inline SDL_bool input_mouse_released(InputManager* input, MouseButton button) {
-    return ((input->mouse_current & button) != button) && ((input->mouse_previous & button) == button);
+    return (SDL_bool)(((input->mouse_current & button) != button) && ((input->mouse_previous & button) == button));
 }
 
 // Determines if the mouse moved at all during the last update.
 static inline SDL_bool input_mouse_moved(InputManager* input) {
-    return input->mouse_position_current.x != input->mouse_position_previous.x ||
-           input->mouse_position_current.y != input->mouse_position_previous.y;
+    return (SDL_bool)(input->mouse_position_current.x != input->mouse_position_previous.x ||
+                      input->mouse_position_current.y != input->mouse_position_previous.y);
 }
 
 // Gets the current mouse position relative to the application window.
@@ -132,73 +391,156 @@ static inline SDL_Point input_mouse_position(InputManager* input) {
     return input->mouse_position_current;
 }
 
+/*
+    Gets how far the mouse moved during the last update, summed from the events passed to
+    <input_manager_mouse_motion_event>. Unlike the position, this keeps changing in relative mouse mode.
+*/
+static inline SDL_Point input_mouse_delta(InputManager* input) {
+    return input->mouse_delta;
+}
+
+/*
+    Gets the amount of times a button went down during the last update, counted from the events passed to
+    <input_manager_mouse_button_event>. Can be more than 1 when clicks are faster than the updates.
+    @button The button index, i.e. SDL_BUTTON_LEFT, not the mask.
+*/
+static inline int input_mouse_press_count(InputManager* input, int button) {
+    if(button < 1 || button > INPUT_MOUSE_BUTTONS)
+        return 0;
+
+    return input->mouse_presses[button - 1];
+}
+
+/*
+    Gets the motion events from the last update, oldest first, when <INPUT_MANAGER_MOUSE_SAMPLES> is set.
+    When there are more than <INPUT_MAX_MOUSE_SAMPLES>, the newest events are merged into the last sample.
+*/
+static inline const InputMouseSample* input_mouse_samples(InputManager* input, int* out_count) {
+    *out_count = input->mouse_sample_count;
+    return input->mouse_samples;
+}
+
+/*
+   Gets the gamepad in a player slot, or NULL if the slot is empty.
+   The pointer is only valid until the next gamepad is connected or removed.
+   @index The player slot of the gamepad, or -1 to get the first controller plugged in.
+*/
+static inline InputGamepad* input_gamepad_get(InputManager* input, int index) {
+    if(index == -1)
+        index = input->gamepad_first_slot;
+
+    if(index < 0 || index >= input->gamepad_slot_capacity || input->gamepad_slots[index] == -1)
+        return NULL;
+
+    return &input->gamepads[input->gamepad_slots[index]];
+}
+
+// Gets the amount of connected gamepads.
+static inline int input_gamepad_count(InputManager* input) {
+    return input->gamepad_count;
+}
+
 /*
    Checks if the specified button is currently down.
-   @index The gamepad index retrieved from the SDL_ControllerDeviceEvent,
+   @index The player slot of the gamepad (the first gamepad connected gets slot 0 and so on),
           or -1 to get the first controller plugged in.
 */
 static inline SDL_bool input_gamepad_check_index(InputManager* input, GamepadButton button, int index) {
-    if(index == -1)
-        index = input->controllers[0];
-
-    if(index < 0 || index >= INPUT_MAX_GAMEPADS || !input->gamepads[index].active)
+    InputGamepad* gamepad = input_gamepad_get(input, index);
+    if(!gamepad || button >= INPUT_GAMEPAD_BUTTON_BITS)
         return SDL_FALSE;
 
-    return (input->gamepads[index].button_current & ___INPUT_GAMEPAD_BUTTON(button)) != 0;
+    return (SDL_bool)((gamepad->button_current & ___INPUT_GAMEPAD_BUTTON(button)) != 0);
 }
 
 
 /*
    Checks if the specified button was just pressed during the last update.
-   @index The gamepad index retrieved from the SDL_ControllerDeviceEvent,
-          or -1 to get the first controller plugged in.
+   @index The player slot of the gamepad, or -1 to get the first controller plugged in.
 */
 static inline SDL_bool input_gamepad_pressed_index(InputManager* input, GamepadButton button, int index) {
-    if(index == -1)
-        index = input->controllers[0];
-
-    if(index < 0 || index >= INPUT_MAX_GAMEPADS || !input->gamepads[index].active)
+    InputGamepad* gamepad = input_gamepad_get(input, index);
+    if(!gamepad || button >= INPUT_GAMEPAD_BUTTON_BITS)
         return SDL_FALSE;
 
-    return (input->gamepads[index].button_current & ___INPUT_GAMEPAD_BUTTON(button)) != 0 &&
-           (input->gamepads[index].button_previous & ___INPUT_GAMEPAD_BUTTON(button)) == 0;
+    return (SDL_bool)((gamepad->button_pressed & ___INPUT_GAMEPAD_BUTTON(button)) != 0);
 }
 
 
 
 /*
    Checks if the specified button was just released during the last update.
-   @index The gamepad index retrieved from the SDL_ControllerDeviceEvent,
-          or -1 to get the first controller plugged in.
+   @index The player slot of the gamepad, or -1 to get the first controller plugged in.
 */
 static inline SDL_bool input_gamepad_released_index(InputManager* input, GamepadButton button, int index) {
-    if(index == -1)
-        index = input->controllers[0];
-
-    if(index < 0 || index >= INPUT_MAX_GAMEPADS || !input->gamepads[index].active)
+    InputGamepad* gamepad = input_gamepad_get(input, index);
+    if(!gamepad || button >= INPUT_GAMEPAD_BUTTON_BITS)
         return SDL_FALSE;
 
-    return (input->gamepads[index].button_current & ___INPUT_GAMEPAD_BUTTON(button)) == 0 &&
-           (input->gamepads[index].button_previous & ___INPUT_GAMEPAD_BUTTON(button)) != 0;
+    return (SDL_bool)((gamepad->button_released & ___INPUT_GAMEPAD_BUTTON(button)) != 0);
+}
+
+
+// Gets the history of a gamepad button as of the last update, see <input_history_bits>.
+static inline Uint64 input_gamepad_history(InputManager* input, GamepadButton button, int index) {
+    InputGamepad* gamepad = input_gamepad_get(input, index);
+    if(!gamepad || button >= INPUT_GAMEPAD_BUTTON_BITS)
+        return 0;
+
+    return input_history_bits(gamepad->button_history[button], gamepad->button_history_frames[button], input->frame);
 }
 
+/*
+   Checks if the specified button went down during any of the last frames updates, up to 63.
+   @index The player slot of the gamepad, or -1 to get the first controller plugged in.
+*/
+static inline SDL_bool input_gamepad_pressed_within_index(InputManager* input, GamepadButton button, int frames, int index) {
+    return input_history_pressed_within(input_gamepad_history(input, button, index), frames);
+}
 
 /*
-   Gets the specified axis value.
-   @index The gamepad index retrieved from the SDL_ControllerDeviceEvent,
-          or -1 to get the first controller plugged in.
+   Checks if the specified button has been down for at least the last frames updates, up to 64.
+   @index The player slot of the gamepad, or -1 to get the first controller plugged in.
 */
-static inline Uint16 input_gamepad_axis_value_index(InputManager* input, SDL_GameControllerAxis axis, int index) {
-    if(index == -1)
-        index = input->controllers[0];
+static inline SDL_bool input_gamepad_held_for_index(InputManager* input, GamepadButton button, int frames, int index) {
+    return input_history_held_for(input_gamepad_history(input, button, index), frames);
+}
 
-    if(index < 0 || index >= INPUT_MAX_GAMEPADS || !input->gamepads[index].active)
+/*
+   Checks if the specified button went up during any of the last frames updates, up to 63.
+   @index The player slot of the gamepad, or -1 to get the first controller plugged in.
+*/
+static inline SDL_bool input_gamepad_released_within_index(InputManager* input, GamepadButton button, int frames, int index) {
+    return input_history_released_within(input_gamepad_history(input, button, index), frames);
+}
+
+/*
+   Gets the raw value of the specified axis from the last update.
+   @index The player slot of the gamepad, or -1 to get the first controller plugged in.
+*/
+static inline Sint16 input_gamepad_axis_value_index(InputManager* input, SDL_GameControllerAxis axis, int index) {
+    InputGamepad* gamepad = input_gamepad_get(input, index);
+    if(!gamepad || axis < 0 || axis >= SDL_CONTROLLER_AXIS_MAX)
         return 0;
 
-    return SDL_GameControllerGetAxis(input->gamepads[index].controller, axis);
+    return gamepad->axes[axis];
+}
+
+/*
+   Gets the value of the specified axis from the last update with the deadzones and response curve applied.
+   Sticks are in the range [-1, 1] and triggers are in the range [0, 1].
+   @index The player slot of the gamepad, or -1 to get the first controller plugged in.
+*/
+static inline float input_gamepad_axis(InputManager* input, SDL_GameControllerAxis axis, int index) {
+    InputGamepad* gamepad = input_gamepad_get(input, index);
+    if(!gamepad || axis < 0 || axis >= SDL_CONTROLLER_AXIS_MAX)
+        return 0;
+
+    return input->gamepad_axis_values[axis * input->gamepad_capacity + (int)(gamepad - input->gamepads)];
 }
 
 // Sets the deadzone for an axis to be considered active.
+// This is only used to turn the axes into buttons, see <input_gamepad_set_axis_settings> for axis values.
 static inline void input_gamepad_set_deadzone(InputManager* input, Uint16 value) {
     input->deadzone = value;
 }
@@ -208,6 +550,36 @@ static inline Uint16 input_gamepad_get_deadzone(InputManager* input) {
     return input->deadzone;
 }
 
+// Sets how far a trigger has to be pulled for SDL_CONTROLLER_BUTTON_LEFTTRIGGERFULL/RIGHTTRIGGERFULL to be down.
+static inline void input_gamepad_set_trigger_threshold(InputManager* input, Uint16 value) {
+    input->trigger_threshold = value;
+}
+
+// Gets how far a trigger has to be pulled for its full press button to be down.
+static inline Uint16 input_gamepad_get_trigger_threshold(InputManager* input) {
+    return input->trigger_threshold;
+}
+
+// Sets how the axes in a group are processed. Takes effect on the next update.
+static inline void input_gamepad_set_axis_settings(InputManager* input, InputAxisGroup group, const InputAxisSettings* settings) {
+    input->axis_settings[group] = *settings;
+}
+
+// Gets how the axes in a group are processed.
+static inline InputAxisSettings input_gamepad_get_axis_settings(InputManager* input, InputAxisGroup group) {
+    return input->axis_settings[group];
+}
+
+// Sets the <InputManagerFlags> used to gather input state.
+static inline void input_manager_set_flags(InputManager* input, Uint32 flags) {
+    input->flags = flags;
+}
+
+// Gets the <InputManagerFlags> used to gather input state.
+static inline Uint32 input_manager_get_flags(InputManager* input) {
+    return input->flags;
+}
+
 // Gets the touch events for the previous previous update.
 static inline SDL_TouchFingerEvent* input_touch_previous(InputManager* input, int* out_count) {
     *out_count = input->touch_previous_count;
@@ -220,22 +592,255 @@ static inline SDL_TouchFingerEvent* input_touch_current(InputManager* input, int
     return input->touch_current;
 }
 
+// Gets the amount of fingers that are down or were lifted during the last update.
+static inline int input_touch_finger_count(InputManager* input) {
+    return input->finger_count;
+}
+
+// Gets a finger by its position in the finger table. Positions change between updates.
+static inline InputFinger* input_touch_finger(InputManager* input, int index) {
+    return &input->fingers[index];
+}
+
+// Finds a finger by its id, or returns NULL if it isn't down.
+static inline InputFinger* input_touch_find_finger(InputManager* input, SDL_TouchID touch_id, SDL_FingerID finger_id) {
+    for(int i = 0; i < input->finger_count; i++) {
+        if(input->fingers[i].finger_id == finger_id && input->fingers[i].touch_id == touch_id)
+            return &input->fingers[i];
+    }
+
+    return NULL;
+}
+
+// Checks if the specified gesture is currently active.
+static inline SDL_bool input_gesture_check(InputManager* input, InputGesture gesture) {
+    return (SDL_bool)((input->gesture_current & INPUT_GESTURE_BIT(gesture)) != 0);
+}
+
+// Checks if the specified gesture started during the last update.
+static inline SDL_bool input_gesture_pressed(InputManager* input, InputGesture gesture) {
+    return (SDL_bool)((input->gesture_current & INPUT_GESTURE_BIT(gesture)) != 0 &&
+                      (input->gesture_previous & INPUT_GESTURE_BIT(gesture)) == 0);
+}
+
+// Checks if the specified gesture ended during the last update.
+static inline SDL_bool input_gesture_released(InputManager* input, InputGesture gesture) {
+    return (SDL_bool)((input->gesture_current & INPUT_GESTURE_BIT(gesture)) == 0 &&
+                      (input->gesture_previous & INPUT_GESTURE_BIT(gesture)) != 0);
+}
+
+// Gets the distance between the two fingers of a pinch divided by their starting distance, or 1 if there's no pinch.
+static inline float input_gesture_pinch_scale(InputManager* input) {
+    return input->gesture.pair ? input->gesture.scale : 1.0f;
+}
+
+// Gets how far the two fingers of a rotation have turned in radians, or 0 if there's no rotation. Positive is clockwise.
+static inline float input_gesture_rotation(InputManager* input) {
+    return input->gesture.pair ? input->gesture.rotation : 0;
+}
+
+// Sets the thresholds used to recognize gestures.
+static inline void input_gesture_set_settings(InputManager* input, const InputGestureSettings* settings) {
+    input->gesture_settings = *settings;
+}
+
+// Gets the thresholds used to recognize gestures.
+static inline InputGestureSettings input_gesture_get_settings(InputManager* input) {
+    return input->gesture_settings;
+}
+
+/*
+    Starts or stops collecting the stats of an <InputManager>.
+    Starting clears the counters. Does nothing when the stats are compiled out.
+*/
+static inline void input_manager_set_stats_enabled(InputManager* input, SDL_bool enabled) {
+#if INPUT_ENABLE_STATS
+    if(enabled && !input->stats.enabled) {
+        SDL_zero(input->stats.total);
+        SDL_zero(input->stats.frame);
+        SDL_zero(input->stats.pending);
+    }
+    input->stats.enabled = enabled;
+#else
+    (void)input;
+    (void)enabled;
+#endif
+}
+
+// Gets the stats of an <InputManager>, or NULL when the stats are compiled out.
+static inline const InputStats* input_manager_get_stats(InputManager* input) {
+#if INPUT_ENABLE_STATS
+    return &input->stats;
+#else
+    (void)input;
+    return NULL;
+#endif
+}
+
+// Sets a function that's called around every update, or NULL to remove it. Does nothing when the stats are compiled out.
+static inline void input_manager_set_trace_hook(InputManager* input, InputTraceHook hook, void* userdata) {
+#if INPUT_ENABLE_STATS
+    input->stats.trace = hook;
+    input->stats.trace_userdata = userdata;
+#else
+    (void)input;
+    (void)hook;
+    (void)userdata;
+#endif
+}
+
 // Allocates and initializes a new <InputManager>.
 InputManager* input_manager_create(void);
 
+/*
+    Allocates and initializes a new <InputManager> that makes every allocation through an allocator.
+    The allocator is copied. Pass NULL to use the default allocation methods.
+*/
+InputManager* input_manager_create_with_allocator(const InputAllocator* allocator);
+
+/*
+    Allocates and initializes a new <InputManager> that reads the device state from a backend.
+    The backend and allocator are copied. Pass NULL for either to use the defaults.
+*/
+InputManager* input_manager_create_with_backend(const InputBackend* backend, const InputAllocator* allocator);
+
+// Gets the default backend, which reads the device state from SDL.
+InputBackend input_backend_sdl(void);
+
+// Gets a backend that reads nothing, so the state only comes from events and the input_manager_set_* functions.
+InputBackend input_backend_virtual(void);
+
+/*
+    Turns relative mouse mode on or off through the backend. While it's on, the cursor is hidden
+    and the motion events report the raw movement, see <input_mouse_delta>.
+    Returns SDL_FALSE if the backend doesn't support it.
+*/
+SDL_bool input_manager_set_mouse_relative(InputManager* input, SDL_bool enabled);
+
 // Frees an <InputManager>.
 void input_manager_free(InputManager* input);
 
 // Updates an <InputManager>. Only call this after polling for input events.
 void input_manager_update(InputManager* input);
 
+/*
+    Passes an event to the matching *_event function. Should be called before <input_manager_update>.
+    Returns SDL_FALSE if the event isn't used by the input manager.
+*/
+SDL_bool input_manager_event(InputManager* input, SDL_Event* event);
+
+/*
+    Removes every input event from the SDL event queue and applies them, reading them in bulk
+    with SDL_PeepEvents. Events of the same kind of device are applied in order, but keyboard,
+    mouse, controller and touch events are applied one kind at a time. Pumps the SDL event loop,
+    so it should be called from the main thread, before <input_manager_update>.
+    Returns the amount of events applied.
+
+    The events are taken out of the queue, so the application never sees them:
+        SDL_KEYDOWN and SDL_KEYUP
+        SDL_MOUSEMOTION, SDL_MOUSEBUTTONDOWN, SDL_MOUSEBUTTONUP and SDL_MOUSEWHEEL
+        SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERBUTTONDOWN, SDL_CONTROLLERBUTTONUP,
+        SDL_CONTROLLERDEVICEADDED and SDL_CONTROLLERDEVICEREMOVED
+        SDL_FINGERDOWN, SDL_FINGERUP and SDL_FINGERMOTION
+    Everything else, including SDL_TEXTINPUT and the joystick events, is left in the queue for SDL_PollEvent.
+    Applications that also handle any of the events above themselves, i.e. for hotkeys or to open their
+    own controllers, should pass them to <input_manager_event> from their SDL_PollEvent loop instead,
+    or use <input_manager_watch_events>.
+*/
+int input_manager_poll_events(InputManager* input);
+
+/*
+    Registers the manager with SDL_AddEventWatch so every event is applied the moment SDL queues it,
+    or unregisters it. The events are still left in the queue for the application, so they shouldn't
+    be passed to the manager again.
+    SDL queues most events while pumping the event loop, and those are applied right away when that's
+    on the thread that registered the manager. Some platforms queue events from other threads, where the
+    manager can't be updated safely, so those are held in an <InputEventQueue> and applied at the start of
+    the next update instead, controllers included. Up to <INPUT_WATCH_QUEUE_SIZE> of them are kept.
+    Returns SDL_FALSE if the queue couldn't be allocated, in which case the manager isn't registered.
+*/
+SDL_bool input_manager_watch_events(InputManager* input, SDL_bool enabled);
+
 // Updates controller state based off of the event. Should be called before <input_manager_update>.
 void input_manager_controller_event(InputManager* input, SDL_ControllerDeviceEvent* event);
 
+/*
+    Reserves space for the specified amount of gamepads, so connecting them doesn't allocate.
+    Returns SDL_FALSE if the space couldn't be allocated.
+*/
+SDL_bool input_manager_reserve_gamepads(InputManager* input, int count);
+
+// Gets the player slot of the gamepad with the specified joystick instance id, or -1 if it isn't connected.
+int input_gamepad_slot(InputManager* input, SDL_JoystickID instance_id);
+
+/*
+    Caches a controller button press or release. Should be called before <input_manager_update>.
+    Only affects the gamepad state when <INPUT_MANAGER_GAMEPAD_EVENTS> is set,
+    but presses count as taps either way (see <InputManagerFlags>).
+*/
+void input_manager_controller_button_event(InputManager* input, SDL_ControllerButtonEvent* event);
+
+/*
+    Caches a controller axis value. Should be called before <input_manager_update>.
+    Only affects the gamepad state when <INPUT_MANAGER_GAMEPAD_EVENTS> is set.
+*/
+void input_manager_controller_axis_event(InputManager* input, SDL_ControllerAxisEvent* event);
+
+/*
+    Updates keyboard state based off of the event. Should be called before <input_manager_update>.
+    Only affects the keyboard state when <INPUT_MANAGER_KEYBOARD_EVENTS> is set,
+    but presses count as taps either way (see <InputManagerFlags>).
+*/
+void input_manager_key_event(InputManager* input, SDL_KeyboardEvent* event);
+
+/*
+    Updates mouse button state based off of the event. Should be called before <input_manager_update>.
+    Only affects the mouse state when <INPUT_MANAGER_MOUSE_EVENTS> is set,
+    but presses count as taps either way (see <InputManagerFlags>).
+*/
+void input_manager_mouse_button_event(InputManager* input, SDL_MouseButtonEvent* event);
+
+/*
+    Updates the mouse position based off of the event. Should be called before <input_manager_update>.
+    The position only affects the mouse state when <INPUT_MANAGER_MOUSE_EVENTS> is set,
+    but the relative motion is always added to <input_mouse_delta>.
+*/
+void input_manager_mouse_motion_event(InputManager* input, SDL_MouseMotionEvent* event);
+
 // Updates mouse wheel state based off of the event. Should be called before <input_manager_update>.
 void input_manager_mouse_wheel_event(InputManager* input, SDL_MouseWheelEvent* event);
 
 // Updates touch state based off of the event. Should be called before <input_manager_update>.
 void input_manager_touch_event(InputManager* input, SDL_TouchFingerEvent* event);
 
+/*
+    Adds a gamepad that isn't backed by a controller, i.e. for a bot. Its state is set with
+    <input_manager_set_gamepad_button> and <input_manager_set_gamepad_axis>.
+    @instance_id The id used to refer to the gamepad. Negative ids can't collide with real controllers.
+    @slot The player slot to put the gamepad in, or -1 to use the lowest free slot.
+    Returns the slot of the gamepad, or -1 if the id or slot is already in use.
+*/
+int input_manager_add_virtual_gamepad(InputManager* input, SDL_JoystickID instance_id, int slot);
+
+// Removes a gamepad added by <input_manager_add_virtual_gamepad>.
+void input_manager_remove_virtual_gamepad(InputManager* input, SDL_JoystickID instance_id);
+
+/*
+    Changes the state built from events directly, without an SDL_Event.
+    Like the matching *_event functions, these should be called before <input_manager_update>,
+    and only affect the state that isn't read from the backend, apart from taps.
+*/
+
+void input_manager_set_key(InputManager* input, SDL_Scancode key, SDL_bool down);
+void input_manager_set_mouse_button(InputManager* input, int button, SDL_bool down);
+void input_manager_set_mouse_position(InputManager* input, int x, int y);
+void input_manager_add_mouse_motion(InputManager* input, int x, int y, int dx, int dy, Uint32 timestamp);
+void input_manager_add_mouse_wheel(InputManager* input, int x, int y);
+void input_manager_set_gamepad_button(InputManager* input, SDL_JoystickID instance_id, int button, SDL_bool down);
+void input_manager_set_gamepad_axis(InputManager* input, SDL_JoystickID instance_id, int axis, Sint16 value);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef SDL_INPUT_INPUT_RECORDER_H
+#define SDL_INPUT_INPUT_RECORDER_H
+
+#include <SDL.h>
+#include "input_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Records the state of an <InputManager> to a file once per update, so it can
+    later be replayed bit-exactly with an <InputReplay>.
+
+    Each frame only stores what changed since the previous frame, so an idle frame
+    takes a single byte. The update clock is only stored while a finger that could
+    become a long press is down. Frames are written into a fixed buffer that's flushed to
+    the file when full, so recording never allocates after creation.
+*/
+typedef struct InputRecorder InputRecorder;
+
+/*
+    Replays a recording made by an <InputRecorder> into an <InputManager>.
+    The recording is memory mapped when possible, so playback is limited
+    by decoding speed rather than file reads.
+*/
+typedef struct InputReplay InputReplay;
+
+// Creates a new <InputRecorder> that writes to the specified file, replacing its contents.
+InputRecorder* input_recorder_create(const char* path);
+
+// Flushes any buffered frames and frees an <InputRecorder>.
+void input_recorder_free(InputRecorder* recorder);
+
+// Records the current state of an <InputManager>. Call this once after each <input_manager_update>.
+SDL_bool input_recorder_record(InputRecorder* recorder, InputManager* input);
+
+// Writes any buffered frames to the file.
+SDL_bool input_recorder_flush(InputRecorder* recorder);
+
+// Opens a recording made by an <InputRecorder>.
+InputReplay* input_replay_open(const char* path);
+
+/*
+    Opens a recording that's already in memory.
+    The memory is not copied and must outlive the <InputReplay>.
+*/
+InputReplay* input_replay_open_memory(const void* data, size_t size);
+
+// Frees an <InputReplay>.
+void input_replay_close(InputReplay* replay);
+
+/*
+    Updates an <InputManager> with the next recorded frame instead of the input devices.
+    Call this in place of <input_manager_update>.
+    Returns SDL_FALSE when there are no frames left or the recording is corrupt.
+*/
+SDL_bool input_replay_update(InputReplay* replay, InputManager* input);
+
+// Determines if every frame of an <InputReplay> has been played.
+SDL_bool input_replay_finished(InputReplay* replay);
+
+// Gets the amount of frames that have been played so far.
+Uint64 input_replay_frame(InputReplay* replay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef SDL_INPUT_INPUT_STATS_H
+#define SDL_INPUT_INPUT_STATS_H
+
+#include <SDL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Types used to measure what the managers cost per update.
+
+    Stats are opt-in at runtime, and can be stripped out entirely when compiling by defining
+    INPUT_ENABLE_STATS as 0 (the meson option "stats"), which also removes the stats from the managers.
+    The same value has to be used when compiling the library and anything that includes its headers.
+*/
+
+#ifndef INPUT_ENABLE_STATS
+#define INPUT_ENABLE_STATS 1
+#endif
+
+typedef enum InputStatsEvent {
+    INPUT_STATS_EVENT_KEY,
+    INPUT_STATS_EVENT_MOUSE_BUTTON,
+    INPUT_STATS_EVENT_MOUSE_MOTION,
+    INPUT_STATS_EVENT_MOUSE_WHEEL,
+    INPUT_STATS_EVENT_GAMEPAD_BUTTON,
+    INPUT_STATS_EVENT_GAMEPAD_AXIS,
+    INPUT_STATS_EVENT_GAMEPAD_DEVICE,
+    INPUT_STATS_EVENT_TOUCH,
+    INPUT_STATS_EVENT_MAX
+} InputStatsEvent;
+
+// The kinds of devices that latency is measured for.
+typedef enum InputLatencyDevice {
+    INPUT_LATENCY_KEYBOARD,
+    INPUT_LATENCY_MOUSE,
+    INPUT_LATENCY_GAMEPAD,
+    INPUT_LATENCY_TOUCH,
+    INPUT_LATENCY_DEVICE_MAX
+} InputLatencyDevice;
+
+#define INPUT_LATENCY_BUCKETS 16
+
+/*
+    The delays between input events and the action changes they caused, in milliseconds.
+    Bucket i counts the delays from <input_latency_bucket_min>(i) up to the start of the
+    next bucket, and the last bucket counts everything longer.
+*/
+typedef struct InputLatencyHistogram {
+    Uint64 counts[INPUT_LATENCY_BUCKETS];
+    Uint64 samples;
+    Uint64 total_ms;
+    Uint32 max_ms;
+} InputLatencyHistogram;
+
+// Gets the shortest delay counted by a bucket, in milliseconds.
+static inline Uint32 input_latency_bucket_min(int bucket) {
+    static const Uint32 bounds[INPUT_LATENCY_BUCKETS] = { 0, 1, 2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 25, 33, 50, 100 };
+    return bounds[bucket];
+}
+
+// Gets the name of a device kind, as used by <input_latency_write>.
+static inline const char* input_latency_device_name(InputLatencyDevice device) {
+    static const char* names[INPUT_LATENCY_DEVICE_MAX] = { "keyboard", "mouse", "gamepad", "touch" };
+    return device >= 0 && device < INPUT_LATENCY_DEVICE_MAX ? names[device] : "unknown";
+}
+
+/*
+    Gets the delay that a fraction of the samples are at or below, rounded down to the start of its bucket.
+    @fraction The fraction of samples in the range [0, 1], i.e. 0.99 for the 99th percentile.
+*/
+Uint32 input_latency_percentile(const InputLatencyHistogram* histogram, float fraction);
+
+/*
+    Writes a histogram as a single line of JSON, so runs can be compared offline.
+    The name is escaped, so it can be any string.
+    Returns SDL_FALSE if the line couldn't be written, or if it's longer than 1024 bytes.
+*/
+SDL_bool input_latency_write(const InputLatencyHistogram* histogram, const char* name, SDL_RWops* file);
+
+typedef struct InputStatsCounters {
+    Uint64 updates;
+    // Time spent inside of updates, in nanoseconds.
+    Uint64 update_ns;
+    // Calls made to the backend to read the device state.
+    Uint64 sdl_calls;
+    // Events applied to the manager, counted by kind.
+    Uint64 events[INPUT_STATS_EVENT_MAX];
+    Uint64 allocations;
+    Uint64 reallocations;
+    // Actions that were evaluated against the device state, and actions an update could skip.
+    Uint64 actions_evaluated;
+    Uint64 actions_skipped;
+    // Times the touch event buffer had to grow.
+    Uint64 touch_growths;
+} InputStatsCounters;
+
+/*
+    Called at the start and end of each update, i.e. to mark the update in a frame profiler.
+    @name The name of the update function.
+    @begin SDL_TRUE at the start of the update, SDL_FALSE at the end.
+*/
+typedef void (*InputTraceHook)(void* userdata, const char* name, SDL_bool begin);
+
+typedef struct InputStats {
+    // Counters are only written while this is set.
+    SDL_bool enabled;
+    // Everything since the stats were enabled or reset.
+    InputStatsCounters total;
+    // Everything between the end of the update before last and the end of the last update,
+    // so events polled before an update count towards it.
+    InputStatsCounters frame;
+    // Everything since the end of the last update.
+    InputStatsCounters pending;
+    // When the current update started.
+    Uint64 update_start;
+    // Called whether or not the counters are enabled.
+    InputTraceHook trace;
+    void* trace_userdata;
+} InputStats;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
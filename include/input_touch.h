@@ -0,0 +1,114 @@
+#ifndef SDL_INPUT_INPUT_TOUCH_H
+#define SDL_INPUT_INPUT_TOUCH_H
+
+#include <SDL.h>
+
+/*
+    Types used to track fingers and recognize gestures.
+    Fingers are kept in a fixed size table that's updated in place from touch events,
+    and gestures are recognized a little at a time as each event arrives.
+*/
+
+// When compiling, can be used to change the amount of fingers that can be tracked at once.
+#ifndef INPUT_MAX_FINGERS
+#define INPUT_MAX_FINGERS 10
+#endif
+
+typedef struct InputFinger {
+    SDL_TouchID touch_id;
+    SDL_FingerID finger_id;
+    // The position of the finger, normalized to [0, 1].
+    float x;
+    float y;
+    // Where the finger was put down.
+    float start_x;
+    float start_y;
+    float pressure;
+    // The timestamp of the event that put the finger down.
+    Uint32 down_time;
+    SDL_bool down;
+    // Set if the finger was put down/lifted during the last update.
+    SDL_bool pressed;
+    SDL_bool released;
+    // The changes from events that haven't been picked up by an update yet.
+    SDL_bool event_pressed;
+} InputFinger;
+
+typedef enum InputGesture {
+    INPUT_GESTURE_TAP,
+    INPUT_GESTURE_DOUBLE_TAP,
+    // Held for as long as the finger stays down after the long press is recognized.
+    INPUT_GESTURE_LONG_PRESS,
+    INPUT_GESTURE_SWIPE_LEFT,
+    INPUT_GESTURE_SWIPE_RIGHT,
+    INPUT_GESTURE_SWIPE_UP,
+    INPUT_GESTURE_SWIPE_DOWN,
+    // Pinches and rotations are held while two fingers are past the threshold.
+    INPUT_GESTURE_PINCH_IN,
+    INPUT_GESTURE_PINCH_OUT,
+    INPUT_GESTURE_ROTATE_CLOCKWISE,
+    INPUT_GESTURE_ROTATE_COUNTER_CLOCKWISE,
+    INPUT_GESTURE_MAX
+} InputGesture;
+
+typedef Uint32 GestureMask;
+
+#define INPUT_GESTURE_BIT(gesture) ((GestureMask)1 << (gesture))
+
+typedef struct InputGestureSettings {
+    // The longest a finger can be down for a tap, in milliseconds.
+    Uint32 tap_time;
+    // The longest time between two taps for them to be a double tap.
+    Uint32 double_tap_time;
+    // The furthest apart two taps can be for them to be a double tap, in normalized units.
+    float double_tap_distance;
+    // How long a finger has to be held in place to be a long press.
+    Uint32 long_press_time;
+    // The furthest a finger can move and still be a tap or long press, in normalized units.
+    float tap_distance;
+    // The shortest distance a finger has to move to be a swipe.
+    float swipe_distance;
+    // The longest a finger can be down for a swipe.
+    Uint32 swipe_time;
+    // How far the distance between two fingers has to change to be a pinch, as a fraction of the starting distance.
+    float pinch_threshold;
+    // How far two fingers have to turn to be a rotation, in radians.
+    float rotate_threshold;
+} InputGestureSettings;
+
+// The bookkeeping of the gesture recognizer.
+typedef struct InputGestureState {
+    // The timestamp of the newest touch event.
+    Uint32 time;
+    // The time the last update checked the held gestures against, which is recorded so replays match.
+    Uint32 update_time;
+    // The amount of fingers that are down.
+    int fingers_down;
+    // The most fingers that have been down at once since the first one was put down.
+    int fingers_max;
+    // Set while the only finger down hasn't moved far enough to rule out a tap or long press.
+    SDL_bool tap_candidate;
+    // When the first finger was put down.
+    Uint32 down_time;
+    // The last tap, so the next one can be turned into a double tap.
+    SDL_bool last_tap;
+    Uint32 last_tap_time;
+    float last_tap_x;
+    float last_tap_y;
+    // The two fingers used for pinches and rotations.
+    SDL_bool pair;
+    SDL_TouchID pair_touches[2];
+    SDL_FingerID pair_fingers[2];
+    // The starting distance between the pair, and the angle between them as of the last event.
+    float pair_distance;
+    float pair_angle;
+    // The current distance between the pair of fingers divided by their starting distance.
+    float scale;
+    // How far the pair of fingers has turned since they were put down, in radians. Positive is clockwise.
+    float rotation;
+    // Gestures that are held, and gestures that happened since the last update.
+    GestureMask state;
+    GestureMask taps;
+} InputGestureState;
+
+#endif
@@ -0,0 +1,457 @@
+#include <action_manager.h>
+
+#include "std_definitions.h"
+#include "action_internal.h"
+
+static void action_combo_sort(Uint32* actions, int count) {
+    for(int i = 1; i < count; i++) {
+        Uint32 action = actions[i];
+        int j = i;
+        for(; j > 0 && actions[j - 1] > action; j--)
+            actions[j] = actions[j - 1];
+        actions[j] = action;
+    }
+}
+
+// Builds the canonical symbol of a step, so the same condition written in a different order is shared.
+static void action_combo_symbol_init(ActionComboSymbol* symbol, const ActionComboStep* step) {
+    input_memset(symbol, 0, sizeof(*symbol));
+    symbol->type = step->type;
+    symbol->hold = step->type == ACTION_COMBO_STEP_CHARGE ? step->hold : 0;
+    symbol->action_count = step->action_count;
+    symbol->excluded_count = step->excluded_count;
+    input_memcpy(symbol->actions, step->actions, sizeof(*step->actions) * step->action_count);
+    input_memcpy(symbol->excluded, step->excluded, sizeof(*step->excluded) * step->excluded_count);
+    action_combo_sort(symbol->actions, symbol->action_count);
+    action_combo_sort(symbol->excluded, symbol->excluded_count);
+}
+
+static SDL_bool action_combo_symbol_equals(const ActionComboSymbol* a, const ActionComboSymbol* b) {
+    if(a->type != b->type || a->hold != b->hold || a->action_count != b->action_count || a->excluded_count != b->excluded_count)
+        return SDL_FALSE;
+
+    for(int i = 0; i < a->action_count; i++) {
+        if(a->actions[i] != b->actions[i])
+            return SDL_FALSE;
+    }
+
+    for(int i = 0; i < a->excluded_count; i++) {
+        if(a->excluded[i] != b->excluded[i])
+            return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+
+int action_manager_add_combo(ActionManager* action_manager, const ActionComboStep* steps, int step_count) {
+    if(step_count <= 0)
+        return -1;
+
+    for(int i = 0; i < step_count; i++) {
+        const ActionComboStep* step = &steps[i];
+        if(step->action_count <= 0 || step->action_count > ACTION_COMBO_MAX_STEP_ACTIONS ||
+           step->excluded_count < 0 || step->excluded_count > ACTION_COMBO_MAX_STEP_ACTIONS)
+        {
+            return -1;
+        }
+
+        for(int j = 0; j < step->action_count; j++) {
+            if(step->actions[j] >= (Uint32)action_manager->action_count)
+                return -1;
+        }
+
+        for(int j = 0; j < step->excluded_count; j++) {
+            if(step->excluded[j] >= (Uint32)action_manager->action_count)
+                return -1;
+        }
+    }
+
+    if(action_manager->combo_count == action_manager->combo_capacity) {
+        int capacity = action_manager->combo_capacity == 0 ? 4 : action_manager->combo_capacity * 2;
+        void* buffer = action_manager_reallocate(action_manager, action_manager->combos, capacity * sizeof(*action_manager->combos));
+        if(!buffer)
+            return -1;
+
+        action_manager->combos = buffer;
+        action_manager->combo_capacity = capacity;
+    }
+
+    ActionComboStep* copy = action_manager_allocate(action_manager, sizeof(*copy) * step_count);
+    if(!copy)
+        return -1;
+
+    input_memcpy(copy, steps, sizeof(*copy) * step_count);
+
+    ActionCombo* combo = &action_manager->combos[action_manager->combo_count];
+    combo->steps = copy;
+    combo->step_count = step_count;
+    action_manager->combos_dirty = SDL_TRUE;
+
+    return action_manager->combo_count++;
+}
+
+void action_manager_clear_combos(ActionManager* action_manager) {
+    for(int i = 0; i < action_manager->combo_count; i++)
+        action_manager_deallocate(action_manager, action_manager->combos[i].steps);
+
+    action_manager->combo_count = 0;
+    action_manager->combos_dirty = SDL_TRUE;
+}
+
+SDL_bool action_manager_set_history_length(ActionManager* action_manager, int frames) {
+    int length = 2;
+    while(length < frames)
+        length <<= 1;
+
+    if(length <= action_manager->history_length)
+        return SDL_TRUE;
+
+    int words = INPUT_BITSET_WORDS(action_manager->action_count);
+    Uint64* history = action_manager_allocate_zeroed(action_manager, (size_t)length * words, sizeof(*history));
+    if(!history)
+        return SDL_FALSE;
+
+    // Keeps the recent updates, each at the position it has in the larger ring.
+    for(int ago = 0; ago < action_manager->history_length && (Uint32)ago <= action_manager->frame; ago++) {
+        Uint32 frame = action_manager->frame - ago;
+        input_memcpy(history + (frame & (length - 1)) * words,
+                     action_manager->history + (frame & (action_manager->history_length - 1)) * words,
+                     sizeof(*history) * words);
+    }
+
+    action_manager_deallocate(action_manager, action_manager->history);
+    action_manager->history = history;
+    action_manager->history_length = length;
+    return SDL_TRUE;
+}
+
+void action_combo_free(ActionManager* action_manager) {
+    action_manager_clear_combos(action_manager);
+    action_manager_deallocate(action_manager, action_manager->combos);
+    action_manager_deallocate(action_manager, action_manager->combo_matcher.symbols);
+    action_manager_deallocate(action_manager, action_manager->history);
+}
+
+static int action_combo_find_symbol(ActionComboMatcher* matcher, const ActionComboSymbol* symbol) {
+    for(int i = 0; i < matcher->symbol_count; i++) {
+        if(action_combo_symbol_equals(&matcher->symbols[i], symbol))
+            return i;
+    }
+
+    matcher->symbols[matcher->symbol_count] = *symbol;
+    return matcher->symbol_count++;
+}
+
+SDL_bool action_combo_compile(ActionManager* action_manager) {
+    ActionComboMatcher* matcher = &action_manager->combo_matcher;
+    int action_count = action_manager->action_count;
+    int combo_count = action_manager->combo_count;
+    int step_count = 0;
+    int max_hold = 0;
+
+    for(int i = 0; i < combo_count; i++) {
+        ActionCombo* combo = &action_manager->combos[i];
+        step_count += combo->step_count;
+        for(int j = 0; j < combo->step_count; j++) {
+            if(combo->steps[j].type == ACTION_COMBO_STEP_CHARGE && combo->steps[j].hold > max_hold)
+                max_hold = combo->steps[j].hold;
+        }
+    }
+
+    action_manager_deallocate(action_manager, matcher->symbols);
+    *matcher = (ActionComboMatcher){ 0 };
+
+    if(combo_count == 0) {
+        action_manager->combos_dirty = SDL_FALSE;
+        return SDL_TRUE;
+    }
+
+    // Charge steps look back through the history for as long as they have to be held.
+    if(!action_manager_set_history_length(action_manager, max_hold + 2))
+        return SDL_FALSE;
+
+    int node_capacity = step_count + 1;
+    int reference_capacity = step_count * ACTION_COMBO_MAX_STEP_ACTIONS * 2;
+
+    // Laid out largest alignment first, all of which live in one block owned by symbols.
+    size_t symbols_size = sizeof(ActionComboSymbol) * step_count;
+    size_t evaluated_size = sizeof(Uint64) * INPUT_BITSET_WORDS(step_count);
+    size_t nodes_size = sizeof(ActionComboNode) * node_capacity;
+    size_t edges_size = sizeof(ActionComboEdge) * step_count;
+    size_t ints_size = sizeof(int) * (combo_count * 2 + action_count + 1 + reference_capacity + step_count);
+
+    Uint8* block = action_manager_allocate_zeroed(action_manager, 1, symbols_size + evaluated_size + nodes_size + edges_size + ints_size);
+    if(!block)
+        return SDL_FALSE;
+
+    // Scratch space used to build the trie: linked lists of edges per node, and where each combo ends.
+    int* build = action_manager_allocate(action_manager, sizeof(int) * (node_capacity + step_count + combo_count));
+    ActionComboEdge* build_edges = action_manager_allocate(action_manager, sizeof(ActionComboEdge) * step_count);
+    if(!build || !build_edges) {
+        action_manager_deallocate(action_manager, build);
+        action_manager_deallocate(action_manager, build_edges);
+        action_manager_deallocate(action_manager, block);
+        return SDL_FALSE;
+    }
+
+    matcher->symbols = (ActionComboSymbol*)block;
+    block += symbols_size;
+    matcher->evaluated = (Uint64*)block;
+    block += evaluated_size;
+    matcher->nodes = (ActionComboNode*)block;
+    block += nodes_size;
+    matcher->edges = (ActionComboEdge*)block;
+    block += edges_size;
+    matcher->matches = (int*)block;
+    matcher->matched = matcher->matches + combo_count;
+    matcher->action_offsets = matcher->matched + combo_count;
+    matcher->action_symbols = matcher->action_offsets + action_count + 1;
+    matcher->fired = matcher->action_symbols + reference_capacity;
+
+    int* first_edge = build;
+    int* next_edge = first_edge + node_capacity;
+    int* combo_end = next_edge + step_count;
+    int edge_count = 0;
+
+    for(int i = 0; i < node_capacity; i++)
+        first_edge[i] = -1;
+
+    matcher->node_count = 1;
+
+    // Inserts each combo into the trie, sharing the steps it has in common with earlier combos.
+    for(int i = 0; i < combo_count; i++) {
+        ActionCombo* combo = &action_manager->combos[i];
+        int node = 0;
+
+        for(int j = 0; j < combo->step_count; j++) {
+            ActionComboSymbol symbol;
+            action_combo_symbol_init(&symbol, &combo->steps[j]);
+            int symbol_index = action_combo_find_symbol(matcher, &symbol);
+            Uint16 window = j == 0 ? 0 : combo->steps[j].window;
+
+            int edge = first_edge[node];
+            while(edge != -1 && (build_edges[edge].symbol != symbol_index || build_edges[edge].window != window))
+                edge = next_edge[edge];
+
+            if(edge == -1) {
+                edge = edge_count++;
+                build_edges[edge].symbol = symbol_index;
+                build_edges[edge].window = window;
+                build_edges[edge].target = matcher->node_count++;
+                next_edge[edge] = first_edge[node];
+                first_edge[node] = edge;
+            }
+
+            node = build_edges[edge].target;
+        }
+
+        combo_end[i] = node;
+        matcher->nodes[node].match_count++;
+    }
+
+    // Flattens the edges of each node into a run sorted by symbol, so they can be binary searched.
+    int edge_cursor = 0;
+    int match_cursor = 0;
+    for(int node = 0; node < matcher->node_count; node++) {
+        ActionComboNode* info = &matcher->nodes[node];
+        info->edge_start = edge_cursor;
+
+        for(int edge = first_edge[node]; edge != -1; edge = next_edge[edge]) {
+            ActionComboEdge value = build_edges[edge];
+            int j = edge_cursor++;
+            for(; j > info->edge_start && matcher->edges[j - 1].symbol > value.symbol; j--)
+                matcher->edges[j] = matcher->edges[j - 1];
+            matcher->edges[j] = value;
+
+            if(value.window > info->max_window)
+                info->max_window = value.window;
+        }
+
+        info->edge_count = edge_cursor - info->edge_start;
+        info->match_start = match_cursor;
+        match_cursor += info->match_count;
+        info->match_count = 0;
+    }
+
+    for(int i = 0; i < combo_count; i++) {
+        ActionComboNode* info = &matcher->nodes[combo_end[i]];
+        matcher->matches[info->match_start + info->match_count++] = i;
+    }
+
+    // Builds the reverse index from actions to the symbols they appear in.
+    for(int i = 0; i < matcher->symbol_count; i++) {
+        ActionComboSymbol* symbol = &matcher->symbols[i];
+        for(int j = 0; j < symbol->action_count; j++)
+            matcher->action_offsets[symbol->actions[j]]++;
+        for(int j = 0; j < symbol->excluded_count; j++)
+            matcher->action_offsets[symbol->excluded[j]]++;
+    }
+
+    int total = 0;
+    for(int i = 0; i <= action_count; i++) {
+        int count = matcher->action_offsets[i];
+        matcher->action_offsets[i] = total;
+        total += count;
+    }
+
+    for(int i = 0; i < matcher->symbol_count; i++) {
+        ActionComboSymbol* symbol = &matcher->symbols[i];
+        for(int j = 0; j < symbol->action_count; j++)
+            matcher->action_symbols[matcher->action_offsets[symbol->actions[j]]++] = i;
+        for(int j = 0; j < symbol->excluded_count; j++)
+            matcher->action_symbols[matcher->action_offsets[symbol->excluded[j]]++] = i;
+    }
+
+    input_memmove(matcher->action_offsets + 1, matcher->action_offsets, sizeof(int) * action_count);
+    matcher->action_offsets[0] = 0;
+
+    action_manager_deallocate(action_manager, build);
+    action_manager_deallocate(action_manager, build_edges);
+
+    action_manager->combos_dirty = SDL_FALSE;
+    return SDL_TRUE;
+}
+
+static SDL_bool action_combo_condition(ActionManager* action_manager, const ActionComboSymbol* symbol, int ago) {
+    for(int i = 0; i < symbol->action_count; i++) {
+        if(!action_history_check(action_manager, symbol->actions[i], ago))
+            return SDL_FALSE;
+    }
+
+    for(int i = 0; i < symbol->excluded_count; i++) {
+        if(action_history_check(action_manager, symbol->excluded[i], ago))
+            return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+
+static SDL_bool action_combo_symbol_fired(ActionManager* action_manager, const ActionComboSymbol* symbol) {
+    SDL_bool now = action_combo_condition(action_manager, symbol, 0);
+    SDL_bool before = action_combo_condition(action_manager, symbol, 1);
+
+    if(symbol->type == ACTION_COMBO_STEP_PRESS)
+        return now && !before;
+
+    if(now || !before)
+        return SDL_FALSE;
+
+    for(int ago = 2; ago <= symbol->hold; ago++) {
+        if(!action_combo_condition(action_manager, symbol, ago))
+            return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+
+// Adds a partial match, replacing the oldest one when they're all in use.
+static void action_combo_push_active(ActionComboActive* active, int* count, int node, Uint32 frame) {
+    for(int i = 0; i < *count; i++) {
+        if(active[i].node == node) {
+            active[i].frame = frame;
+            return;
+        }
+    }
+
+    if(*count < ACTION_COMBO_MAX_ACTIVE) {
+        active[(*count)++] = (ActionComboActive){ node, frame };
+        return;
+    }
+
+    int oldest = 0;
+    for(int i = 1; i < *count; i++) {
+        if(active[i].frame < active[oldest].frame)
+            oldest = i;
+    }
+
+    active[oldest] = (ActionComboActive){ node, frame };
+}
+
+// Follows the edges of a node that match a symbol.
+static void action_combo_advance(ActionManager* action_manager, ActionComboActive* pending, int* pending_count, int node, Uint32 last_frame, int symbol) {
+    ActionComboMatcher* matcher = &action_manager->combo_matcher;
+    const ActionComboNode* info = &matcher->nodes[node];
+    const ActionComboEdge* edges = matcher->edges + info->edge_start;
+
+    int low = 0;
+    int high = info->edge_count;
+    while(low < high) {
+        int middle = (low + high) / 2;
+        if(edges[middle].symbol < symbol)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    for(int i = low; i < info->edge_count && edges[i].symbol == symbol; i++) {
+        if(node != 0 && action_manager->frame - last_frame > edges[i].window)
+            continue;
+
+        const ActionComboNode* target = &matcher->nodes[edges[i].target];
+        for(int j = 0; j < target->match_count; j++)
+            matcher->matched[matcher->matched_count++] = matcher->matches[target->match_start + j];
+
+        if(target->edge_count)
+            action_combo_push_active(pending, pending_count, edges[i].target, action_manager->frame);
+    }
+}
+
+void action_combo_update(ActionManager* action_manager) {
+    ActionComboMatcher* matcher = &action_manager->combo_matcher;
+    int words = INPUT_BITSET_WORDS(action_manager->action_count);
+    int fired_count = 0;
+
+    matcher->matched_count = 0;
+    if(matcher->node_count == 0)
+        return;
+
+    // Only the symbols that reference an action that changed can have happened.
+    for(int word = 0; word < words; word++) {
+        for(Uint64 changed = action_manager->current[word] ^ action_manager->previous[word]; changed; changed &= changed - 1) {
+            int action = word * 64 + input_bits_lowest(changed);
+            for(int i = matcher->action_offsets[action]; i < matcher->action_offsets[action + 1]; i++) {
+                int symbol = matcher->action_symbols[i];
+                if(input_bitset_test(matcher->evaluated, symbol))
+                    continue;
+
+                input_bitset_set(matcher->evaluated, symbol);
+                if(action_combo_symbol_fired(action_manager, &matcher->symbols[symbol]))
+                    matcher->fired[fired_count++] = symbol;
+            }
+        }
+    }
+
+    for(int word = 0; word < words; word++) {
+        for(Uint64 changed = action_manager->current[word] ^ action_manager->previous[word]; changed; changed &= changed - 1) {
+            int action = word * 64 + input_bits_lowest(changed);
+            for(int i = matcher->action_offsets[action]; i < matcher->action_offsets[action + 1]; i++)
+                input_bitset_clear(matcher->evaluated, matcher->action_symbols[i]);
+        }
+    }
+
+    // Drops the partial matches that can't continue anymore.
+    int count = 0;
+    for(int i = 0; i < matcher->active_count; i++) {
+        ActionComboActive active = matcher->active[i];
+        if(action_manager->frame - active.frame <= matcher->nodes[active.node].max_window)
+            matcher->active[count++] = active;
+    }
+    matcher->active_count = count;
+
+    if(fired_count == 0)
+        return;
+
+    // Steps found this update can only be followed by steps in a later update.
+    ActionComboActive pending[ACTION_COMBO_MAX_ACTIVE];
+    int pending_count = 0;
+
+    for(int i = 0; i < fired_count; i++) {
+        int symbol = matcher->fired[i];
+        action_combo_advance(action_manager, pending, &pending_count, 0, action_manager->frame, symbol);
+        for(int j = 0; j < matcher->active_count; j++)
+            action_combo_advance(action_manager, pending, &pending_count, matcher->active[j].node, matcher->active[j].frame, symbol);
+    }
+
+    for(int i = 0; i < pending_count; i++)
+        action_combo_push_active(matcher->active, &matcher->active_count, pending[i].node, pending[i].frame);
+}
@@ -0,0 +1,62 @@
+#ifndef SDL_INPUT_ACTION_INTERNAL_H
+#define SDL_INPUT_ACTION_INTERNAL_H
+
+#include <action_manager.h>
+
+#include "std_definitions.h"
+#include "input_stats_internal.h"
+
+/*
+    Functions shared between the parts of an <ActionManager>.
+*/
+
+// Allocations made by an <ActionManager>, counted in its stats.
+
+static inline void* action_manager_allocate(ActionManager* action_manager, size_t size) {
+    INPUT_STATS_ADD(&action_manager->stats, allocations, 1);
+    return input_allocator_malloc(&action_manager->allocator, size);
+}
+
+static inline void* action_manager_allocate_zeroed(ActionManager* action_manager, size_t count, size_t size) {
+    INPUT_STATS_ADD(&action_manager->stats, allocations, 1);
+    return input_allocator_calloc(&action_manager->allocator, count, size);
+}
+
+static inline void* action_manager_reallocate(ActionManager* action_manager, void* ptr, size_t size) {
+    if(ptr)
+        INPUT_STATS_ADD(&action_manager->stats, reallocations, 1);
+    else
+        INPUT_STATS_ADD(&action_manager->stats, allocations, 1);
+    return input_allocator_realloc(&action_manager->allocator, ptr, size);
+}
+
+static inline void action_manager_deallocate(ActionManager* action_manager, void* ptr) {
+    input_allocator_free(&action_manager->allocator, ptr);
+}
+
+// Checks if the bindings of an action live in the block made by <action_manager_pack>.
+static inline SDL_bool action_map_packed(const InputActionMap* map) {
+    return !map->actions && map->action_count > 0;
+}
+
+// Gets the bindings of an action, whether they're packed or in an array of their own.
+static inline InputAction* action_map_bindings(ActionManager* action_manager, InputActionMap* map) {
+    return action_map_packed(map) ? action_manager->bindings + map->binding_offset : map->actions;
+}
+
+/*
+    Replaces the bindings and value modes of every action, moving the bindings into one block like <action_manager_pack>.
+    The bindings of action n are bindings[offsets[n]] up to bindings[offsets[n + 1]], for the first action_count actions.
+*/
+SDL_bool action_manager_set_bindings(ActionManager* action_manager, const InputAction* bindings, const int* offsets, const ActionValueMode* modes, Uint32 action_count);
+
+// Compiles the registered combos into a single automaton.
+SDL_bool action_combo_compile(ActionManager* action_manager);
+
+// Advances the combo automaton using the action states of the update that just finished.
+void action_combo_update(ActionManager* action_manager);
+
+// Frees the combos and the action history.
+void action_combo_free(ActionManager* action_manager);
+
+#endif
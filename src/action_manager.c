@@ -1,11 +1,23 @@
 #include <action_manager.h>
 
 #include "std_definitions.h"
+#include "action_internal.h"
 
-static SDL_bool action_map_check_resize(InputActionMap* map) {
-    if(map->action_count == map->action_capacity) {
+static SDL_bool action_map_check_resize(ActionManager* action_manager, InputActionMap* map) {
+    // Packed actions don't have an array to write to, even after being cleared.
+    if(!map->actions || map->action_count == map->action_capacity) {
         unsigned int capacity = map->action_capacity == 0 ? 2 : map->action_capacity * 2;
-        void* buffer = input_realloc(map->actions, capacity * sizeof(*map->actions));
+        void* buffer;
+
+        // Packed bindings can't grow in place, so the action gets its own array again.
+        if(action_map_packed(map)) {
+            buffer = action_manager_allocate(action_manager, capacity * sizeof(*map->actions));
+            if(buffer)
+                input_memcpy(buffer, action_map_bindings(action_manager, map), map->action_count * sizeof(*map->actions));
+        } else {
+            buffer = action_manager_reallocate(action_manager, map->actions, capacity * sizeof(*map->actions));
+        }
+
         if(!buffer)
             return SDL_FALSE;
 
@@ -16,88 +28,1239 @@ static SDL_bool action_map_check_resize(InputActionMap* map) {
     return SDL_TRUE;
 }
 
-SDL_bool action_manager_add_key(ActionManager* action_manager, Uint32 action, SDL_Scancode key) {
+SDL_bool action_manager_add_key_direction(ActionManager* action_manager, Uint32 action, SDL_Scancode key, float x, float y) {
     InputActionMap* map = &action_manager->actions[action];
-    if(!action_map_check_resize(map))
+    if(!action_map_check_resize(action_manager, map))
         return SDL_FALSE;
 
-    map->actions[map->action_count++] = (InputAction){ .type = INPUT_ACTION_KEYBOARD, .key = key };
+    map->actions[map->action_count++] = (InputAction){ .type = INPUT_ACTION_KEYBOARD, .key = key, .x = x, .y = y };
+    action_manager->masks_dirty = SDL_TRUE;
     return SDL_TRUE;
 }
 
+SDL_bool action_manager_add_key(ActionManager* action_manager, Uint32 action, SDL_Scancode key) {
+    return action_manager_add_key_direction(action_manager, action, key, 1, 0);
+}
+
 SDL_bool action_manager_add_mouse_button(ActionManager* action_manager, Uint32 action, MouseButton button) {
     InputActionMap* map = &action_manager->actions[action];
-    if(!action_map_check_resize(map))
+    if(!action_map_check_resize(action_manager, map))
         return SDL_FALSE;
 
-    map->actions[map->action_count++] = (InputAction){ .type = INPUT_ACTION_KEYBOARD, .mouse = button };
+    map->actions[map->action_count++] = (InputAction){ .type = INPUT_ACTION_MOUSE, .mouse = button, .x = 1 };
+    action_manager->masks_dirty = SDL_TRUE;
     return SDL_TRUE;
 }
 
-SDL_bool action_manager_add_gamepad_button(ActionManager* action_manager, Uint32 action, GamepadButton button, int controller_index) {
+SDL_bool action_manager_add_gamepad_button_direction(ActionManager* action_manager, Uint32 action, GamepadButton button, int controller_index, float x, float y) {
     InputActionMap* map = &action_manager->actions[action];
-    if(!action_map_check_resize(map))
+    if(!action_map_check_resize(action_manager, map))
         return SDL_FALSE;
 
     InputAction input_action;
     input_action.type = INPUT_ACTION_GAMEPAD;
     input_action.gamepad.button = button;
     input_action.gamepad.controller_index = controller_index;
+    input_action.x = x;
+    input_action.y = y;
+
+    map->actions[map->action_count++] = input_action;
+    action_manager->masks_dirty = SDL_TRUE;
+    return SDL_TRUE;
+}
+
+SDL_bool action_manager_add_gamepad_button(ActionManager* action_manager, Uint32 action, GamepadButton button, int controller_index) {
+    return action_manager_add_gamepad_button_direction(action_manager, action, button, controller_index, 1, 0);
+}
+
+SDL_bool action_manager_add_gesture(ActionManager* action_manager, Uint32 action, InputGesture gesture) {
+    InputActionMap* map = &action_manager->actions[action];
+    if(!action_map_check_resize(action_manager, map))
+        return SDL_FALSE;
+
+    map->actions[map->action_count++] = (InputAction){ .type = INPUT_ACTION_GESTURE, .gesture = gesture, .x = 1 };
+    action_manager->masks_dirty = SDL_TRUE;
+    return SDL_TRUE;
+}
+
+SDL_bool action_manager_add_gamepad_axis(ActionManager* action_manager, Uint32 action, SDL_GameControllerAxis axis, int controller_index, float x, float y) {
+    InputActionMap* map = &action_manager->actions[action];
+    if(!action_map_check_resize(action_manager, map))
+        return SDL_FALSE;
+
+    InputAction input_action;
+    input_action.type = INPUT_ACTION_GAMEPAD_AXIS;
+    input_action.axis.axis = axis;
+    input_action.axis.controller_index = controller_index;
+    input_action.x = x;
+    input_action.y = y;
 
     map->actions[map->action_count++] = input_action;
+    action_manager->masks_dirty = SDL_TRUE;
+    return SDL_TRUE;
+}
+
+SDL_bool action_manager_add_gamepad_stick(ActionManager* action_manager, Uint32 action, InputAxisGroup stick, int controller_index, float x_scale, float y_scale) {
+    InputActionMap* map = &action_manager->actions[action];
+    if(!action_map_check_resize(action_manager, map))
+        return SDL_FALSE;
+
+    InputAction input_action;
+    input_action.type = INPUT_ACTION_GAMEPAD_STICK;
+    input_action.stick.group = stick;
+    input_action.stick.controller_index = controller_index;
+    input_action.x = x_scale;
+    input_action.y = y_scale;
+
+    map->actions[map->action_count++] = input_action;
+    action_manager->masks_dirty = SDL_TRUE;
     return SDL_TRUE;
 }
 
 void action_manager_clear_action(ActionManager* action_manager, Uint32 action) {
     action_manager->actions[action].action_count = 0;
+    action_manager->masks_dirty = SDL_TRUE;
+}
+
+int action_manager_add_layer(ActionManager* action_manager, Uint32 first_action, Uint32 action_count, int priority, SDL_bool consume) {
+    if(action_count == 0 || first_action >= (Uint32)action_manager->action_count || action_count > (Uint32)action_manager->action_count - first_action)
+        return -1;
+
+    for(int i = 0; i < action_manager->layer_count; i++) {
+        ActionLayer* layer = &action_manager->layers[i];
+        if(first_action < layer->first_action + layer->action_count && layer->first_action < first_action + action_count)
+            return -1;
+    }
+
+    if(action_manager->layer_count == action_manager->layer_capacity) {
+        int capacity = action_manager->layer_capacity == 0 ? 4 : action_manager->layer_capacity * 2;
+        void* buffer = action_manager_reallocate(action_manager, action_manager->layers, capacity * sizeof(*action_manager->layers));
+        if(!buffer)
+            return -1;
+
+        action_manager->layers = buffer;
+        action_manager->layer_capacity = capacity;
+    }
+
+    ActionLayer* layer = &action_manager->layers[action_manager->layer_count];
+    layer->first_action = first_action;
+    layer->action_count = action_count;
+    layer->priority = priority;
+    layer->consume = consume;
+    layer->enabled = SDL_FALSE;
+    layer->order = 0;
+
+    action_manager->masks_dirty = SDL_TRUE;
+    return action_manager->layer_count++;
+}
+
+void action_manager_push_layer(ActionManager* action_manager, int layer) {
+    action_manager->layers[layer].order = ++action_manager->layer_order;
+    action_manager->layers[layer].enabled = SDL_TRUE;
+    action_manager->layers_dirty = SDL_TRUE;
+}
+
+int action_manager_pop_layer(ActionManager* action_manager) {
+    int top = -1;
+    for(int i = 0; i < action_manager->layer_count; i++) {
+        ActionLayer* layer = &action_manager->layers[i];
+        if(layer->enabled && (top == -1 || layer->order > action_manager->layers[top].order))
+            top = i;
+    }
+
+    if(top != -1)
+        action_manager_set_layer_enabled(action_manager, top, SDL_FALSE);
+
+    return top;
+}
+
+void action_manager_set_layer_enabled(ActionManager* action_manager, int layer, SDL_bool enabled) {
+    if(action_manager->layers[layer].enabled == enabled)
+        return;
+
+    action_manager->layers[layer].enabled = enabled;
+    action_manager->layers_dirty = SDL_TRUE;
+}
+
+// Checks if layer a sits above layer b.
+static SDL_bool action_layer_above(ActionLayer* a, ActionLayer* b) {
+    return a->priority > b->priority || (a->priority == b->priority && a->order > b->order);
+}
+
+// Copies the entries of a reverse index, keeping only the actions in enabled layers.
+static void action_index_filter(const int* offsets, const int* actions, int entries, const Uint64* active, int* active_offsets, int* active_actions) {
+    int total = 0;
+    for(int entry = 0; entry < entries; entry++) {
+        active_offsets[entry] = total;
+        for(int i = offsets[entry]; i < offsets[entry + 1]; i++) {
+            if(input_bitset_test(active, actions[i]))
+                active_actions[total++] = actions[i];
+        }
+    }
+    active_offsets[entries] = total;
+}
+
+/*
+    Recalculates the actions that are enabled and the inputs consumed by the layers above each one.
+    Only happens after a layer changes, so the updates in between don't pay for the layers.
+*/
+static void action_manager_update_layers(ActionManager* action_manager) {
+    ActionBindingMasks* masks = &action_manager->masks;
+    int layer_count = action_manager->layer_count;
+    int slots = masks->gamepad_slots;
+
+    // The actions outside of the layers are always enabled.
+    input_memset(masks->active, 0, sizeof(Uint64) * INPUT_BITSET_WORDS(action_manager->action_count));
+    for(int span = 0; span < masks->span_count; span++) {
+        int layer = masks->spans[span].layer;
+        if(layer != layer_count && !action_manager->layers[layer].enabled)
+            continue;
+
+        for(int i = masks->spans[span].start; i < masks->spans[span].end; i++)
+            input_bitset_set(masks->active, i);
+    }
+
+    // The updates only walk these copies, so the actions of disabled layers are never marked or evaluated.
+    action_index_filter(masks->key_offsets, masks->key_actions, SDL_NUM_SCANCODES, masks->active, masks->active_key_offsets, masks->active_key_actions);
+    action_index_filter(masks->mouse_offsets, masks->mouse_actions, 32, masks->active, masks->active_mouse_offsets, masks->active_mouse_actions);
+    action_index_filter(masks->gamepad_offsets, masks->gamepad_actions, slots * INPUT_GAMEPAD_BUTTON_BITS, masks->active, masks->active_gamepad_offsets, masks->active_gamepad_actions);
+    action_index_filter(masks->gesture_offsets, masks->gesture_actions, INPUT_GESTURE_MAX, masks->active, masks->active_gesture_offsets, masks->active_gesture_actions);
+
+    masks->active_value_count = 0;
+    for(int i = 0; i < masks->value_count; i++) {
+        if(input_bitset_test(masks->active, masks->value_actions[i]))
+            masks->active_value_actions[masks->active_value_count++] = masks->value_actions[i];
+    }
+
+    for(int word = 0; word < INPUT_BITSET_WORDS(action_manager->action_count); word++)
+        masks->active_fallback[word] = masks->fallback[word] & masks->active[word];
+
+    // Each layer is blocked by the consuming layers above it. Layers are rare, so they're compared directly.
+    for(int i = 0; i <= layer_count; i++) {
+        ActionInputMask* blocked = &masks->layer_blocked[i];
+        input_memset(blocked->keys, 0, sizeof(blocked->keys));
+        blocked->mouse = 0;
+        blocked->gestures = 0;
+        input_memset(blocked->gamepad, 0, sizeof(*blocked->gamepad) * slots);
+
+        if(i != layer_count && !action_manager->layers[i].enabled)
+            continue;
+
+        for(int j = 0; j < layer_count; j++) {
+            ActionLayer* other = &action_manager->layers[j];
+            if(j == i || !other->enabled || !other->consume)
+                continue;
+            if(i != layer_count && !action_layer_above(other, &action_manager->layers[i]))
+                continue;
+
+            ActionInputMask* inputs = &masks->layer_inputs[j];
+            for(int word = 0; word < INPUT_KEYBOARD_WORDS; word++)
+                blocked->keys[word] |= inputs->keys[word];
+            blocked->mouse |= inputs->mouse;
+            blocked->gestures |= inputs->gestures;
+            for(int slot = 0; slot < slots; slot++)
+                blocked->gamepad[slot] |= inputs->gamepad[slot];
+        }
+    }
+
+    // The consumed inputs changed, so every action has to be evaluated again.
+    masks->primed = SDL_FALSE;
+    action_manager->layers_dirty = SDL_FALSE;
 }
 
 ActionManager* action_manager_create(Uint32 action_count) {
-    ActionManager* action_manager = input_malloc(sizeof(*action_manager));
-    if(!action_manager)
-        return NULL;
+    return action_manager_create_with_allocator(action_count, NULL);
+}
+
+ActionManager* action_manager_create_with_allocator(Uint32 action_count, const InputAllocator* allocator) {
+    InputAllocator copy = allocator ? *allocator : (InputAllocator){ 0 };
 
-    InputActionMap* actions = input_calloc(action_count, sizeof(*actions));
-    if(!actions) {
-        input_free(action_manager);
+    // The manager, the state of every action and the action maps share one allocation.
+    // The state holds the current and previous bitsets, then the history and value of each action,
+    // with the two value arrays taking up one word per action.
+    int words = INPUT_BITSET_WORDS(action_count);
+    int history_frame_words = (action_count + 1) / 2;
+    size_t state_words = words * 2 + action_count + history_frame_words + action_count;
+    Uint8* block = input_allocator_calloc(&copy, 1, sizeof(ActionManager) + sizeof(Uint64) * state_words + sizeof(InputActionMap) * action_count);
+    if(!block)
         return NULL;
-    }
+
+    ActionManager* action_manager = (ActionManager*)block;
+    Uint64* state = (Uint64*)(block + sizeof(ActionManager));
+    InputActionMap* actions = (InputActionMap*)(state + state_words);
+
+    action_manager->allocator = copy;
+    action_manager->actions = actions;
+    action_manager->action_count = action_count;
+    action_manager->current = state;
+    action_manager->previous = state + words;
+    action_manager->action_history = state + words * 2;
+    action_manager->action_history_frames = (Uint32*)(action_manager->action_history + action_count);
+    action_manager->value_x = (float*)(action_manager->action_history + action_count + history_frame_words);
+    action_manager->value_y = action_manager->value_x + action_count;
+    action_manager->analog_threshold = 0.5f;
+    action_manager->masks = (ActionBindingMasks){ 0 };
+    action_manager->masks_dirty = SDL_TRUE;
+    action_manager->incremental = SDL_TRUE;
+    action_manager->combos = NULL;
+    action_manager->combo_count = 0;
+    action_manager->combo_capacity = 0;
+    action_manager->combo_matcher = (ActionComboMatcher){ 0 };
+    action_manager->combos_dirty = SDL_FALSE;
+    action_manager->history = NULL;
+    action_manager->history_length = 0;
+    action_manager->frame = 0;
+    action_manager->layers = NULL;
+    action_manager->layer_count = 0;
+    action_manager->layer_capacity = 0;
+    action_manager->layers_dirty = SDL_FALSE;
+    action_manager->layer_order = 0;
+    action_manager->bindings = NULL;
+    action_manager->binding_count = 0;
 
     return action_manager;
 }
 
 void action_manager_free(ActionManager* action_manager) {
+    InputAllocator allocator = action_manager->allocator;
+    // Packed actions don't have an array of their own, so this only frees the ones added to after packing.
+    for(int i = 0; i < action_manager->action_count; i++)
+        input_allocator_free(&allocator, action_manager->actions[i].actions);
+
+    action_combo_free(action_manager);
+    input_allocator_free(&allocator, action_manager->bindings);
+    input_allocator_free(&allocator, action_manager->masks.keys);
+    input_allocator_free(&allocator, action_manager->layers);
+    input_allocator_free(&allocator, action_manager);
+}
+
+SDL_bool action_manager_pack(ActionManager* action_manager) {
+    int total = 0;
+    for(int i = 0; i < action_manager->action_count; i++)
+        total += action_manager->actions[i].action_count;
+
+    InputAction* bindings = action_manager_allocate(action_manager, sizeof(*bindings) * (total > 0 ? total : 1));
+    if(!bindings)
+        return SDL_FALSE;
+
+    // The bindings are copied in action order, so evaluating the actions one after another reads them front to back.
+    int offset = 0;
     for(int i = 0; i < action_manager->action_count; i++) {
-        input_free(action_manager->actions[i].actions);
+        InputActionMap* map = &action_manager->actions[i];
+        if(map->action_count > 0)
+            input_memcpy(bindings + offset, action_map_bindings(action_manager, map), sizeof(*bindings) * map->action_count);
+
+        action_manager_deallocate(action_manager, map->actions);
+        map->actions = NULL;
+        map->binding_offset = offset;
+        map->action_capacity = map->action_count;
+        offset += map->action_count;
     }
 
-    input_free(action_manager->actions);
-    input_free(action_manager);
+    action_manager_deallocate(action_manager, action_manager->bindings);
+    action_manager->bindings = bindings;
+    action_manager->binding_count = total;
+    return SDL_TRUE;
 }
 
-static void input_update_action_map(InputActionMap* map, InputManager* input) {
-    map->previous = map->current;
+SDL_bool action_manager_set_bindings(ActionManager* action_manager, const InputAction* bindings, const int* offsets, const ActionValueMode* modes, Uint32 action_count) {
+    Uint32 count = action_count < (Uint32)action_manager->action_count ? action_count : (Uint32)action_manager->action_count;
+    int total = offsets[count];
 
+    InputAction* block = action_manager_allocate(action_manager, sizeof(*block) * (total > 0 ? total : 1));
+    if(!block)
+        return SDL_FALSE;
+
+    if(total > 0)
+        input_memcpy(block, bindings, sizeof(*block) * total);
+
+    for(int i = 0; i < action_manager->action_count; i++) {
+        InputActionMap* map = &action_manager->actions[i];
+        action_manager_deallocate(action_manager, map->actions);
+
+        int binding_count = (Uint32)i < count ? offsets[i + 1] - offsets[i] : 0;
+        map->actions = NULL;
+        map->binding_offset = (Uint32)i < count ? offsets[i] : total;
+        map->action_count = binding_count;
+        map->action_capacity = binding_count;
+        map->value_mode = (Uint32)i < count ? modes[i] : ACTION_VALUE_MAX_MAGNITUDE;
+    }
+
+    action_manager_deallocate(action_manager, action_manager->bindings);
+    action_manager->bindings = block;
+    action_manager->binding_count = total;
+    action_manager->masks_dirty = SDL_TRUE;
+    return SDL_TRUE;
+}
+
+// Gets the reverse index entry for a gamepad binding, or -1 if it can't be bound.
+static int action_gamepad_index_entry(InputAction* binding, int slots) {
+    int slot = binding->gamepad.controller_index + 1;
+    if(slot < 0 || slot >= slots || binding->gamepad.button >= INPUT_GAMEPAD_BUTTON_BITS)
+        return -1;
+
+    return slot * INPUT_GAMEPAD_BUTTON_BITS + binding->gamepad.button;
+}
+
+// Turns per-entry counts into offsets, leaving offsets[n] at the start of entry n.
+static void action_index_offsets(int* offsets, int entries) {
+    int total = 0;
+    for(int i = 0; i < entries; i++) {
+        int count = offsets[i];
+        offsets[i] = total;
+        total += count;
+    }
+    offsets[entries] = total;
+}
+
+// Checks if an action can have a value other than 0 or 1.
+static SDL_bool action_map_has_value(ActionManager* action_manager, InputActionMap* map) {
+    InputAction* bindings = action_map_bindings(action_manager, map);
     for(int i = 0; i < map->action_count; i++) {
-        InputAction* action = &map->actions[i];
-        switch(action->type) {
-            case INPUT_ACTION_KEYBOARD:
-                map->current = input_key_check(input, action->key);
-                break;
-            case INPUT_ACTION_GAMEPAD:
-                map->current = input_gamepad_check_index(input, action->gamepad.button, action->gamepad.controller_index);
-                break;
-            case INPUT_ACTION_MOUSE:
-                map->current = input_mouse_check(input, action->mouse);
-                break;
+        InputAction* binding = &bindings[i];
+        if(binding->type == INPUT_ACTION_GAMEPAD_AXIS ||
+           binding->type == INPUT_ACTION_GAMEPAD_STICK ||
+           binding->x != 1 ||
+           binding->y != 0)
+        {
+            return SDL_TRUE;
+        }
+    }
+
+    return SDL_FALSE;
+}
+
+SDL_bool action_manager_compile(ActionManager* action_manager) {
+    int count = action_manager->action_count;
+    int action_words = INPUT_BITSET_WORDS(count);
+    int slots = 1;
+    int key_bindings = 0;
+    int mouse_bindings = 0;
+    int gamepad_bindings = 0;
+    int gesture_bindings = 0;
+    int value_actions = 0;
+
+    for(int i = 0; i < count; i++) {
+        InputActionMap* map = &action_manager->actions[i];
+        if(action_map_has_value(action_manager, map))
+            value_actions++;
+
+        InputAction* bindings = action_map_bindings(action_manager, map);
+        for(int j = 0; j < map->action_count; j++) {
+            InputAction* binding = &bindings[j];
+            switch(binding->type) {
+                case INPUT_ACTION_KEYBOARD:
+                    key_bindings++;
+                    break;
+                case INPUT_ACTION_MOUSE:
+                    mouse_bindings += input_bits_count(binding->mouse);
+                    break;
+                case INPUT_ACTION_GAMEPAD:
+                    gamepad_bindings++;
+                    if(binding->gamepad.controller_index >= 0 && binding->gamepad.controller_index + 2 > slots)
+                    {
+                        slots = binding->gamepad.controller_index + 2;
+                    }
+                    break;
+                case INPUT_ACTION_GESTURE:
+                    gesture_bindings++;
+                    break;
+                default:
+                    break;
+            }
         }
+    }
+
+    int key_entries = SDL_NUM_SCANCODES;
+    int mouse_entries = 32;
+    int gamepad_entries = slots * INPUT_GAMEPAD_BUTTON_BITS;
+    int gesture_entries = INPUT_GESTURE_MAX;
+    // Every layer gets its own input masks, and so do the actions outside of the layers.
+    int layers = action_manager->layer_count + 1;
+    int max_spans = action_manager->layer_count * 2 + 1;
+
+    // All of the masks live in one block that's owned by the keys pointer.
+    // The 64 bit arrays come first to keep everything aligned.
+    size_t key_size = sizeof(Uint64) * INPUT_KEYBOARD_WORDS * count;
+    size_t hits_size = sizeof(Uint64) * count;
+    size_t bitset_size = sizeof(Uint64) * action_words;
+    size_t mouse_size = sizeof(MouseButton) * count;
+    size_t gamepad_size = sizeof(GamepadButtonMask) * slots * count;
+    size_t gamepad_state_size = sizeof(GamepadButtonMask) * slots;
+    size_t gesture_size = sizeof(GestureMask) * count;
+    size_t layer_mask_size = sizeof(ActionInputMask) * layers;
+    size_t layer_gamepad_size = sizeof(GamepadButtonMask) * slots * layers;
+    size_t span_size = sizeof(ActionLayerSpan) * max_spans;
+    size_t index_size = sizeof(int) * (key_entries + 1 + key_bindings +
+                                       mouse_entries + 1 + mouse_bindings +
+                                       gamepad_entries + 1 + gamepad_bindings +
+                                       gesture_entries + 1 + gesture_bindings +
+                                       value_actions + count);
+    // The copies that only hold the actions in enabled layers need the same room, apart from the layer of each action.
+    size_t active_index_size = index_size - sizeof(int) * count;
+
+    action_manager_deallocate(action_manager, action_manager->masks.keys);
+    action_manager->masks = (ActionBindingMasks){ 0 };
+
+    Uint8* block = action_manager_allocate_zeroed(action_manager, 1, key_size + hits_size + bitset_size * 4 + layer_mask_size * 2 + mouse_size + gamepad_size +
+                                   gamepad_state_size + gesture_size + layer_gamepad_size * 2 + span_size + index_size + active_index_size);
+    if(!block)
+        return SDL_FALSE;
 
-        if(map->current)
-            return;
+    ActionBindingMasks* masks = &action_manager->masks;
+    masks->keys = (Uint64*)block;
+    block += key_size;
+    masks->hits = (Uint64*)block;
+    block += hits_size;
+    masks->fallback = (Uint64*)block;
+    block += bitset_size;
+    masks->dirty = (Uint64*)block;
+    block += bitset_size;
+    masks->active = (Uint64*)block;
+    block += bitset_size;
+    masks->active_fallback = (Uint64*)block;
+    block += bitset_size;
+    masks->gamepad = (GamepadButtonMask*)block;
+    block += gamepad_size;
+    masks->gamepad_state = (GamepadButtonMask*)block;
+    block += gamepad_state_size;
+    GamepadButtonMask* layer_gamepads = (GamepadButtonMask*)block;
+    block += layer_gamepad_size * 2;
+    masks->layer_inputs = (ActionInputMask*)block;
+    block += layer_mask_size;
+    masks->layer_blocked = (ActionInputMask*)block;
+    block += layer_mask_size;
+    for(int i = 0; i < layers; i++) {
+        masks->layer_inputs[i].gamepad = layer_gamepads + i * slots;
+        masks->layer_blocked[i].gamepad = layer_gamepads + (layers + i) * slots;
+    }
+    masks->spans = (ActionLayerSpan*)block;
+    block += span_size;
+    masks->mouse = (MouseButton*)block;
+    block += mouse_size;
+    masks->gestures = (GestureMask*)block;
+    block += gesture_size;
+    masks->key_offsets = (int*)block;
+    masks->key_actions = masks->key_offsets + key_entries + 1;
+    masks->mouse_offsets = masks->key_actions + key_bindings;
+    masks->mouse_actions = masks->mouse_offsets + mouse_entries + 1;
+    masks->gamepad_offsets = masks->mouse_actions + mouse_bindings;
+    masks->gamepad_actions = masks->gamepad_offsets + gamepad_entries + 1;
+    masks->gesture_offsets = masks->gamepad_actions + gamepad_bindings;
+    masks->gesture_actions = masks->gesture_offsets + gesture_entries + 1;
+    masks->value_actions = masks->gesture_actions + gesture_bindings;
+    masks->action_layers = masks->value_actions + value_actions;
+    masks->active_key_offsets = masks->action_layers + count;
+    masks->active_key_actions = masks->active_key_offsets + key_entries + 1;
+    masks->active_mouse_offsets = masks->active_key_actions + key_bindings;
+    masks->active_mouse_actions = masks->active_mouse_offsets + mouse_entries + 1;
+    masks->active_gamepad_offsets = masks->active_mouse_actions + mouse_bindings;
+    masks->active_gamepad_actions = masks->active_gamepad_offsets + gamepad_entries + 1;
+    masks->active_gesture_offsets = masks->active_gamepad_actions + gamepad_bindings;
+    masks->active_gesture_actions = masks->active_gesture_offsets + gesture_entries + 1;
+    masks->active_value_actions = masks->active_gesture_actions + gesture_bindings;
+    masks->gamepad_slots = slots;
+
+    for(int i = 0; i < count; i++)
+        masks->action_layers[i] = action_manager->layer_count;
+
+    for(int i = 0; i < action_manager->layer_count; i++) {
+        ActionLayer* layer = &action_manager->layers[i];
+        for(Uint32 j = 0; j < layer->action_count; j++)
+            masks->action_layers[layer->first_action + j] = i;
+    }
+
+    for(int i = 0; i < count; i++) {
+        if(masks->span_count == 0 || masks->spans[masks->span_count - 1].layer != masks->action_layers[i])
+            masks->spans[masks->span_count++] = (ActionLayerSpan){ i, i, masks->action_layers[i] };
+        masks->spans[masks->span_count - 1].end = i + 1;
+    }
+
+    // First pass builds the masks and counts the entries of the reverse index.
+    for(int i = 0; i < count; i++) {
+        InputActionMap* map = &action_manager->actions[i];
+        if(action_map_has_value(action_manager, map))
+            masks->value_actions[masks->value_count++] = i;
+
+        ActionInputMask* layer_inputs = &masks->layer_inputs[masks->action_layers[i]];
+        InputAction* bindings = action_map_bindings(action_manager, map);
+        for(int j = 0; j < map->action_count; j++) {
+            InputAction* binding = &bindings[j];
+            switch(binding->type) {
+                case INPUT_ACTION_KEYBOARD:
+                    if(binding->key >= 0 && binding->key < SDL_NUM_SCANCODES) {
+                        int word = binding->key >> 6;
+                        masks->keys[word * count + i] |= (Uint64)1 << (binding->key & 63);
+                        masks->key_words |= 1u << word;
+                        masks->key_offsets[binding->key]++;
+                        layer_inputs->keys[word] |= (Uint64)1 << (binding->key & 63);
+                    }
+                    break;
+                case INPUT_ACTION_MOUSE:
+                    // A mouse binding matches when all of its buttons are down,
+                    // which can only be ORed with the others when it's a single button.
+                    if(input_bits_count(binding->mouse) == 1)
+                        masks->mouse[i] |= binding->mouse;
+                    else
+                        input_bitset_set(masks->fallback, i);
+
+                    for(MouseButton buttons = binding->mouse; buttons; buttons &= buttons - 1)
+                        masks->mouse_offsets[input_bits_lowest(buttons)]++;
+                    layer_inputs->mouse |= binding->mouse;
+                    break;
+                case INPUT_ACTION_GAMEPAD: {
+                    int entry = action_gamepad_index_entry(binding, slots);
+                    if(entry != -1) {
+                        masks->gamepad[(entry / INPUT_GAMEPAD_BUTTON_BITS) * count + i] |= ___INPUT_GAMEPAD_BUTTON(binding->gamepad.button);
+                        masks->gamepad_offsets[entry]++;
+                        layer_inputs->gamepad[entry / INPUT_GAMEPAD_BUTTON_BITS] |= ___INPUT_GAMEPAD_BUTTON(binding->gamepad.button);
+                    }
+                    break;
+                }
+                case INPUT_ACTION_GESTURE:
+                    if(binding->gesture >= 0 && binding->gesture < INPUT_GESTURE_MAX) {
+                        masks->gestures[i] |= INPUT_GESTURE_BIT(binding->gesture);
+                        masks->gesture_offsets[binding->gesture]++;
+                        layer_inputs->gestures |= INPUT_GESTURE_BIT(binding->gesture);
+                    }
+                    break;
+                default:
+                    // Analog bindings are compared against the threshold every update.
+                    input_bitset_set(masks->fallback, i);
+                    break;
+            }
+        }
+    }
+
+    action_index_offsets(masks->key_offsets, key_entries);
+    action_index_offsets(masks->mouse_offsets, mouse_entries);
+    action_index_offsets(masks->gamepad_offsets, gamepad_entries);
+    action_index_offsets(masks->gesture_offsets, gesture_entries);
+
+    // Second pass fills in the reverse index, using the offsets as write cursors.
+    // Afterwards each offset has moved to the start of the next entry, so they're shifted back.
+    for(int i = 0; i < count; i++) {
+        InputActionMap* map = &action_manager->actions[i];
+        InputAction* bindings = action_map_bindings(action_manager, map);
+        for(int j = 0; j < map->action_count; j++) {
+            InputAction* binding = &bindings[j];
+            switch(binding->type) {
+                case INPUT_ACTION_KEYBOARD:
+                    if(binding->key >= 0 && binding->key < SDL_NUM_SCANCODES)
+                        masks->key_actions[masks->key_offsets[binding->key]++] = i;
+                    break;
+                case INPUT_ACTION_MOUSE:
+                    for(MouseButton buttons = binding->mouse; buttons; buttons &= buttons - 1) {
+                        int bit = input_bits_lowest(buttons);
+                        masks->mouse_actions[masks->mouse_offsets[bit]++] = i;
+                    }
+                    break;
+                case INPUT_ACTION_GAMEPAD: {
+                    int entry = action_gamepad_index_entry(binding, slots);
+                    if(entry != -1)
+                        masks->gamepad_actions[masks->gamepad_offsets[entry]++] = i;
+                    break;
+                }
+                case INPUT_ACTION_GESTURE:
+                    if(binding->gesture >= 0 && binding->gesture < INPUT_GESTURE_MAX)
+                        masks->gesture_actions[masks->gesture_offsets[binding->gesture]++] = i;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    input_memmove(masks->key_offsets + 1, masks->key_offsets, sizeof(int) * key_entries);
+    masks->key_offsets[0] = 0;
+    input_memmove(masks->mouse_offsets + 1, masks->mouse_offsets, sizeof(int) * mouse_entries);
+    masks->mouse_offsets[0] = 0;
+    input_memmove(masks->gamepad_offsets + 1, masks->gamepad_offsets, sizeof(int) * gamepad_entries);
+    masks->gamepad_offsets[0] = 0;
+    input_memmove(masks->gesture_offsets + 1, masks->gesture_offsets, sizeof(int) * gesture_entries);
+    masks->gesture_offsets[0] = 0;
+
+    action_manager->masks_dirty = SDL_FALSE;
+    action_manager->layers_dirty = SDL_TRUE;
+    return SDL_TRUE;
+}
+
+// Gets the value an analog binding adds to its action.
+static void input_action_analog(InputAction* action, InputManager* input, float* x, float* y) {
+    if(action->type == INPUT_ACTION_GAMEPAD_AXIS) {
+        float value = input_gamepad_axis(input, action->axis.axis, action->axis.controller_index);
+        *x = value * action->x;
+        *y = value * action->y;
+    } else {
+        // The axes of each group are next to each other, starting with SDL_CONTROLLER_AXIS_LEFTX.
+        SDL_GameControllerAxis axis = (SDL_GameControllerAxis)(action->stick.group * 2);
+        *x = input_gamepad_axis(input, axis, action->stick.controller_index) * action->x;
+        *y = input_gamepad_axis(input, axis + 1, action->stick.controller_index) * action->y;
     }
 }
 
+static SDL_bool input_action_check(InputAction* action, InputManager* input, float threshold) {
+    switch(action->type) {
+        case INPUT_ACTION_KEYBOARD:
+            return input_key_check(input, action->key);
+        case INPUT_ACTION_GAMEPAD:
+            return input_gamepad_check_index(input, action->gamepad.button, action->gamepad.controller_index);
+        case INPUT_ACTION_MOUSE:
+            return input_mouse_check(input, action->mouse);
+        case INPUT_ACTION_GESTURE:
+            return input_gesture_check(input, action->gesture);
+        case INPUT_ACTION_GAMEPAD_AXIS:
+        case INPUT_ACTION_GAMEPAD_STICK: {
+            float x, y;
+            input_action_analog(action, input, &x, &y);
+            return x * x + y * y >= threshold * threshold;
+        }
+    }
+
+    return SDL_FALSE;
+}
+
+// Checks if a binding uses an input that's consumed by a higher layer. Analog bindings can't be consumed.
+static SDL_bool input_action_blocked(InputAction* action, const ActionInputMask* blocked, int slots) {
+    switch(action->type) {
+        case INPUT_ACTION_KEYBOARD:
+            return action->key >= 0 && action->key < SDL_NUM_SCANCODES && input_bitset_test(blocked->keys, action->key);
+        case INPUT_ACTION_GAMEPAD: {
+            int slot = action->gamepad.controller_index + 1;
+            return slot >= 0 && slot < slots && action->gamepad.button < INPUT_GAMEPAD_BUTTON_BITS &&
+                   (blocked->gamepad[slot] & ___INPUT_GAMEPAD_BUTTON(action->gamepad.button)) != 0;
+        }
+        case INPUT_ACTION_MOUSE:
+            return (action->mouse & blocked->mouse) != 0;
+        case INPUT_ACTION_GESTURE:
+            return action->gesture >= 0 && action->gesture < INPUT_GESTURE_MAX && (blocked->gestures & INPUT_GESTURE_BIT(action->gesture)) != 0;
+        default:
+            return SDL_FALSE;
+    }
+}
+
+// Gets the inputs consumed by the layers above an action, or NULL if the masks aren't available.
+static const ActionInputMask* action_manager_blocked(ActionManager* action_manager, int action) {
+    ActionBindingMasks* masks = &action_manager->masks;
+    if(action_manager->masks_dirty || !masks->action_layers)
+        return NULL;
+
+    return &masks->layer_blocked[masks->action_layers[action]];
+}
+
+// Checks if a binding is down and isn't consumed by a higher layer.
+static SDL_bool action_manager_check_binding(ActionManager* action_manager, InputManager* input, InputAction* binding, const ActionInputMask* blocked) {
+    if(blocked && input_action_blocked(binding, blocked, action_manager->masks.gamepad_slots))
+        return SDL_FALSE;
+
+    return input_action_check(binding, input, action_manager->analog_threshold);
+}
+
+// Evaluates an action one binding at a time.
+static SDL_bool action_manager_check_map(ActionManager* action_manager, InputManager* input, int action) {
+    InputActionMap* map = &action_manager->actions[action];
+    const ActionInputMask* blocked = action_manager_blocked(action_manager, action);
+    InputAction* bindings = action_map_bindings(action_manager, map);
+    for(int i = 0; i < map->action_count; i++) {
+        if(action_manager_check_binding(action_manager, input, &bindings[i], blocked))
+            return SDL_TRUE;
+    }
+
+    return SDL_FALSE;
+}
+
+// Limits a value to a magnitude of 1.
+static void action_value_clamp(float* x, float* y) {
+    float length = *x * *x + *y * *y;
+    if(length > 1) {
+        length = SDL_sqrtf(length);
+        *x /= length;
+        *y /= length;
+    }
+}
+
+// Combines the bindings of an action into its value.
+static void action_manager_update_value(ActionManager* action_manager, InputManager* input, int action) {
+    InputActionMap* map = &action_manager->actions[action];
+    const ActionInputMask* blocked = action_manager_blocked(action_manager, action);
+    float button_x = 0;
+    float button_y = 0;
+    float value_x = 0;
+    float value_y = 0;
+
+    InputAction* bindings = action_map_bindings(action_manager, map);
+    for(int i = 0; i < map->action_count; i++) {
+        InputAction* binding = &bindings[i];
+        if(binding->type == INPUT_ACTION_GAMEPAD_AXIS || binding->type == INPUT_ACTION_GAMEPAD_STICK) {
+            float x, y;
+            input_action_analog(binding, input, &x, &y);
+            if(map->value_mode == ACTION_VALUE_SUM) {
+                value_x += x;
+                value_y += y;
+            } else if(x * x + y * y > value_x * value_x + value_y * value_y) {
+                value_x = x;
+                value_y = y;
+            }
+        } else if(action_manager_check_binding(action_manager, input, binding, blocked)) {
+            button_x += binding->x;
+            button_y += binding->y;
+        }
+    }
+
+    // Opposite buttons cancel out, and the same direction from two devices doesn't double up.
+    button_x = SDL_clamp(button_x, -1.0f, 1.0f);
+    button_y = SDL_clamp(button_y, -1.0f, 1.0f);
+    action_value_clamp(&button_x, &button_y);
+
+    if(map->value_mode == ACTION_VALUE_SUM) {
+        value_x += button_x;
+        value_y += button_y;
+        action_value_clamp(&value_x, &value_y);
+    } else if(button_x * button_x + button_y * button_y > value_x * value_x + value_y * value_y) {
+        value_x = button_x;
+        value_y = button_y;
+    }
+
+    action_manager->value_x[action] = value_x;
+    action_manager->value_y[action] = value_y;
+}
+
+// Updates the value of every action from its state, then evaluates the actions that have analog values.
+static void action_manager_update_values(ActionManager* action_manager, InputManager* input, SDL_bool all) {
+    int count = action_manager->action_count;
+    int words = INPUT_BITSET_WORDS(count);
+
+    if(all) {
+        for(int i = 0; i < count; i++) {
+            action_manager->value_x[i] = input_bitset_test(action_manager->current, i) ? 1.0f : 0.0f;
+            action_manager->value_y[i] = 0;
+        }
+    } else {
+        for(int word = 0; word < words; word++) {
+            for(Uint64 changed = action_manager->current[word] ^ action_manager->previous[word]; changed; changed &= changed - 1) {
+                int action = word * 64 + input_bits_lowest(changed);
+                action_manager->value_x[action] = input_bitset_test(action_manager->current, action) ? 1.0f : 0.0f;
+            }
+        }
+    }
+
+    if(action_manager->masks_dirty) {
+        for(int i = 0; i < count; i++)
+            action_manager_update_value(action_manager, input, i);
+    } else {
+        ActionBindingMasks* masks = &action_manager->masks;
+        for(int i = 0; i < masks->active_value_count; i++)
+            action_manager_update_value(action_manager, input, masks->active_value_actions[i]);
+    }
+}
+
+static void action_manager_set_state(ActionManager* action_manager, int action, SDL_bool state) {
+    if(state)
+        input_bitset_set(action_manager->current, action);
+    else
+        input_bitset_clear(action_manager->current, action);
+}
+
+static GamepadButtonMask action_manager_slot_state(InputManager* input, int slot) {
+    // Mask slot 0 holds the bindings for the first controller, the rest are player slots offset by one.
+    InputGamepad* gamepad = input_gamepad_get(input, slot - 1);
+    return gamepad ? gamepad->button_current : 0;
+}
+
+// Evaluates every action in an enabled layer against the device state using the compiled masks.
+static void action_manager_update_masks(ActionManager* action_manager, InputManager* input) {
+    ActionBindingMasks* masks = &action_manager->masks;
+    int count = action_manager->action_count;
+    int words = INPUT_BITSET_WORDS(count);
+    Uint64* hits = masks->hits;
+
+    for(int slot = 0; slot < masks->gamepad_slots; slot++)
+        masks->gamepad_state[slot] = action_manager_slot_state(input, slot);
+
+    input_memset(action_manager->current, 0, sizeof(Uint64) * words);
+
+    // Each span is evaluated against the inputs that aren't consumed by the layers above it.
+    // Spans of disabled layers are skipped, leaving their actions up.
+    for(int span = 0; span < masks->span_count; span++) {
+        int start = masks->spans[span].start;
+        int end = masks->spans[span].end;
+        if(!input_bitset_test(masks->active, start))
+            continue;
+
+        const ActionInputMask* blocked = &masks->layer_blocked[masks->spans[span].layer];
+        input_memset(hits + start, 0, sizeof(*hits) * (end - start));
+
+        // Words that don't have any keys held can't match anything, so they're skipped entirely.
+        for(int word = 0; word < INPUT_KEYBOARD_WORDS; word++) {
+            Uint64 state = input->keyboard_current[word] & ~blocked->keys[word];
+            if(!(masks->key_words & (1u << word)) || !state)
+                continue;
+
+            const Uint64* keys = masks->keys + word * count;
+            for(int i = start; i < end; i++)
+                hits[i] |= keys[i] & state;
+        }
+
+        MouseButton mouse = input->mouse_current & ~blocked->mouse;
+        if(mouse) {
+            for(int i = start; i < end; i++)
+                hits[i] |= masks->mouse[i] & mouse;
+        }
+
+        for(int slot = 0; slot < masks->gamepad_slots; slot++) {
+            GamepadButtonMask state = masks->gamepad_state[slot] & ~blocked->gamepad[slot];
+            if(!state)
+                continue;
+
+            const GamepadButtonMask* gamepad = masks->gamepad + slot * count;
+            for(int i = start; i < end; i++)
+                hits[i] |= gamepad[i] & state;
+        }
+
+        GestureMask gestures = input->gesture_current & ~blocked->gestures;
+        if(gestures) {
+            for(int i = start; i < end; i++)
+                hits[i] |= masks->gestures[i] & gestures;
+        }
+
+        for(int i = start; i < end; i++)
+            action_manager->current[i >> 6] |= (Uint64)(hits[i] != 0) << (i & 63);
+    }
+
+    for(int word = 0; word < words; word++) {
+        for(Uint64 bits = masks->active_fallback[word]; bits; bits &= bits - 1) {
+            int action = word * 64 + input_bits_lowest(bits);
+            action_manager_set_state(action_manager, action, action_manager_check_map(action_manager, input, action));
+        }
+    }
+
+    input_memcpy(masks->key_state, input->keyboard_current, sizeof(masks->key_state));
+    masks->mouse_state = input->mouse_current;
+    masks->gesture_state = input->gesture_current;
+    masks->primed = SDL_TRUE;
+}
+
+/*
+    Evaluates a single action against the device state using the compiled masks.
+    @key_words The keyboard words that have keys both bound and held.
+*/
+static SDL_bool action_manager_check_masks(ActionManager* action_manager, InputManager* input, int action, Uint32 key_words) {
+    ActionBindingMasks* masks = &action_manager->masks;
+    int count = action_manager->action_count;
+
+    if(input_bitset_test(masks->fallback, action))
+        return action_manager_check_map(action_manager, input, action);
+
+    const ActionInputMask* blocked = &masks->layer_blocked[masks->action_layers[action]];
+    Uint64 hits = (masks->mouse[action] & input->mouse_current & ~blocked->mouse) |
+                  (masks->gestures[action] & input->gesture_current & ~blocked->gestures);
+
+    for(; key_words; key_words &= key_words - 1) {
+        int word = input_bits_lowest(key_words);
+        hits |= masks->keys[word * count + action] & input->keyboard_current[word] & ~blocked->keys[word];
+    }
+
+    for(int slot = 0; slot < masks->gamepad_slots; slot++)
+        hits |= masks->gamepad[slot * count + action] & masks->gamepad_state[slot] & ~blocked->gamepad[slot];
+
+    return hits != 0;
+}
+
+static void action_manager_mark_dirty(Uint64* dirty, const int* offsets, const int* actions, int entry) {
+    for(int i = offsets[entry]; i < offsets[entry + 1]; i++)
+        input_bitset_set(dirty, actions[i]);
+}
+
+// Evaluates only the actions bound to inputs that changed since the last update.
+static void action_manager_update_incremental(ActionManager* action_manager, InputManager* input) {
+    ActionBindingMasks* masks = &action_manager->masks;
+    int words = INPUT_BITSET_WORDS(action_manager->action_count);
+    Uint64* dirty = masks->dirty;
+    Uint32 key_words = 0;
+
+    // Chords are rare, so they're always evaluated.
+    input_memcpy(dirty, masks->active_fallback, sizeof(*dirty) * words);
+
+    for(int word = 0; word < INPUT_KEYBOARD_WORDS; word++) {
+        if(input->keyboard_current[word])
+            key_words |= 1u << word;
+
+        Uint64 changed = input->keyboard_current[word] ^ masks->key_state[word];
+        if(!changed)
+            continue;
+
+        masks->key_state[word] = input->keyboard_current[word];
+        for(; changed; changed &= changed - 1)
+            action_manager_mark_dirty(dirty, masks->active_key_offsets, masks->active_key_actions, word * 64 + input_bits_lowest(changed));
+    }
+
+    for(MouseButton changed = input->mouse_current ^ masks->mouse_state; changed; changed &= changed - 1)
+        action_manager_mark_dirty(dirty, masks->active_mouse_offsets, masks->active_mouse_actions, input_bits_lowest(changed));
+    masks->mouse_state = input->mouse_current;
+
+    for(GestureMask changed = input->gesture_current ^ masks->gesture_state; changed; changed &= changed - 1)
+        action_manager_mark_dirty(dirty, masks->active_gesture_offsets, masks->active_gesture_actions, input_bits_lowest(changed));
+    masks->gesture_state = input->gesture_current;
+
+    // Comparing whole slots also catches the first controller changing to a different pad.
+    for(int slot = 0; slot < masks->gamepad_slots; slot++) {
+        GamepadButtonMask state = action_manager_slot_state(input, slot);
+        for(GamepadButtonMask changed = state ^ masks->gamepad_state[slot]; changed; changed &= changed - 1)
+            action_manager_mark_dirty(dirty, masks->active_gamepad_offsets, masks->active_gamepad_actions, slot * INPUT_GAMEPAD_BUTTON_BITS + input_bits_lowest(changed));
+        masks->gamepad_state[slot] = state;
+    }
+
+    // Only actions in enabled layers were marked, so the ones in disabled layers stay up.
+    for(int word = 0; word < words; word++) {
+        for(Uint64 bits = dirty[word]; bits; bits &= bits - 1) {
+            int action = word * 64 + input_bits_lowest(bits);
+            action_manager_set_state(action_manager, action, action_manager_check_masks(action_manager, input, action, key_words & masks->key_words));
+        }
+    }
+}
+
+#if INPUT_ENABLE_STATS
+// Counts the actions in a bitset that are also in an enabled layer.
+static int action_manager_count_active(ActionManager* action_manager, const Uint64* actions) {
+    int total = 0;
+    for(int word = 0; word < INPUT_BITSET_WORDS(action_manager->action_count); word++)
+        total += input_bits_count(actions[word] & action_manager->masks.active[word]);
+    return total;
+}
+#endif
+
+#if INPUT_ENABLE_STATS
+// Gets the timestamp of the newest event behind a gamepad button, including the ones made from axes.
+static Uint32 action_latency_button_time(InputGamepad* gamepad, GamepadButton button) {
+    if(button < SDL_CONTROLLER_BUTTON_MAX)
+        return gamepad->button_times[button];
+
+    int x;
+    switch(button) {
+        case SDL_CONTROLLER_BUTTON_LEFTTRIGGER:
+        case SDL_CONTROLLER_BUTTON_LEFTTRIGGERFULL:
+            return gamepad->axis_times[SDL_CONTROLLER_AXIS_TRIGGERLEFT];
+        case SDL_CONTROLLER_BUTTON_RIGHTTRIGGER:
+        case SDL_CONTROLLER_BUTTON_RIGHTTRIGGERFULL:
+            return gamepad->axis_times[SDL_CONTROLLER_AXIS_TRIGGERRIGHT];
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICKUP:
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICKLEFT:
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICKDOWN:
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICKRIGHT:
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICKUPLEFT:
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICKUPRIGHT:
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICKDOWNLEFT:
+        case SDL_CONTROLLER_BUTTON_RIGHTSTICKDOWNRIGHT:
+            x = SDL_CONTROLLER_AXIS_RIGHTX;
+            break;
+        default:
+            x = SDL_CONTROLLER_AXIS_LEFTX;
+            break;
+    }
+
+    // Either axis of a stick can move it into a direction.
+    Uint32 x_time = gamepad->axis_times[x];
+    Uint32 y_time = gamepad->axis_times[x + 1];
+    return x_time > y_time ? x_time : y_time;
+}
+
+// Checks if an analog binding crossed the threshold during the last update.
+static SDL_bool action_latency_analog_crossed(ActionManager* action_manager, InputManager* input, const InputAction* binding, InputGamepad* gamepad, int index) {
+    SDL_GameControllerAxis x_axis;
+    SDL_GameControllerAxis y_axis;
+    if(binding->type == INPUT_ACTION_GAMEPAD_AXIS) {
+        x_axis = y_axis = binding->axis.axis;
+    } else {
+        x_axis = (SDL_GameControllerAxis)(binding->stick.group * 2);
+        y_axis = x_axis + 1;
+    }
+
+    float x = input_gamepad_axis(input, x_axis, index) * binding->x;
+    float y = input_gamepad_axis(input, y_axis, index) * binding->y;
+    float previous_x = gamepad->axis_values_previous[x_axis] * binding->x;
+    float previous_y = gamepad->axis_values_previous[y_axis] * binding->y;
+    float threshold = action_manager->analog_threshold * action_manager->analog_threshold;
+
+    return (x * x + y * y >= threshold) != (previous_x * previous_x + previous_y * previous_y >= threshold);
+}
+
+/*
+    Gets the timestamp of the newest event behind a binding that could have changed its action
+    during the last update, or 0 if there isn't one. Bindings only count when their input changed,
+    or for analog bindings, when they crossed the threshold.
+*/
+static Uint32 action_latency_binding_time(ActionManager* action_manager, InputManager* input, const InputAction* binding, InputLatencyDevice* device) {
+    switch(binding->type) {
+        case INPUT_ACTION_KEYBOARD:
+            *device = INPUT_LATENCY_KEYBOARD;
+            if(binding->key < 0 || binding->key >= SDL_NUM_SCANCODES ||
+               !(input_key_pressed(input, binding->key) || input_key_released(input, binding->key)))
+                return 0;
+
+            return input->keyboard_times[binding->key];
+        case INPUT_ACTION_MOUSE: {
+            *device = INPUT_LATENCY_MOUSE;
+            Uint32 time = 0;
+            for(MouseButton changed = (input->mouse_current ^ input->mouse_previous) & binding->mouse; changed; changed &= changed - 1) {
+                Uint32 button_time = input->mouse_times[input_bits_lowest(changed)];
+                time = button_time > time ? button_time : time;
+            }
+            return time;
+        }
+        case INPUT_ACTION_GESTURE:
+            *device = INPUT_LATENCY_TOUCH;
+            if(binding->gesture < 0 || binding->gesture >= INPUT_GESTURE_MAX ||
+               !((input->gesture_current ^ input->gesture_previous) & INPUT_GESTURE_BIT(binding->gesture)))
+                return 0;
+
+            // Long presses can finish from the clock alone, long after the last touch event.
+            return input->touch_current_count ? input->gesture.time : 0;
+        case INPUT_ACTION_GAMEPAD: {
+            *device = INPUT_LATENCY_GAMEPAD;
+            InputGamepad* gamepad = input_gamepad_get(input, binding->gamepad.controller_index);
+            GamepadButton button = binding->gamepad.button;
+            if(!gamepad || button >= INPUT_GAMEPAD_BUTTON_BITS ||
+               !((gamepad->button_pressed | gamepad->button_released) & ___INPUT_GAMEPAD_BUTTON(button)))
+                return 0;
+
+            return action_latency_button_time(gamepad, button);
+        }
+        // Analog bindings can only cross the threshold when their axis moves, so the newest axis event is used.
+        case INPUT_ACTION_GAMEPAD_AXIS: {
+            *device = INPUT_LATENCY_GAMEPAD;
+            InputGamepad* gamepad = input_gamepad_get(input, binding->axis.controller_index);
+            if(!gamepad || binding->axis.axis < 0 || binding->axis.axis >= SDL_CONTROLLER_AXIS_MAX ||
+               !action_latency_analog_crossed(action_manager, input, binding, gamepad, binding->axis.controller_index))
+                return 0;
+
+            return gamepad->axis_times[binding->axis.axis];
+        }
+        case INPUT_ACTION_GAMEPAD_STICK: {
+            *device = INPUT_LATENCY_GAMEPAD;
+            InputGamepad* gamepad = input_gamepad_get(input, binding->stick.controller_index);
+            if(!gamepad || binding->stick.group < 0 || binding->stick.group >= INPUT_AXIS_GROUP_MAX ||
+               !action_latency_analog_crossed(action_manager, input, binding, gamepad, binding->stick.controller_index))
+                return 0;
+
+            Uint32 x = gamepad->axis_times[binding->stick.group * 2];
+            Uint32 y = gamepad->axis_times[binding->stick.group * 2 + 1];
+            return x > y ? x : y;
+        }
+    }
+
+    return 0;
+}
+
+// Adds the latency of every action that changed during the update to the histograms.
+static void action_manager_measure_latency(ActionManager* action_manager, InputManager* input) {
+    if(!action_manager->stats.enabled || !input->backend.get_ticks)
+        return;
+
+    Uint32 now = input->backend.get_ticks(input->backend.ctx);
+    int words = INPUT_BITSET_WORDS(action_manager->action_count);
+
+    for(int word = 0; word < words; word++) {
+        for(Uint64 changed = action_manager->current[word] ^ action_manager->previous[word]; changed; changed &= changed - 1) {
+            InputActionMap* map = &action_manager->actions[word * 64 + input_bits_lowest(changed)];
+            InputLatencyDevice device = INPUT_LATENCY_KEYBOARD;
+            Uint32 newest = 0;
+
+            InputAction* bindings = action_map_bindings(action_manager, map);
+            for(int i = 0; i < map->action_count; i++) {
+                InputLatencyDevice binding_device;
+                Uint32 time = action_latency_binding_time(action_manager, input, &bindings[i], &binding_device);
+                if(time > newest) {
+                    newest = time;
+                    device = binding_device;
+                }
+            }
+
+            // Changes without an event since the last update behind them, i.e. from a layer being enabled
+            // or from polled inputs whose events weren't passed along, aren't measured.
+            // Events pushed from another thread can be stamped after the clock was read.
+            if(newest)
+                input_latency_add(&action_manager->latency[device], now > newest ? now - newest : 0);
+        }
+    }
+}
+
+SDL_bool action_manager_write_latency(ActionManager* action_manager, SDL_RWops* file) {
+    for(int i = 0; i < INPUT_LATENCY_DEVICE_MAX; i++) {
+        if(!input_latency_write(&action_manager->latency[i], input_latency_device_name((InputLatencyDevice)i), file))
+            return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+#else
+SDL_bool action_manager_write_latency(ActionManager* action_manager, SDL_RWops* file) {
+    (void)action_manager;
+    (void)file;
+    return SDL_FALSE;
+}
+#endif
+
 void action_manager_update(ActionManager* action_manager, InputManager* input) {
-    for(int i = 0; i < action_manager->action_count; i++)
-        input_update_action_map(&action_manager->actions[i], input);
-}
\ No newline at end of file
+    INPUT_STATS_BEGIN(&action_manager->stats, "action_manager_update");
+    int words = INPUT_BITSET_WORDS(action_manager->action_count);
+    input_memcpy(action_manager->previous, action_manager->current, sizeof(Uint64) * words);
+
+    if(action_manager->masks_dirty)
+        action_manager_compile(action_manager);
+
+    // Layers changing also changes which actions have values.
+    SDL_bool layers_changed = action_manager->layers_dirty && !action_manager->masks_dirty;
+    if(layers_changed)
+        action_manager_update_layers(action_manager);
+
+    SDL_bool incremental = !action_manager->masks_dirty && action_manager->incremental && action_manager->masks.primed;
+    if(action_manager->masks_dirty) {
+        for(int i = 0; i < action_manager->action_count; i++)
+            action_manager_set_state(action_manager, i, action_manager_check_map(action_manager, input, i));
+    } else if(incremental) {
+        action_manager_update_incremental(action_manager, input);
+    } else {
+        action_manager_update_masks(action_manager, input);
+    }
+
+#if INPUT_ENABLE_STATS
+    if(action_manager->stats.enabled) {
+        int evaluated = action_manager->action_count;
+        if(!action_manager->masks_dirty)
+            evaluated = action_manager_count_active(action_manager, incremental ? action_manager->masks.dirty : action_manager->masks.active);
+
+        action_manager->stats.pending.actions_evaluated += evaluated;
+        action_manager->stats.pending.actions_skipped += action_manager->action_count - evaluated;
+    }
+#endif
+
+    action_manager_update_values(action_manager, input, layers_changed);
+
+    if(action_manager->combos_dirty)
+        action_combo_compile(action_manager);
+
+    action_manager->frame++;
+    if(action_manager->history) {
+        Uint64* slot = action_manager->history + (action_manager->frame & (action_manager->history_length - 1)) * words;
+        input_memcpy(slot, action_manager->current, sizeof(Uint64) * words);
+    }
+
+    // Only the actions that changed have their history written.
+    for(int word = 0; word < words; word++) {
+        for(Uint64 changed = action_manager->current[word] ^ action_manager->previous[word]; changed; changed &= changed - 1) {
+            int action = word * 64 + input_bits_lowest(changed);
+            input_history_push(&action_manager->action_history[action],
+                               &action_manager->action_history_frames[action],
+                               action_manager->frame,
+                               input_bitset_test(action_manager->current, action));
+        }
+    }
+
+#if INPUT_ENABLE_STATS
+    action_manager_measure_latency(action_manager, input);
+#endif
+
+    action_combo_update(action_manager);
+
+    INPUT_STATS_END(&action_manager->stats, "action_manager_update");
+}
@@ -0,0 +1,1136 @@
+#include <action_profile.h>
+
+#include "std_definitions.h"
+#include "action_internal.h"
+
+/*
+    Binary layout:
+
+    header:  "SDLP", version byte, varint action count, varint binding count
+    action:  value mode byte, varint binding count, followed by each binding
+    binding: type byte, the fields of the type as varints (controller indices are zigzag encoded),
+             then x and y as 4 little endian bytes each
+*/
+
+// When compiling, can be used to change the highest amount of actions a profile can have, to catch typos in the text form.
+#ifndef ACTION_PROFILE_MAX_ACTIONS
+#define ACTION_PROFILE_MAX_ACTIONS 65536
+#endif
+
+// The most tokens a line of the text form can have.
+#define ACTION_PROFILE_MAX_TOKENS 8
+
+// The longest a single token can be, including the null terminator.
+#define ACTION_PROFILE_TOKEN_SIZE 64
+
+// The most bytes each part of the binary form can take up.
+#define ACTION_PROFILE_HEADER_MAX 15
+#define ACTION_PROFILE_ACTION_MAX 6
+#define ACTION_PROFILE_BINDING_MAX 19
+
+static const Uint8 action_profile_magic[4] = { 'S', 'D', 'L', 'P' };
+
+static const char* const action_profile_text_header = "sdl_input_profile";
+
+// The names of the buttons added by <SDL_GameControllerButtonExtension>, starting at SDL_CONTROLLER_BUTTON_MAX.
+static const char* const action_profile_gamepad_names[] = {
+    "leftstickup",
+    "leftstickleft",
+    "leftstickdown",
+    "leftstickright",
+    "rightstickup",
+    "rightstickleft",
+    "rightstickdown",
+    "rightstickright",
+    "lefttrigger",
+    "righttrigger",
+    "leftstickupleft",
+    "leftstickupright",
+    "leftstickdownleft",
+    "leftstickdownright",
+    "rightstickupleft",
+    "rightstickupright",
+    "rightstickdownleft",
+    "rightstickdownright",
+    "lefttriggerfull",
+    "righttriggerfull"
+};
+
+SDL_COMPILE_TIME_ASSERT(action_profile_gamepad_names, SDL_arraysize(action_profile_gamepad_names) == SDL_CONTROLLER_BUTTON_EXTENSION_MAX - SDL_CONTROLLER_BUTTON_MAX);
+
+// The names of the mouse buttons, indexed by SDL button number.
+static const char* const action_profile_mouse_names[] = {
+    NULL,
+    "left",
+    "middle",
+    "right",
+    "x1",
+    "x2",
+    "scroll_left",
+    "scroll_right",
+    "scroll_up",
+    "scroll_down"
+};
+
+static const char* const action_profile_gesture_names[] = {
+    "tap",
+    "double_tap",
+    "long_press",
+    "swipe_left",
+    "swipe_right",
+    "swipe_up",
+    "swipe_down",
+    "pinch_in",
+    "pinch_out",
+    "rotate_clockwise",
+    "rotate_counter_clockwise"
+};
+
+SDL_COMPILE_TIME_ASSERT(action_profile_gesture_names, SDL_arraysize(action_profile_gesture_names) == INPUT_GESTURE_MAX);
+
+static const char* const action_profile_stick_names[] = {
+    "leftstick",
+    "rightstick",
+    "triggers"
+};
+
+SDL_COMPILE_TIME_ASSERT(action_profile_stick_names, SDL_arraysize(action_profile_stick_names) == INPUT_AXIS_GROUP_MAX);
+
+static const char* const action_profile_mode_names[] = {
+    "max",
+    "sum"
+};
+
+// Allocates a profile and all of its arrays in one block.
+static ActionProfile* action_profile_create(Uint32 action_count, int binding_count, const InputAllocator* allocator) {
+    InputAllocator copy = allocator ? *allocator : (InputAllocator){ 0 };
+    size_t size = sizeof(ActionProfile) +
+                  sizeof(InputAction) * binding_count +
+                  sizeof(int) * (action_count + 1) +
+                  sizeof(ActionValueMode) * action_count;
+
+    Uint8* block = input_allocator_calloc(&copy, 1, size);
+    if(!block)
+        return NULL;
+
+    ActionProfile* profile = (ActionProfile*)block;
+    profile->allocator = copy;
+    profile->bindings = (InputAction*)(block + sizeof(ActionProfile));
+    profile->binding_count = binding_count;
+    profile->action_offsets = (int*)(profile->bindings + binding_count);
+    profile->value_modes = (ActionValueMode*)(profile->action_offsets + action_count + 1);
+    profile->action_count = action_count;
+
+    return profile;
+}
+
+void action_profile_free(ActionProfile* profile) {
+    InputAllocator allocator = profile->allocator;
+    input_allocator_free(&allocator, profile);
+}
+
+// Checks if a binding refers to an input that exists, so a bad profile can't index out of bounds later on.
+static SDL_bool action_profile_binding_valid(const InputAction* binding) {
+    switch(binding->type) {
+        case INPUT_ACTION_KEYBOARD:
+            return binding->key >= 0 && binding->key < SDL_NUM_SCANCODES;
+        case INPUT_ACTION_MOUSE:
+            return binding->mouse != 0;
+        case INPUT_ACTION_GAMEPAD:
+            return binding->gamepad.button < SDL_CONTROLLER_BUTTON_EXTENSION_MAX && binding->gamepad.controller_index >= -1;
+        case INPUT_ACTION_GESTURE:
+            return binding->gesture >= 0 && binding->gesture < INPUT_GESTURE_MAX;
+        case INPUT_ACTION_GAMEPAD_AXIS:
+            return binding->axis.axis >= 0 && binding->axis.axis < SDL_CONTROLLER_AXIS_MAX && binding->axis.controller_index >= -1;
+        case INPUT_ACTION_GAMEPAD_STICK:
+            return binding->stick.group >= 0 && binding->stick.group < INPUT_AXIS_GROUP_MAX && binding->stick.controller_index >= -1;
+    }
+
+    return SDL_FALSE;
+}
+
+// Turns the binding counts in the offsets of a profile into offsets.
+static void action_profile_count_offsets(ActionProfile* profile) {
+    int total = 0;
+    for(Uint32 i = 0; i < profile->action_count; i++) {
+        int count = profile->action_offsets[i];
+        profile->action_offsets[i] = total;
+        total += count;
+    }
+    profile->action_offsets[profile->action_count] = total;
+}
+
+/*
+    Text form.
+*/
+
+typedef struct ActionProfileToken {
+    const char* text;
+    size_t length;
+} ActionProfileToken;
+
+typedef enum ActionProfileLineType {
+    ACTION_PROFILE_LINE_BINDING,
+    ACTION_PROFILE_LINE_MODE
+} ActionProfileLineType;
+
+typedef struct ActionProfileLine {
+    ActionProfileLineType type;
+    Uint32 action;
+    InputAction binding;
+    ActionValueMode mode;
+} ActionProfileLine;
+
+typedef struct ActionProfileReader {
+    const char* text;
+    const char* end;
+    int line;
+    SDL_bool header;
+} ActionProfileReader;
+
+static void action_profile_reader_init(ActionProfileReader* reader, const char* text, size_t length) {
+    reader->text = text;
+    reader->end = text + length;
+    reader->line = 0;
+    reader->header = SDL_FALSE;
+}
+
+// Copies a token into a null terminated buffer. Returns SDL_FALSE if it's too long.
+static SDL_bool action_profile_token_copy(const ActionProfileToken* token, char* buffer) {
+    if(token->length >= ACTION_PROFILE_TOKEN_SIZE)
+        return SDL_FALSE;
+
+    input_memcpy(buffer, token->text, token->length);
+    buffer[token->length] = '\0';
+    return SDL_TRUE;
+}
+
+static SDL_bool action_profile_token_equals(const ActionProfileToken* token, const char* text) {
+    size_t length = SDL_strlen(text);
+    return token->length == length && SDL_strncasecmp(token->text, text, length) == 0;
+}
+
+static SDL_bool action_profile_token_int(const ActionProfileToken* token, long* value) {
+    char buffer[ACTION_PROFILE_TOKEN_SIZE];
+    char* end;
+    if(!action_profile_token_copy(token, buffer))
+        return SDL_FALSE;
+
+    *value = SDL_strtol(buffer, &end, 10);
+    return end != buffer && *end == '\0';
+}
+
+static SDL_bool action_profile_token_float(const ActionProfileToken* token, float* value) {
+    char buffer[ACTION_PROFILE_TOKEN_SIZE];
+    char* end;
+    if(!action_profile_token_copy(token, buffer))
+        return SDL_FALSE;
+
+    *value = (float)SDL_strtod(buffer, &end);
+    return end != buffer && *end == '\0';
+}
+
+// Finds a name in a table, falling back to its number. Returns -1 if it's neither.
+static int action_profile_token_lookup(const ActionProfileToken* token, const char* const* names, int count) {
+    for(int i = 0; i < count; i++) {
+        if(names[i] && action_profile_token_equals(token, names[i]))
+            return i;
+    }
+
+    long value;
+    if(action_profile_token_int(token, &value) && value >= 0 && value < count)
+        return (int)value;
+
+    return -1;
+}
+
+static SDL_bool action_profile_parse_key(const ActionProfileToken* token, SDL_Scancode* key) {
+    char buffer[ACTION_PROFILE_TOKEN_SIZE];
+    if(!action_profile_token_copy(token, buffer))
+        return SDL_FALSE;
+
+    // Names can't contain spaces, so they're written with underscores.
+    for(char* c = buffer; *c; c++) {
+        if(*c == '_')
+            *c = ' ';
+    }
+
+    *key = SDL_GetScancodeFromName(buffer);
+    if(*key != SDL_SCANCODE_UNKNOWN)
+        return SDL_TRUE;
+
+    long value;
+    if(!action_profile_token_int(token, &value) || value < 0 || value >= SDL_NUM_SCANCODES)
+        return SDL_FALSE;
+
+    *key = (SDL_Scancode)value;
+    return SDL_TRUE;
+}
+
+static SDL_bool action_profile_parse_mouse(const ActionProfileToken* token, MouseButton* mouse) {
+    *mouse = 0;
+    const char* start = token->text;
+    const char* end = token->text + token->length;
+    while(start < end) {
+        const char* plus = start;
+        while(plus < end && *plus != '+')
+            plus++;
+
+        ActionProfileToken part = { start, (size_t)(plus - start) };
+        int button = action_profile_token_lookup(&part, action_profile_mouse_names, SDL_arraysize(action_profile_mouse_names));
+        if(button <= 0)
+            return SDL_FALSE;
+
+        *mouse |= SDL_BUTTON(button);
+        start = plus + 1;
+    }
+
+    return *mouse != 0;
+}
+
+static SDL_bool action_profile_parse_gamepad_button(const ActionProfileToken* token, GamepadButton* button) {
+    char buffer[ACTION_PROFILE_TOKEN_SIZE];
+    if(!action_profile_token_copy(token, buffer))
+        return SDL_FALSE;
+
+    SDL_GameControllerButton sdl_button = SDL_GameControllerGetButtonFromString(buffer);
+    if(sdl_button != SDL_CONTROLLER_BUTTON_INVALID) {
+        *button = sdl_button;
+        return SDL_TRUE;
+    }
+
+    for(int i = 0; i < (int)SDL_arraysize(action_profile_gamepad_names); i++) {
+        if(SDL_strcasecmp(buffer, action_profile_gamepad_names[i]) == 0) {
+            *button = SDL_CONTROLLER_BUTTON_MAX + i;
+            return SDL_TRUE;
+        }
+    }
+
+    long value;
+    if(!action_profile_token_int(token, &value) || value < 0 || value >= SDL_CONTROLLER_BUTTON_EXTENSION_MAX)
+        return SDL_FALSE;
+
+    *button = (GamepadButton)value;
+    return SDL_TRUE;
+}
+
+static SDL_bool action_profile_parse_axis(const ActionProfileToken* token, SDL_GameControllerAxis* axis) {
+    char buffer[ACTION_PROFILE_TOKEN_SIZE];
+    if(!action_profile_token_copy(token, buffer))
+        return SDL_FALSE;
+
+    *axis = SDL_GameControllerGetAxisFromString(buffer);
+    if(*axis != SDL_CONTROLLER_AXIS_INVALID)
+        return SDL_TRUE;
+
+    long value;
+    if(!action_profile_token_int(token, &value) || value < 0 || value >= SDL_CONTROLLER_AXIS_MAX)
+        return SDL_FALSE;
+
+    *axis = (SDL_GameControllerAxis)value;
+    return SDL_TRUE;
+}
+
+static SDL_bool action_profile_parse_index(const ActionProfileToken* token, int* index) {
+    long value;
+    if(!action_profile_token_int(token, &value) || value < -1 || value > SDL_MAX_SINT32)
+        return SDL_FALSE;
+
+    *index = (int)value;
+    return SDL_TRUE;
+}
+
+// Parses the optional x and y at the end of a button binding.
+static SDL_bool action_profile_parse_direction(const ActionProfileToken* tokens, int count, InputAction* binding) {
+    binding->x = 1;
+    binding->y = 0;
+    if(count == 0)
+        return SDL_TRUE;
+
+    return count == 2 && action_profile_token_float(&tokens[0], &binding->x) && action_profile_token_float(&tokens[1], &binding->y);
+}
+
+// Parses the part of a binding line after the action index.
+static const char* action_profile_parse_binding(const ActionProfileToken* tokens, int count, ActionProfileLine* line) {
+    InputAction* binding = &line->binding;
+    const ActionProfileToken* device = &tokens[0];
+    line->type = ACTION_PROFILE_LINE_BINDING;
+    *binding = (InputAction){ 0 };
+
+    if(action_profile_token_equals(device, "key")) {
+        binding->type = INPUT_ACTION_KEYBOARD;
+        if(count < 2 || !action_profile_parse_key(&tokens[1], &binding->key))
+            return "Unknown key";
+        if(!action_profile_parse_direction(tokens + 2, count - 2, binding))
+            return "Expected an x and y after the key";
+    } else if(action_profile_token_equals(device, "mouse")) {
+        binding->type = INPUT_ACTION_MOUSE;
+        binding->x = 1;
+        binding->y = 0;
+        if(count != 2 || !action_profile_parse_mouse(&tokens[1], &binding->mouse))
+            return "Unknown mouse button";
+    } else if(action_profile_token_equals(device, "gamepad")) {
+        binding->type = INPUT_ACTION_GAMEPAD;
+        binding->gamepad.controller_index = -1;
+        if(count < 2 || !action_profile_parse_gamepad_button(&tokens[1], &binding->gamepad.button))
+            return "Unknown gamepad button";
+        if(count > 2 && !action_profile_parse_index(&tokens[2], &binding->gamepad.controller_index))
+            return "Invalid controller index";
+        if(!action_profile_parse_direction(tokens + 3, count > 3 ? count - 3 : 0, binding))
+            return "Expected an x and y after the controller index";
+    } else if(action_profile_token_equals(device, "gesture")) {
+        binding->type = INPUT_ACTION_GESTURE;
+        binding->x = 1;
+        binding->y = 0;
+        int gesture = count == 2 ? action_profile_token_lookup(&tokens[1], action_profile_gesture_names, INPUT_GESTURE_MAX) : -1;
+        if(gesture == -1)
+            return "Unknown gesture";
+        binding->gesture = (InputGesture)gesture;
+    } else if(action_profile_token_equals(device, "axis")) {
+        binding->type = INPUT_ACTION_GAMEPAD_AXIS;
+        if(count != 5 || !action_profile_parse_axis(&tokens[1], &binding->axis.axis))
+            return "Expected an axis, controller index, x and y";
+        if(!action_profile_parse_index(&tokens[2], &binding->axis.controller_index))
+            return "Invalid controller index";
+        if(!action_profile_token_float(&tokens[3], &binding->x) || !action_profile_token_float(&tokens[4], &binding->y))
+            return "Invalid x or y";
+    } else if(action_profile_token_equals(device, "stick")) {
+        binding->type = INPUT_ACTION_GAMEPAD_STICK;
+        int group = count == 5 ? action_profile_token_lookup(&tokens[1], action_profile_stick_names, INPUT_AXIS_GROUP_MAX) : -1;
+        if(group == -1)
+            return "Expected a stick, controller index, x scale and y scale";
+        binding->stick.group = (InputAxisGroup)group;
+        if(!action_profile_parse_index(&tokens[2], &binding->stick.controller_index))
+            return "Invalid controller index";
+        if(!action_profile_token_float(&tokens[3], &binding->x) || !action_profile_token_float(&tokens[4], &binding->y))
+            return "Invalid x or y scale";
+    } else if(action_profile_token_equals(device, "mode")) {
+        line->type = ACTION_PROFILE_LINE_MODE;
+        int mode = count == 2 ? action_profile_token_lookup(&tokens[1], action_profile_mode_names, SDL_arraysize(action_profile_mode_names)) : -1;
+        if(mode == -1)
+            return "Unknown value mode";
+        line->mode = (ActionValueMode)mode;
+    } else {
+        return "Unknown binding type";
+    }
+
+    return NULL;
+}
+
+/*
+    Reads the next line that isn't empty or a comment.
+    Returns 1 if a line was read, 0 at the end of the text, or -1 if the line is invalid.
+*/
+static int action_profile_read_line(ActionProfileReader* reader, ActionProfileLine* line) {
+    while(reader->text < reader->end) {
+        const char* start = reader->text;
+        const char* end = start;
+        while(end < reader->end && *end != '\n')
+            end++;
+
+        reader->text = end < reader->end ? end + 1 : end;
+        reader->line++;
+
+        ActionProfileToken tokens[ACTION_PROFILE_MAX_TOKENS];
+        int count = 0;
+        const char* c = start;
+        for(;;) {
+            while(c < end && SDL_isspace((unsigned char)*c))
+                c++;
+            if(c == end || *c == '#')
+                break;
+
+            if(count == ACTION_PROFILE_MAX_TOKENS) {
+                SDL_SetError("Action profile line %d: Too many values", reader->line);
+                return -1;
+            }
+
+            tokens[count].text = c;
+            while(c < end && !SDL_isspace((unsigned char)*c) && *c != '#')
+                c++;
+            tokens[count].length = (size_t)(c - tokens[count].text);
+            count++;
+        }
+
+        if(count == 0)
+            continue;
+
+        const char* error = NULL;
+        long value;
+        if(!reader->header) {
+            // The header has to come first, so the version is known before anything else is read.
+            if(count != 2 || !action_profile_token_equals(&tokens[0], action_profile_text_header))
+                error = "Expected the profile header";
+            else if(!action_profile_token_int(&tokens[1], &value) || value != ACTION_PROFILE_VERSION)
+                error = "Unsupported profile version";
+            else
+                reader->header = SDL_TRUE;
+        } else if(count < 2 || !action_profile_token_int(&tokens[0], &value) || value < 0 || value >= ACTION_PROFILE_MAX_ACTIONS) {
+            error = "Expected an action index";
+        } else {
+            line->action = (Uint32)value;
+            error = action_profile_parse_binding(tokens + 1, count - 1, line);
+            if(!error)
+                return 1;
+        }
+
+        if(error) {
+            SDL_SetError("Action profile line %d: %s", reader->line, error);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+ActionProfile* action_profile_parse(const char* text, size_t length, const InputAllocator* allocator) {
+    ActionProfileReader reader;
+    ActionProfileLine line;
+    Uint32 action_count = 0;
+    int binding_count = 0;
+    int result;
+
+    // The first pass finds the size of everything, so the profile can be allocated in one go.
+    action_profile_reader_init(&reader, text, length);
+    while((result = action_profile_read_line(&reader, &line)) > 0) {
+        if(line.action >= action_count)
+            action_count = line.action + 1;
+        if(line.type == ACTION_PROFILE_LINE_BINDING)
+            binding_count++;
+    }
+
+    if(result < 0)
+        return NULL;
+
+    if(!reader.header) {
+        SDL_SetError("Action profile is missing its header");
+        return NULL;
+    }
+
+    ActionProfile* profile = action_profile_create(action_count, binding_count, allocator);
+    if(!profile)
+        return NULL;
+
+    // The second pass counts the bindings of each action, and the third puts them in place.
+    action_profile_reader_init(&reader, text, length);
+    while(action_profile_read_line(&reader, &line) > 0) {
+        if(line.type == ACTION_PROFILE_LINE_BINDING)
+            profile->action_offsets[line.action]++;
+    }
+
+    action_profile_count_offsets(profile);
+
+    action_profile_reader_init(&reader, text, length);
+    while(action_profile_read_line(&reader, &line) > 0) {
+        if(line.type == ACTION_PROFILE_LINE_BINDING)
+            profile->bindings[profile->action_offsets[line.action]++] = line.binding;
+        else if(line.type == ACTION_PROFILE_LINE_MODE)
+            profile->value_modes[line.action] = line.mode;
+    }
+
+    // Placing the bindings moved each offset to the start of the next action.
+    for(Uint32 i = action_count; i > 0; i--)
+        profile->action_offsets[i] = profile->action_offsets[i - 1];
+    profile->action_offsets[0] = 0;
+
+    return profile;
+}
+
+// Collects the text form before writing it, so the file isn't written one line at a time.
+typedef struct ActionProfileTextWriter {
+    SDL_RWops* file;
+    size_t length;
+    SDL_bool failed;
+    char buffer[4096];
+} ActionProfileTextWriter;
+
+static void action_profile_text_flush(ActionProfileTextWriter* writer) {
+    if(writer->length > 0 && SDL_RWwrite(writer->file, writer->buffer, 1, writer->length) != writer->length)
+        writer->failed = SDL_TRUE;
+    writer->length = 0;
+}
+
+static void action_profile_text_append(ActionProfileTextWriter* writer, const char* text) {
+    size_t length = SDL_strlen(text);
+    if(writer->length + length > sizeof(writer->buffer))
+        action_profile_text_flush(writer);
+
+    input_memcpy(writer->buffer + writer->length, text, length);
+    writer->length += length;
+}
+
+// Writes the name of a gamepad button, or its number if it doesn't have one.
+static void action_profile_gamepad_name(GamepadButton button, char* buffer, size_t size) {
+    const char* name = NULL;
+    if(button < SDL_CONTROLLER_BUTTON_MAX)
+        name = SDL_GameControllerGetStringForButton((SDL_GameControllerButton)button);
+    else if(button < SDL_CONTROLLER_BUTTON_EXTENSION_MAX)
+        name = action_profile_gamepad_names[button - SDL_CONTROLLER_BUTTON_MAX];
+
+    if(name && *name)
+        SDL_snprintf(buffer, size, "%s", name);
+    else
+        SDL_snprintf(buffer, size, "%u", button);
+}
+
+static void action_profile_mouse_name(MouseButton mouse, char* buffer, size_t size) {
+    size_t length = 0;
+    buffer[0] = '\0';
+    for(int bit = 0; bit < 32 && length < size; bit++) {
+        if(!(mouse & ((MouseButton)1 << bit)))
+            continue;
+
+        int button = bit + 1;
+        const char* separator = length > 0 ? "+" : "";
+        if(button < (int)SDL_arraysize(action_profile_mouse_names))
+            length += SDL_snprintf(buffer + length, size - length, "%s%s", separator, action_profile_mouse_names[button]);
+        else
+            length += SDL_snprintf(buffer + length, size - length, "%s%d", separator, button);
+    }
+}
+
+/*
+    Whether a key can be written by its name and parsed back as the same key.
+    Underscores stand for spaces and hashes start comments, and some names are shared by more than one key.
+*/
+static SDL_bool action_profile_key_has_name(SDL_Scancode key, const char* name) {
+    if(!name || !*name || SDL_strlen(name) >= ACTION_PROFILE_TOKEN_SIZE)
+        return SDL_FALSE;
+
+    if(SDL_strchr(name, '_') || SDL_strchr(name, '#'))
+        return SDL_FALSE;
+
+    return SDL_GetScancodeFromName(name) == key;
+}
+
+static void action_profile_write_binding(ActionProfileTextWriter* writer, Uint32 action, const InputAction* binding) {
+    // Big enough for every mouse button joined together.
+    char name[128];
+    char line[256];
+    SDL_bool direction = binding->x != 1 || binding->y != 0;
+
+    switch(binding->type) {
+        case INPUT_ACTION_KEYBOARD: {
+            const char* key_name = SDL_GetScancodeName(binding->key);
+            if(action_profile_key_has_name(binding->key, key_name)) {
+                SDL_snprintf(name, sizeof(name), "%s", key_name);
+                for(char* c = name; *c; c++) {
+                    if(*c == ' ')
+                        *c = '_';
+                }
+            } else {
+                // At least two digits, so the number can't be read as one of the number keys.
+                SDL_snprintf(name, sizeof(name), "%02d", (int)binding->key);
+            }
+
+            if(direction)
+                SDL_snprintf(line, sizeof(line), "%u key %s %.9g %.9g\n", action, name, binding->x, binding->y);
+            else
+                SDL_snprintf(line, sizeof(line), "%u key %s\n", action, name);
+            break;
+        }
+        case INPUT_ACTION_MOUSE:
+            action_profile_mouse_name(binding->mouse, name, sizeof(name));
+            SDL_snprintf(line, sizeof(line), "%u mouse %s\n", action, name);
+            break;
+        case INPUT_ACTION_GAMEPAD:
+            action_profile_gamepad_name(binding->gamepad.button, name, sizeof(name));
+            if(direction)
+                SDL_snprintf(line, sizeof(line), "%u gamepad %s %d %.9g %.9g\n", action, name, binding->gamepad.controller_index, binding->x, binding->y);
+            else if(binding->gamepad.controller_index != -1)
+                SDL_snprintf(line, sizeof(line), "%u gamepad %s %d\n", action, name, binding->gamepad.controller_index);
+            else
+                SDL_snprintf(line, sizeof(line), "%u gamepad %s\n", action, name);
+            break;
+        case INPUT_ACTION_GESTURE:
+            SDL_snprintf(line, sizeof(line), "%u gesture %s\n", action, action_profile_gesture_names[binding->gesture]);
+            break;
+        case INPUT_ACTION_GAMEPAD_AXIS: {
+            const char* axis_name = SDL_GameControllerGetStringForAxis(binding->axis.axis);
+            if(axis_name && *axis_name)
+                SDL_snprintf(name, sizeof(name), "%s", axis_name);
+            else
+                SDL_snprintf(name, sizeof(name), "%d", (int)binding->axis.axis);
+            SDL_snprintf(line, sizeof(line), "%u axis %s %d %.9g %.9g\n", action, name, binding->axis.controller_index, binding->x, binding->y);
+            break;
+        }
+        case INPUT_ACTION_GAMEPAD_STICK:
+            SDL_snprintf(line, sizeof(line), "%u stick %s %d %.9g %.9g\n", action, action_profile_stick_names[binding->stick.group], binding->stick.controller_index, binding->x, binding->y);
+            break;
+        default:
+            return;
+    }
+
+    action_profile_text_append(writer, line);
+}
+
+SDL_bool action_profile_write_text(const ActionProfile* profile, SDL_RWops* file) {
+    ActionProfileTextWriter writer;
+    char line[64];
+    writer.file = file;
+    writer.length = 0;
+    writer.failed = SDL_FALSE;
+
+    SDL_snprintf(line, sizeof(line), "%s %d\n", action_profile_text_header, ACTION_PROFILE_VERSION);
+    action_profile_text_append(&writer, line);
+
+    for(Uint32 i = 0; i < profile->action_count; i++) {
+        if(profile->value_modes[i] != ACTION_VALUE_MAX_MAGNITUDE) {
+            SDL_snprintf(line, sizeof(line), "%u mode %s\n", i, action_profile_mode_names[profile->value_modes[i]]);
+            action_profile_text_append(&writer, line);
+        }
+
+        for(int j = profile->action_offsets[i]; j < profile->action_offsets[i + 1]; j++) {
+            if(action_profile_binding_valid(&profile->bindings[j]))
+                action_profile_write_binding(&writer, i, &profile->bindings[j]);
+        }
+    }
+
+    action_profile_text_flush(&writer);
+    return !writer.failed;
+}
+
+/*
+    Binary form.
+*/
+
+typedef struct ActionProfileWriter {
+    Uint8* buffer;
+    size_t length;
+} ActionProfileWriter;
+
+typedef struct ActionProfileDecoder {
+    const Uint8* data;
+    size_t size;
+    size_t position;
+    SDL_bool corrupt;
+} ActionProfileDecoder;
+
+static void action_profile_write_byte(ActionProfileWriter* writer, Uint8 value) {
+    writer->buffer[writer->length++] = value;
+}
+
+static void action_profile_write_varint(ActionProfileWriter* writer, Uint32 value) {
+    while(value >= 0x80) {
+        writer->buffer[writer->length++] = (Uint8)(value | 0x80);
+        value >>= 7;
+    }
+    writer->buffer[writer->length++] = (Uint8)value;
+}
+
+static void action_profile_write_signed(ActionProfileWriter* writer, Sint32 value) {
+    action_profile_write_varint(writer, ((Uint32)value << 1) ^ (Uint32)(value >> 31));
+}
+
+static void action_profile_write_float(ActionProfileWriter* writer, float value) {
+    Uint32 bits;
+    input_memcpy(&bits, &value, sizeof(bits));
+    for(int i = 0; i < 4; i++)
+        writer->buffer[writer->length++] = (Uint8)(bits >> (i * 8));
+}
+
+static Uint8 action_profile_read_byte(ActionProfileDecoder* decoder) {
+    if(decoder->position >= decoder->size) {
+        decoder->corrupt = SDL_TRUE;
+        return 0;
+    }
+
+    return decoder->data[decoder->position++];
+}
+
+static Uint32 action_profile_read_varint(ActionProfileDecoder* decoder) {
+    Uint32 value = 0;
+    for(int shift = 0; shift < 35; shift += 7) {
+        Uint8 byte = action_profile_read_byte(decoder);
+        value |= (Uint32)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+            return value;
+    }
+
+    decoder->corrupt = SDL_TRUE;
+    return 0;
+}
+
+static Sint32 action_profile_read_signed(ActionProfileDecoder* decoder) {
+    Uint32 value = action_profile_read_varint(decoder);
+    return (Sint32)(value >> 1) ^ -(Sint32)(value & 1);
+}
+
+static float action_profile_read_float(ActionProfileDecoder* decoder) {
+    Uint32 bits = 0;
+    for(int i = 0; i < 4; i++)
+        bits |= (Uint32)action_profile_read_byte(decoder) << (i * 8);
+
+    float value;
+    input_memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+SDL_bool action_profile_write_binary(const ActionProfile* profile, SDL_RWops* file) {
+    ActionProfileWriter writer;
+    size_t size = ACTION_PROFILE_HEADER_MAX +
+                  ACTION_PROFILE_ACTION_MAX * (size_t)profile->action_count +
+                  ACTION_PROFILE_BINDING_MAX * (size_t)profile->binding_count;
+
+    InputAllocator allocator = profile->allocator;
+    writer.buffer = input_allocator_malloc(&allocator, size);
+    writer.length = 0;
+    if(!writer.buffer)
+        return SDL_FALSE;
+
+    // Invalid bindings are skipped, so the counts have to be known before the header is written.
+    int binding_count = 0;
+    for(int i = 0; i < profile->binding_count; i++) {
+        if(action_profile_binding_valid(&profile->bindings[i]))
+            binding_count++;
+    }
+
+    input_memcpy(writer.buffer, action_profile_magic, sizeof(action_profile_magic));
+    writer.length = sizeof(action_profile_magic);
+    action_profile_write_byte(&writer, ACTION_PROFILE_VERSION);
+    action_profile_write_varint(&writer, profile->action_count);
+    action_profile_write_varint(&writer, (Uint32)binding_count);
+
+    for(Uint32 i = 0; i < profile->action_count; i++) {
+        const InputAction* bindings = profile->bindings + profile->action_offsets[i];
+        int count = profile->action_offsets[i + 1] - profile->action_offsets[i];
+        int valid = 0;
+        for(int j = 0; j < count; j++) {
+            if(action_profile_binding_valid(&bindings[j]))
+                valid++;
+        }
+
+        action_profile_write_byte(&writer, (Uint8)profile->value_modes[i]);
+        action_profile_write_varint(&writer, (Uint32)valid);
+
+        for(int j = 0; j < count; j++) {
+            const InputAction* binding = &bindings[j];
+            if(!action_profile_binding_valid(binding))
+                continue;
+
+            action_profile_write_byte(&writer, (Uint8)binding->type);
+            switch(binding->type) {
+                case INPUT_ACTION_KEYBOARD:
+                    action_profile_write_varint(&writer, (Uint32)binding->key);
+                    break;
+                case INPUT_ACTION_MOUSE:
+                    action_profile_write_varint(&writer, binding->mouse);
+                    break;
+                case INPUT_ACTION_GAMEPAD:
+                    action_profile_write_varint(&writer, binding->gamepad.button);
+                    action_profile_write_signed(&writer, binding->gamepad.controller_index);
+                    break;
+                case INPUT_ACTION_GESTURE:
+                    action_profile_write_varint(&writer, (Uint32)binding->gesture);
+                    break;
+                case INPUT_ACTION_GAMEPAD_AXIS:
+                    action_profile_write_varint(&writer, (Uint32)binding->axis.axis);
+                    action_profile_write_signed(&writer, binding->axis.controller_index);
+                    break;
+                case INPUT_ACTION_GAMEPAD_STICK:
+                    action_profile_write_varint(&writer, (Uint32)binding->stick.group);
+                    action_profile_write_signed(&writer, binding->stick.controller_index);
+                    break;
+            }
+            action_profile_write_float(&writer, binding->x);
+            action_profile_write_float(&writer, binding->y);
+        }
+    }
+
+    SDL_bool result = SDL_RWwrite(file, writer.buffer, 1, writer.length) == writer.length ? SDL_TRUE : SDL_FALSE;
+    input_allocator_free(&allocator, writer.buffer);
+    return result;
+}
+
+// Reads one binding of the binary form. Leaves the decoder corrupt if it's invalid.
+static void action_profile_decode_binding(ActionProfileDecoder* decoder, InputAction* binding) {
+    binding->type = (InputActionType)action_profile_read_byte(decoder);
+    switch(binding->type) {
+        case INPUT_ACTION_KEYBOARD:
+            binding->key = (SDL_Scancode)action_profile_read_varint(decoder);
+            break;
+        case INPUT_ACTION_MOUSE:
+            binding->mouse = action_profile_read_varint(decoder);
+            break;
+        case INPUT_ACTION_GAMEPAD:
+            binding->gamepad.button = action_profile_read_varint(decoder);
+            binding->gamepad.controller_index = action_profile_read_signed(decoder);
+            break;
+        case INPUT_ACTION_GESTURE:
+            binding->gesture = (InputGesture)action_profile_read_varint(decoder);
+            break;
+        case INPUT_ACTION_GAMEPAD_AXIS:
+            binding->axis.axis = (SDL_GameControllerAxis)action_profile_read_varint(decoder);
+            binding->axis.controller_index = action_profile_read_signed(decoder);
+            break;
+        case INPUT_ACTION_GAMEPAD_STICK:
+            binding->stick.group = (InputAxisGroup)action_profile_read_varint(decoder);
+            binding->stick.controller_index = action_profile_read_signed(decoder);
+            break;
+        default:
+            decoder->corrupt = SDL_TRUE;
+            return;
+    }
+
+    binding->x = action_profile_read_float(decoder);
+    binding->y = action_profile_read_float(decoder);
+    if(!action_profile_binding_valid(binding))
+        decoder->corrupt = SDL_TRUE;
+}
+
+ActionProfile* action_profile_decode(const void* data, size_t size, const InputAllocator* allocator) {
+    ActionProfileDecoder decoder = { data, size, 0, SDL_FALSE };
+    if(size < sizeof(action_profile_magic) + 1 ||
+       SDL_memcmp(data, action_profile_magic, sizeof(action_profile_magic)) != 0 ||
+       decoder.data[sizeof(action_profile_magic)] != ACTION_PROFILE_VERSION)
+    {
+        SDL_SetError("Invalid action profile");
+        return NULL;
+    }
+
+    decoder.position = sizeof(action_profile_magic) + 1;
+    Uint32 action_count = action_profile_read_varint(&decoder);
+    Uint32 binding_count = action_profile_read_varint(&decoder);
+
+    // Every binding takes up at least 10 bytes, which keeps a corrupt count from allocating too much.
+    if(decoder.corrupt || action_count > ACTION_PROFILE_MAX_ACTIONS || binding_count > size / 10) {
+        SDL_SetError("Invalid action profile");
+        return NULL;
+    }
+
+    ActionProfile* profile = action_profile_create(action_count, (int)binding_count, allocator);
+    if(!profile)
+        return NULL;
+
+    Uint32 total = 0;
+    for(Uint32 i = 0; i < action_count && !decoder.corrupt; i++) {
+        Uint8 mode = action_profile_read_byte(&decoder);
+        Uint32 count = action_profile_read_varint(&decoder);
+        if(mode >= SDL_arraysize(action_profile_mode_names) || count > binding_count - total) {
+            decoder.corrupt = SDL_TRUE;
+            break;
+        }
+
+        profile->value_modes[i] = (ActionValueMode)mode;
+        profile->action_offsets[i] = (int)total;
+        for(Uint32 j = 0; j < count && !decoder.corrupt; j++)
+            action_profile_decode_binding(&decoder, &profile->bindings[total + j]);
+        total += count;
+    }
+    profile->action_offsets[action_count] = (int)total;
+
+    if(decoder.corrupt || total != binding_count) {
+        SDL_SetError("Invalid action profile");
+        action_profile_free(profile);
+        return NULL;
+    }
+
+    return profile;
+}
+
+// Reads either form, telling them apart by the magic number of the binary form.
+static ActionProfile* action_profile_read(const void* data, size_t size, const InputAllocator* allocator) {
+    if(size >= sizeof(action_profile_magic) && SDL_memcmp(data, action_profile_magic, sizeof(action_profile_magic)) == 0)
+        return action_profile_decode(data, size, allocator);
+
+    return action_profile_parse(data, size, allocator);
+}
+
+ActionProfile* action_profile_load(const char* path, const InputAllocator* allocator) {
+    size_t size;
+    void* data = SDL_LoadFile(path, &size);
+    if(!data)
+        return NULL;
+
+    ActionProfile* profile = action_profile_read(data, size, allocator);
+    SDL_free(data);
+    return profile;
+}
+
+ActionProfile* action_profile_from_manager(ActionManager* action_manager, const InputAllocator* allocator) {
+    int binding_count = 0;
+    for(int i = 0; i < action_manager->action_count; i++)
+        binding_count += action_manager->actions[i].action_count;
+
+    ActionProfile* profile = action_profile_create(action_manager->action_count, binding_count, allocator);
+    if(!profile)
+        return NULL;
+
+    int offset = 0;
+    for(int i = 0; i < action_manager->action_count; i++) {
+        InputActionMap* map = &action_manager->actions[i];
+        profile->action_offsets[i] = offset;
+        profile->value_modes[i] = map->value_mode;
+        if(map->action_count > 0)
+            input_memcpy(profile->bindings + offset, action_map_bindings(action_manager, map), sizeof(*map->actions) * map->action_count);
+        offset += map->action_count;
+    }
+    profile->action_offsets[action_manager->action_count] = offset;
+
+    return profile;
+}
+
+SDL_bool action_manager_apply_profile(ActionManager* action_manager, const ActionProfile* profile) {
+    if(!action_manager_set_bindings(action_manager, profile->bindings, profile->action_offsets, profile->value_modes, profile->action_count))
+        return SDL_FALSE;
+
+    action_manager_compile(action_manager);
+    return SDL_TRUE;
+}
+
+/*
+    Hot reloading.
+*/
+
+struct ActionProfileWatcher {
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    // Signalled to stop the thread, or to read the file early.
+    SDL_cond* wake;
+    SDL_bool quit;
+    SDL_bool check;
+    Uint32 interval;
+    // A hash of the contents the last profile was parsed from, so unchanged files aren't parsed again.
+    Uint64 hash;
+    SDL_bool loaded;
+    // The newest profile that hasn't been applied yet. Only ever exchanged atomically,
+    // so whichever thread takes it out owns it.
+    void* pending;
+    InputAllocator allocator;
+    char path[];
+};
+
+// FNV-1a, which is plenty to tell edits to a small text file apart.
+static Uint64 action_profile_hash(const Uint8* data, size_t size) {
+    Uint64 hash = 0xCBF29CE484222325ULL;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+static void action_profile_watcher_read(ActionProfileWatcher* watcher) {
+    size_t size;
+    Uint8* data = SDL_LoadFile(watcher->path, &size);
+
+    // The file can be missing or empty for a moment while an editor saves it, so it's tried again next time.
+    if(!data)
+        return;
+
+    if(size == 0) {
+        SDL_free(data);
+        return;
+    }
+
+    Uint64 hash = action_profile_hash(data, size);
+    if(watcher->loaded && hash == watcher->hash) {
+        SDL_free(data);
+        return;
+    }
+
+    watcher->hash = hash;
+    watcher->loaded = SDL_TRUE;
+
+    ActionProfile* profile = action_profile_read(data, size, &watcher->allocator);
+    SDL_free(data);
+    if(!profile) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_INPUT, "%s: %s", watcher->path, SDL_GetError());
+        return;
+    }
+
+    ActionProfile* replaced = SDL_AtomicSetPtr(&watcher->pending, profile);
+    if(replaced)
+        action_profile_free(replaced);
+}
+
+static int action_profile_watcher_run(void* data) {
+    ActionProfileWatcher* watcher = data;
+
+    SDL_LockMutex(watcher->lock);
+    while(!watcher->quit) {
+        SDL_UnlockMutex(watcher->lock);
+        action_profile_watcher_read(watcher);
+        SDL_LockMutex(watcher->lock);
+
+        if(!watcher->quit && !watcher->check)
+            SDL_CondWaitTimeout(watcher->wake, watcher->lock, watcher->interval);
+        watcher->check = SDL_FALSE;
+    }
+    SDL_UnlockMutex(watcher->lock);
+
+    return 0;
+}
+
+ActionProfileWatcher* action_profile_watch(const char* path, Uint32 interval, const InputAllocator* allocator) {
+    InputAllocator copy = allocator ? *allocator : (InputAllocator){ 0 };
+    size_t path_length = SDL_strlen(path);
+    ActionProfileWatcher* watcher = input_allocator_calloc(&copy, 1, sizeof(*watcher) + path_length + 1);
+    if(!watcher)
+        return NULL;
+
+    watcher->allocator = copy;
+    watcher->interval = interval;
+    input_memcpy(watcher->path, path, path_length + 1);
+
+    watcher->lock = SDL_CreateMutex();
+    watcher->wake = SDL_CreateCond();
+    if(!watcher->lock || !watcher->wake) {
+        action_profile_watcher_free(watcher);
+        return NULL;
+    }
+
+    watcher->thread = SDL_CreateThread(action_profile_watcher_run, "action_profile", watcher);
+    if(!watcher->thread) {
+        action_profile_watcher_free(watcher);
+        return NULL;
+    }
+
+    return watcher;
+}
+
+void action_profile_watcher_free(ActionProfileWatcher* watcher) {
+    if(watcher->thread) {
+        SDL_LockMutex(watcher->lock);
+        watcher->quit = SDL_TRUE;
+        SDL_CondSignal(watcher->wake);
+        SDL_UnlockMutex(watcher->lock);
+        SDL_WaitThread(watcher->thread, NULL);
+    }
+
+    if(watcher->wake)
+        SDL_DestroyCond(watcher->wake);
+    if(watcher->lock)
+        SDL_DestroyMutex(watcher->lock);
+
+    ActionProfile* pending = SDL_AtomicSetPtr(&watcher->pending, NULL);
+    if(pending)
+        action_profile_free(pending);
+
+    InputAllocator allocator = watcher->allocator;
+    input_allocator_free(&allocator, watcher);
+}
+
+void action_profile_watcher_check(ActionProfileWatcher* watcher) {
+    SDL_LockMutex(watcher->lock);
+    watcher->check = SDL_TRUE;
+    SDL_CondSignal(watcher->wake);
+    SDL_UnlockMutex(watcher->lock);
+}
+
+SDL_bool action_profile_watcher_apply(ActionProfileWatcher* watcher, ActionManager* action_manager) {
+    ActionProfile* profile = SDL_AtomicSetPtr(&watcher->pending, NULL);
+    if(!profile)
+        return SDL_FALSE;
+
+    if(!action_manager_apply_profile(action_manager, profile)) {
+        // Kept for the next call, unless a newer profile has already taken its place.
+        if(!SDL_AtomicCASPtr(&watcher->pending, NULL, profile))
+            action_profile_free(profile);
+        return SDL_FALSE;
+    }
+
+    action_profile_free(profile);
+    return SDL_TRUE;
+}
@@ -0,0 +1,338 @@
+#include <action_snapshot.h>
+
+#include "std_definitions.h"
+#include "action_internal.h"
+
+/*
+    Snapshot layout: the action states as a bitset, followed by the quantized x and y value of every action,
+    zero padded to a multiple of 8 bytes so snapshots stored one after another stay aligned for the bitset.
+
+    Encoded layout, as a stream of bits starting from the lowest bit of each byte:
+
+    1 bit: set if encoded against a base
+    full:
+        action_count bits: the action states
+        list: actions whose value isn't what their state implies (1 or 0 on x, 0 on y), each followed by 8 bits x, 8 bits y
+    delta:
+        list: actions whose state changed
+        list: actions whose value changed, each followed by 8 bits x, 8 bits y
+
+    A list is the amount of entries + 1 followed by the gap before each action + 1, all Elias gamma coded,
+    so an update where nothing changed fits in a single byte.
+*/
+
+#define ACTION_SNAPSHOT_SCALE 127
+
+typedef struct ActionSnapshotWriter {
+    Uint8* buffer;
+    size_t capacity;
+    size_t bit;
+} ActionSnapshotWriter;
+
+typedef struct ActionSnapshotReader {
+    const Uint8* data;
+    size_t size;
+    size_t bit;
+} ActionSnapshotReader;
+
+static inline int action_snapshot_words(ActionManager* action_manager) {
+    return INPUT_BITSET_WORDS(action_manager->action_count);
+}
+
+static inline const Sint8* action_snapshot_values(ActionManager* action_manager, const void* snapshot) {
+    return (const Sint8*)((const Uint64*)snapshot + action_snapshot_words(action_manager));
+}
+
+static Sint8 action_snapshot_quantize(float value) {
+    float scaled = value * ACTION_SNAPSHOT_SCALE;
+    if(scaled >= ACTION_SNAPSHOT_SCALE)
+        return ACTION_SNAPSHOT_SCALE;
+    if(scaled <= -ACTION_SNAPSHOT_SCALE)
+        return -ACTION_SNAPSHOT_SCALE;
+    return (Sint8)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+static int action_snapshot_bit_length(Uint32 value) {
+    int length = 0;
+    while(value) {
+        length++;
+        value >>= 1;
+    }
+    return length;
+}
+
+static SDL_bool action_snapshot_write_bits(ActionSnapshotWriter* writer, Uint32 value, int count) {
+    if(writer->bit + count > writer->capacity * 8)
+        return SDL_FALSE;
+
+    for(int i = 0; i < count; i++, writer->bit++) {
+        Uint8 mask = (Uint8)(1 << (writer->bit & 7));
+        if(value >> i & 1)
+            writer->buffer[writer->bit >> 3] |= mask;
+        else
+            writer->buffer[writer->bit >> 3] &= ~mask;
+    }
+
+    return SDL_TRUE;
+}
+
+// Writes a value >= 1 as length - 1 zeroes followed by the value from the highest bit down.
+static SDL_bool action_snapshot_write_gamma(ActionSnapshotWriter* writer, Uint32 value) {
+    int length = action_snapshot_bit_length(value);
+    if(!action_snapshot_write_bits(writer, 0, length - 1))
+        return SDL_FALSE;
+
+    for(int i = length - 1; i >= 0; i--) {
+        if(!action_snapshot_write_bits(writer, value >> i & 1, 1))
+            return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+
+static SDL_bool action_snapshot_read_bits(ActionSnapshotReader* reader, int count, Uint32* value) {
+    if(reader->bit + count > reader->size * 8)
+        return SDL_FALSE;
+
+    *value = 0;
+    for(int i = 0; i < count; i++, reader->bit++)
+        *value |= (Uint32)(reader->data[reader->bit >> 3] >> (reader->bit & 7) & 1) << i;
+
+    return SDL_TRUE;
+}
+
+static SDL_bool action_snapshot_read_gamma(ActionSnapshotReader* reader, Uint32* value) {
+    int zeroes = 0;
+    Uint32 bit;
+    for(;;) {
+        if(!action_snapshot_read_bits(reader, 1, &bit))
+            return SDL_FALSE;
+        if(bit)
+            break;
+        if(++zeroes >= 32)
+            return SDL_FALSE;
+    }
+
+    *value = 1;
+    for(int i = 0; i < zeroes; i++) {
+        if(!action_snapshot_read_bits(reader, 1, &bit))
+            return SDL_FALSE;
+        *value = *value << 1 | bit;
+    }
+
+    return SDL_TRUE;
+}
+
+static SDL_bool action_snapshot_write_value(ActionSnapshotWriter* writer, const Sint8* values, int action) {
+    return action_snapshot_write_bits(writer, (Uint8)values[action * 2], 8) &&
+           action_snapshot_write_bits(writer, (Uint8)values[action * 2 + 1], 8);
+}
+
+static SDL_bool action_snapshot_read_value(ActionSnapshotReader* reader, Sint8* values, int action) {
+    Uint32 x, y;
+    if(!action_snapshot_read_bits(reader, 8, &x) || !action_snapshot_read_bits(reader, 8, &y))
+        return SDL_FALSE;
+
+    values[action * 2] = (Sint8)(Uint8)x;
+    values[action * 2 + 1] = (Sint8)(Uint8)y;
+    return SDL_TRUE;
+}
+
+// Whether the value of an action in a full snapshot is implied by its state.
+static inline SDL_bool action_snapshot_value_implied(const Uint64* bits, const Sint8* values, int action) {
+    return values[action * 2] == (input_bitset_test(bits, action) ? ACTION_SNAPSHOT_SCALE : 0) &&
+           values[action * 2 + 1] == 0;
+}
+
+static inline SDL_bool action_snapshot_value_changed(const Sint8* values, const Sint8* base_values, int action) {
+    return values[action * 2] != base_values[action * 2] || values[action * 2 + 1] != base_values[action * 2 + 1];
+}
+
+// Lists the set bits of a bitset.
+static SDL_bool action_snapshot_write_bit_list(ActionSnapshotWriter* writer, const Uint64* bits, const Uint64* base, int words) {
+    Uint32 count = 0;
+    for(int i = 0; i < words; i++)
+        count += input_bits_count(bits[i] ^ base[i]);
+
+    if(!action_snapshot_write_gamma(writer, count + 1))
+        return SDL_FALSE;
+
+    int last = -1;
+    for(int i = 0; i < words; i++) {
+        Uint64 changed = bits[i] ^ base[i];
+        while(changed) {
+            int action = i * 64 + input_bits_lowest(changed);
+            changed &= changed - 1;
+
+            if(!action_snapshot_write_gamma(writer, (Uint32)(action - last)))
+                return SDL_FALSE;
+            last = action;
+        }
+    }
+
+    return SDL_TRUE;
+}
+
+// Lists the actions whose value isn't implied (base is NULL) or changed, along with the value.
+static SDL_bool action_snapshot_write_value_list(ActionSnapshotWriter* writer, int action_count, const Uint64* bits, const Sint8* values, const Sint8* base_values) {
+    Uint32 count = 0;
+    for(int i = 0; i < action_count; i++) {
+        if(base_values ? action_snapshot_value_changed(values, base_values, i) : !action_snapshot_value_implied(bits, values, i))
+            count++;
+    }
+
+    if(!action_snapshot_write_gamma(writer, count + 1))
+        return SDL_FALSE;
+
+    int last = -1;
+    for(int i = 0; i < action_count && count > 0; i++) {
+        if(base_values ? !action_snapshot_value_changed(values, base_values, i) : action_snapshot_value_implied(bits, values, i))
+            continue;
+
+        if(!action_snapshot_write_gamma(writer, (Uint32)(i - last)) || !action_snapshot_write_value(writer, values, i))
+            return SDL_FALSE;
+
+        last = i;
+        count--;
+    }
+
+    return SDL_TRUE;
+}
+
+// Reads a list of actions, calling either flip_bits or read_values for each one.
+static SDL_bool action_snapshot_read_list(ActionSnapshotReader* reader, int action_count, Uint64* flip_bits, Sint8* read_values) {
+    Uint32 count;
+    if(!action_snapshot_read_gamma(reader, &count) || count - 1 > (Uint32)action_count)
+        return SDL_FALSE;
+
+    Sint64 action = -1;
+    for(Uint32 i = 0; i < count - 1; i++) {
+        Uint32 gap;
+        if(!action_snapshot_read_gamma(reader, &gap))
+            return SDL_FALSE;
+
+        action += gap;
+        if(action >= action_count)
+            return SDL_FALSE;
+
+        if(flip_bits)
+            flip_bits[action / 64] ^= (Uint64)1 << (action % 64);
+        else if(!action_snapshot_read_value(reader, read_values, (int)action))
+            return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+
+size_t action_snapshot_size(ActionManager* action_manager) {
+    size_t values = ((size_t)action_manager->action_count * 2 + sizeof(Uint64) - 1) & ~(sizeof(Uint64) - 1);
+    return action_snapshot_words(action_manager) * sizeof(Uint64) + values;
+}
+
+// Clears the padding after the values, so snapshots of the same state are identical.
+static void action_snapshot_clear_padding(ActionManager* action_manager, Sint8* values) {
+    size_t used = (size_t)action_manager->action_count * 2;
+    size_t padding = action_snapshot_size(action_manager) - action_snapshot_words(action_manager) * sizeof(Uint64) - used;
+    input_memset(values + used, 0, padding);
+}
+
+size_t action_snapshot_max_encoded_size(ActionManager* action_manager) {
+    size_t count = (size_t)action_manager->action_count;
+    size_t gamma = (size_t)action_snapshot_bit_length((Uint32)count + 1) * 2 - 1;
+
+    // A delta with every state and value changed is always longer than a full snapshot.
+    size_t bits = 1 + gamma * 2 + count * (gamma * 2 + 16);
+    return (bits + 7) / 8;
+}
+
+void action_snapshot_save(ActionManager* action_manager, void* snapshot) {
+    int words = action_snapshot_words(action_manager);
+    input_memcpy(snapshot, action_manager->current, words * sizeof(Uint64));
+
+    Sint8* values = (Sint8*)((Uint64*)snapshot + words);
+    for(int i = 0; i < action_manager->action_count; i++) {
+        values[i * 2] = action_snapshot_quantize(action_manager->value_x[i]);
+        values[i * 2 + 1] = action_snapshot_quantize(action_manager->value_y[i]);
+    }
+
+    action_snapshot_clear_padding(action_manager, values);
+}
+
+void action_snapshot_restore(ActionManager* action_manager, const void* snapshot, const void* previous) {
+    int words = action_snapshot_words(action_manager);
+    if(previous)
+        input_memcpy(action_manager->previous, previous, words * sizeof(Uint64));
+    else
+        input_memcpy(action_manager->previous, action_manager->current, words * sizeof(Uint64));
+
+    input_memcpy(action_manager->current, snapshot, words * sizeof(Uint64));
+
+    const Sint8* values = action_snapshot_values(action_manager, snapshot);
+    for(int i = 0; i < action_manager->action_count; i++) {
+        action_manager->value_x[i] = (float)values[i * 2] / ACTION_SNAPSHOT_SCALE;
+        action_manager->value_y[i] = (float)values[i * 2 + 1] / ACTION_SNAPSHOT_SCALE;
+    }
+
+    // The states no longer match the inputs, so the next update has to look at every binding.
+    action_manager->masks.primed = SDL_FALSE;
+}
+
+size_t action_snapshot_encode(ActionManager* action_manager, const void* snapshot, const void* base, Uint8* buffer, size_t capacity) {
+    ActionSnapshotWriter writer = { buffer, capacity, 0 };
+    int words = action_snapshot_words(action_manager);
+    const Uint64* bits = snapshot;
+    const Sint8* values = action_snapshot_values(action_manager, snapshot);
+
+    if(!action_snapshot_write_bits(&writer, base ? 1 : 0, 1))
+        return 0;
+
+    if(base) {
+        if(!action_snapshot_write_bit_list(&writer, bits, base, words) ||
+           !action_snapshot_write_value_list(&writer, action_manager->action_count, bits, values, action_snapshot_values(action_manager, base)))
+            return 0;
+    } else {
+        for(int i = 0; i < action_manager->action_count; i++) {
+            if(!action_snapshot_write_bits(&writer, input_bitset_test(bits, i) ? 1 : 0, 1))
+                return 0;
+        }
+
+        if(!action_snapshot_write_value_list(&writer, action_manager->action_count, bits, values, NULL))
+            return 0;
+    }
+
+    return (writer.bit + 7) / 8;
+}
+
+SDL_bool action_snapshot_decode(ActionManager* action_manager, const Uint8* data, size_t size, const void* base, void* snapshot) {
+    ActionSnapshotReader reader = { data, size, 0 };
+    int words = action_snapshot_words(action_manager);
+    int action_count = action_manager->action_count;
+    Uint64* bits = snapshot;
+    Sint8* values = (Sint8*)(bits + words);
+
+    Uint32 delta;
+    if(!action_snapshot_read_bits(&reader, 1, &delta) || (delta && !base))
+        return SDL_FALSE;
+
+    if(delta) {
+        if(snapshot != base)
+            input_memmove(snapshot, base, action_snapshot_size(action_manager));
+
+        return action_snapshot_read_list(&reader, action_count, bits, NULL) &&
+               action_snapshot_read_list(&reader, action_count, NULL, values);
+    }
+
+    input_memset(bits, 0, words * sizeof(Uint64));
+    action_snapshot_clear_padding(action_manager, values);
+    for(int i = 0; i < action_count; i++) {
+        Uint32 bit;
+        if(!action_snapshot_read_bits(&reader, 1, &bit))
+            return SDL_FALSE;
+        if(bit)
+            input_bitset_set(bits, i);
+        values[i * 2] = bit ? ACTION_SNAPSHOT_SCALE : 0;
+        values[i * 2 + 1] = 0;
+    }
+
+    return action_snapshot_read_list(&reader, action_count, NULL, values);
+}
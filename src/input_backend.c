@@ -0,0 +1,88 @@
+#include <input_manager.h>
+
+#include "std_definitions.h"
+#include "input_simd.h"
+
+static SDL_bool input_backend_sdl_init(void* ctx) {
+    (void)ctx;
+
+    if(!SDL_WasInit(SDL_INIT_GAMECONTROLLER)) {
+        if(SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) != 0)
+            return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+
+static Uint32 input_backend_sdl_get_ticks(void* ctx) {
+    (void)ctx;
+    return SDL_GetTicks();
+}
+
+static void input_backend_sdl_get_keyboard(void* ctx, Uint64* keys, int words) {
+    (void)ctx;
+
+    int key_count;
+    const Uint8* keyboard = SDL_GetKeyboardState(&key_count);
+    input_simd_pack_bytes(keyboard, key_count, keys, words);
+}
+
+static Uint32 input_backend_sdl_get_mouse(void* ctx, int* x, int* y) {
+    (void)ctx;
+    return SDL_GetMouseState(x, y);
+}
+
+static void input_backend_sdl_get_gamepad(void* ctx, SDL_GameController* controller, Uint32* buttons, Sint16* axes) {
+    (void)ctx;
+    *buttons = 0;
+
+    for(int i = SDL_CONTROLLER_BUTTON_A; i < SDL_CONTROLLER_BUTTON_MAX; i++) {
+        if(SDL_GameControllerGetButton(controller, i))
+            *buttons |= ___INPUT_GAMEPAD_BUTTON(i);
+    }
+
+    for(int i = SDL_CONTROLLER_AXIS_LEFTX; i < SDL_CONTROLLER_AXIS_MAX; i++)
+        axes[i] = SDL_GameControllerGetAxis(controller, i);
+}
+
+static SDL_GameController* input_backend_sdl_open_gamepad(void* ctx, int device_index, SDL_JoystickID* instance_id) {
+    (void)ctx;
+
+    SDL_GameController* controller = SDL_GameControllerOpen(device_index);
+    if(controller)
+        *instance_id = SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(controller));
+
+    return controller;
+}
+
+static void input_backend_sdl_close_gamepad(void* ctx, SDL_GameController* controller) {
+    (void)ctx;
+    SDL_GameControllerClose(controller);
+}
+
+static SDL_bool input_backend_sdl_set_mouse_relative(void* ctx, SDL_bool enabled) {
+    (void)ctx;
+    return SDL_SetRelativeMouseMode(enabled) == 0 ? SDL_TRUE : SDL_FALSE;
+}
+
+InputBackend input_backend_sdl(void) {
+    InputBackend backend = {
+        NULL,
+        input_backend_sdl_init,
+        input_backend_sdl_get_ticks,
+        input_backend_sdl_get_keyboard,
+        input_backend_sdl_get_mouse,
+        input_backend_sdl_get_gamepad,
+        input_backend_sdl_open_gamepad,
+        input_backend_sdl_close_gamepad,
+        input_backend_sdl_set_mouse_relative
+    };
+
+    return backend;
+}
+
+InputBackend input_backend_virtual(void) {
+    InputBackend backend;
+    SDL_zero(backend);
+    return backend;
+}
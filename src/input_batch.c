@@ -0,0 +1,125 @@
+#include <input_batch.h>
+
+#include "std_definitions.h"
+
+// Claims and updates chunks of pairs until there are none left.
+static void input_batch_run(InputBatch* batch) {
+    for(;;) {
+        int start = SDL_AtomicAdd(&batch->next, INPUT_BATCH_CHUNK);
+        if(start >= batch->count)
+            return;
+
+        int end = start + INPUT_BATCH_CHUNK < batch->count ? start + INPUT_BATCH_CHUNK : batch->count;
+        for(int i = start; i < end; i++) {
+            input_manager_update(batch->inputs[i]);
+            if(batch->actions && batch->actions[i])
+                action_manager_update(batch->actions[i], batch->inputs[i]);
+        }
+    }
+}
+
+static int input_batch_worker(void* data) {
+    InputBatch* batch = data;
+    Uint32 generation = 0;
+
+    SDL_LockMutex(batch->lock);
+    for(;;) {
+        while(!batch->quit && batch->generation == generation)
+            SDL_CondWait(batch->start, batch->lock);
+
+        if(batch->quit)
+            break;
+
+        generation = batch->generation;
+        SDL_UnlockMutex(batch->lock);
+
+        input_batch_run(batch);
+
+        SDL_LockMutex(batch->lock);
+        if(--batch->running == 0)
+            SDL_CondSignal(batch->done);
+    }
+    SDL_UnlockMutex(batch->lock);
+
+    return 0;
+}
+
+InputBatch* input_batch_create(int threads, const InputAllocator* allocator) {
+    InputAllocator copy = allocator ? *allocator : (InputAllocator){ 0 };
+    InputBatch* batch = input_allocator_calloc(&copy, 1, sizeof(*batch));
+    if(!batch)
+        return NULL;
+
+    batch->allocator = copy;
+    if(threads <= 0)
+        return batch;
+
+    batch->threads = input_allocator_calloc(&copy, threads, sizeof(*batch->threads));
+    batch->lock = SDL_CreateMutex();
+    batch->start = SDL_CreateCond();
+    batch->done = SDL_CreateCond();
+    if(!batch->threads || !batch->lock || !batch->start || !batch->done) {
+        input_batch_free(batch);
+        return NULL;
+    }
+
+    for(; batch->thread_count < threads; batch->thread_count++) {
+        SDL_Thread* thread = SDL_CreateThread(input_batch_worker, "input_batch", batch);
+        if(!thread) {
+            input_batch_free(batch);
+            return NULL;
+        }
+        batch->threads[batch->thread_count] = thread;
+    }
+
+    return batch;
+}
+
+void input_batch_free(InputBatch* batch) {
+    if(batch->thread_count > 0) {
+        SDL_LockMutex(batch->lock);
+        batch->quit = SDL_TRUE;
+        SDL_CondBroadcast(batch->start);
+        SDL_UnlockMutex(batch->lock);
+
+        for(int i = 0; i < batch->thread_count; i++)
+            SDL_WaitThread(batch->threads[i], NULL);
+    }
+
+    if(batch->done)
+        SDL_DestroyCond(batch->done);
+    if(batch->start)
+        SDL_DestroyCond(batch->start);
+    if(batch->lock)
+        SDL_DestroyMutex(batch->lock);
+
+    InputAllocator allocator = batch->allocator;
+    input_allocator_free(&allocator, batch->threads);
+    input_allocator_free(&allocator, batch);
+}
+
+void input_batch_update(InputBatch* batch, InputManager** inputs, ActionManager** actions, int count) {
+    batch->inputs = inputs;
+    batch->actions = actions;
+    batch->count = count;
+    SDL_AtomicSet(&batch->next, 0);
+
+    // Waking the workers costs more than a single chunk of work.
+    if(batch->thread_count == 0 || count <= INPUT_BATCH_CHUNK) {
+        input_batch_run(batch);
+        return;
+    }
+
+    SDL_LockMutex(batch->lock);
+    batch->generation++;
+    batch->running = batch->thread_count;
+    SDL_CondBroadcast(batch->start);
+    SDL_UnlockMutex(batch->lock);
+
+    input_batch_run(batch);
+
+    SDL_LockMutex(batch->lock);
+    while(batch->running > 0)
+        SDL_CondWait(batch->done, batch->lock);
+    SDL_UnlockMutex(batch->lock);
+}
@@ -0,0 +1,312 @@
+#include <input_event_queue.h>
+
+#include "std_definitions.h"
+#include "input_internal.h"
+
+InputEventQueue* input_event_queue_create(Uint32 capacity) {
+    Uint32 size = 2;
+    while(size < capacity)
+        size <<= 1;
+
+    InputEventQueue* queue = input_calloc(1, sizeof(*queue));
+    if(!queue)
+        return NULL;
+
+    queue->events = input_malloc(size * sizeof(*queue->events));
+    if(!queue->events) {
+        input_free(queue);
+        return NULL;
+    }
+
+    queue->mask = size - 1;
+    SDL_AtomicSet(&queue->head, 0);
+    SDL_AtomicSet(&queue->tail, 0);
+
+    return queue;
+}
+
+void input_event_queue_free(InputEventQueue* queue) {
+    for(int i = 0; i < queue->controller_count; i++)
+        SDL_GameControllerClose(queue->controllers[i].controller);
+
+    input_free(queue->controllers);
+    input_free(queue->events);
+    input_free(queue);
+}
+
+SDL_bool input_event_queue_push(InputEventQueue* queue, const InputEvent* event) {
+    Uint32 tail = (Uint32)SDL_AtomicGet(&queue->tail);
+    Uint32 head = (Uint32)SDL_AtomicGet(&queue->head);
+    SDL_MemoryBarrierAcquire();
+
+    if(tail - head > queue->mask) {
+        queue->dropped++;
+        return SDL_FALSE;
+    }
+
+    queue->events[tail & queue->mask] = *event;
+
+    // The event has to be visible before the consumer can see the new tail.
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->tail, (int)(tail + 1));
+    return SDL_TRUE;
+}
+
+SDL_bool input_event_queue_pop(InputEventQueue* queue, InputEvent* event) {
+    Uint32 head = (Uint32)SDL_AtomicGet(&queue->head);
+    Uint32 tail = (Uint32)SDL_AtomicGet(&queue->tail);
+    SDL_MemoryBarrierAcquire();
+
+    if(head == tail)
+        return SDL_FALSE;
+
+    *event = queue->events[head & queue->mask];
+
+    // The event has to be read before the producer is allowed to overwrite it.
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->head, (int)(head + 1));
+    return SDL_TRUE;
+}
+
+// Opens the controller of an added event, so the consumer never has to. Returns NULL if it was already open.
+static SDL_GameController* input_event_queue_open(InputEventQueue* queue, int device_index, SDL_JoystickID* instance_id) {
+    SDL_GameController* controller = SDL_GameControllerOpen(device_index);
+    if(!controller)
+        return NULL;
+
+    *instance_id = SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(controller));
+
+    // Some platforms send an added event for controllers that were already opened, so the extra reference is closed again.
+    for(int i = 0; i < queue->controller_count; i++) {
+        if(queue->controllers[i].instance_id == *instance_id) {
+            SDL_GameControllerClose(controller);
+            return NULL;
+        }
+    }
+
+    if(queue->controller_count == queue->controller_capacity) {
+        int capacity = queue->controller_capacity ? queue->controller_capacity * 2 : 4;
+        InputQueueController* controllers = input_realloc(queue->controllers, capacity * sizeof(*controllers));
+        if(!controllers) {
+            SDL_GameControllerClose(controller);
+            return NULL;
+        }
+
+        queue->controllers = controllers;
+        queue->controller_capacity = capacity;
+    }
+
+    queue->controllers[queue->controller_count].controller = controller;
+    queue->controllers[queue->controller_count].instance_id = *instance_id;
+    queue->controller_count++;
+    return controller;
+}
+
+static void input_event_queue_close(InputEventQueue* queue, SDL_JoystickID instance_id) {
+    for(int i = 0; i < queue->controller_count; i++) {
+        if(queue->controllers[i].instance_id == instance_id) {
+            SDL_GameControllerClose(queue->controllers[i].controller);
+            queue->controllers[i] = queue->controllers[--queue->controller_count];
+            return;
+        }
+    }
+}
+
+// Pushes an added gamepad, followed by its current state since events only report changes.
+static SDL_bool input_event_queue_push_added(InputEventQueue* queue, Uint32 timestamp, int device_index) {
+    SDL_JoystickID instance_id;
+    SDL_GameController* controller = input_event_queue_open(queue, device_index, &instance_id);
+    if(!controller)
+        return SDL_FALSE;
+
+    InputEvent input_event;
+    SDL_zero(input_event);
+    input_event.timestamp = timestamp;
+    input_event.type = INPUT_EVENT_GAMEPAD_ADDED;
+    input_event.which = instance_id;
+    if(!input_event_queue_push(queue, &input_event))
+        return SDL_FALSE;
+
+    input_event.type = INPUT_EVENT_GAMEPAD_BUTTON;
+    input_event.down = 1;
+    for(int button = 0; button < SDL_CONTROLLER_BUTTON_MAX; button++) {
+        input_event.code = (Uint16)button;
+        if(SDL_GameControllerGetButton(controller, (SDL_GameControllerButton)button) && !input_event_queue_push(queue, &input_event))
+            return SDL_FALSE;
+    }
+
+    input_event.type = INPUT_EVENT_GAMEPAD_AXIS;
+    input_event.down = 0;
+    for(int axis = 0; axis < SDL_CONTROLLER_AXIS_MAX; axis++) {
+        input_event.code = (Uint16)axis;
+        input_event.axis = SDL_GameControllerGetAxis(controller, (SDL_GameControllerAxis)axis);
+        if(input_event.axis != 0 && !input_event_queue_push(queue, &input_event))
+            return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+
+// Converts every input event except added and removed controllers. Returns SDL_FALSE for anything else.
+static SDL_bool input_event_convert(const SDL_Event* event, InputEvent* input_event) {
+    input_event->timestamp = event->common.timestamp;
+    input_event->down = 0;
+    input_event->code = 0;
+    input_event->which = 0;
+
+    switch(event->type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            if(event->key.repeat)
+                return SDL_FALSE;
+            input_event->type = INPUT_EVENT_KEY;
+            input_event->down = event->key.state;
+            input_event->code = (Uint16)event->key.keysym.scancode;
+            return SDL_TRUE;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            input_event->type = INPUT_EVENT_MOUSE_BUTTON;
+            input_event->down = event->button.state;
+            input_event->code = event->button.button;
+            return SDL_TRUE;
+        case SDL_MOUSEMOTION:
+            input_event->type = INPUT_EVENT_MOUSE_MOTION;
+            input_event->point.x = event->motion.x;
+            input_event->point.y = event->motion.y;
+            input_event->delta.x = event->motion.xrel;
+            input_event->delta.y = event->motion.yrel;
+            return SDL_TRUE;
+        case SDL_MOUSEWHEEL: {
+            int flip = event->wheel.direction == SDL_MOUSEWHEEL_FLIPPED ? -1 : 1;
+            input_event->type = INPUT_EVENT_MOUSE_WHEEL;
+            input_event->point.x = event->wheel.x * flip;
+            input_event->point.y = event->wheel.x != 0 ? 0 : event->wheel.y * flip;
+            return SDL_TRUE;
+        }
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+            input_event->type = INPUT_EVENT_GAMEPAD_BUTTON;
+            input_event->down = event->cbutton.state;
+            input_event->code = event->cbutton.button;
+            input_event->which = event->cbutton.which;
+            return SDL_TRUE;
+        case SDL_CONTROLLERAXISMOTION:
+            input_event->type = INPUT_EVENT_GAMEPAD_AXIS;
+            input_event->code = event->caxis.axis;
+            input_event->which = event->caxis.which;
+            input_event->axis = event->caxis.value;
+            return SDL_TRUE;
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+        case SDL_FINGERMOTION:
+            input_event->type = INPUT_EVENT_TOUCH;
+            input_event->touch = event->tfinger;
+            return SDL_TRUE;
+        default:
+            return SDL_FALSE;
+    }
+}
+
+SDL_bool input_event_queue_push_sdl(InputEventQueue* queue, const SDL_Event* event) {
+    InputEvent input_event;
+
+    switch(event->type) {
+        case SDL_CONTROLLERDEVICEADDED:
+            // Unlike every other gamepad event, which is the device index here.
+            return input_event_queue_push_added(queue, event->cdevice.timestamp, event->cdevice.which);
+        case SDL_CONTROLLERDEVICEREMOVED:
+            input_event_queue_close(queue, event->cdevice.which);
+            SDL_zero(input_event);
+            input_event.timestamp = event->cdevice.timestamp;
+            input_event.type = INPUT_EVENT_GAMEPAD_REMOVED;
+            input_event.which = event->cdevice.which;
+            return input_event_queue_push(queue, &input_event);
+        default:
+            return input_event_convert(event, &input_event) && input_event_queue_push(queue, &input_event);
+    }
+}
+
+SDL_bool input_event_queue_push_deferred(InputEventQueue* queue, const SDL_Event* event) {
+    InputEvent input_event;
+
+    switch(event->type) {
+        case SDL_CONTROLLERDEVICEADDED:
+        case SDL_CONTROLLERDEVICEREMOVED:
+            SDL_zero(input_event);
+            input_event.timestamp = event->cdevice.timestamp;
+            input_event.type = INPUT_EVENT_CONTROLLER_DEVICE;
+            input_event.down = event->type == SDL_CONTROLLERDEVICEADDED;
+            input_event.which = event->cdevice.which;
+            return input_event_queue_push(queue, &input_event);
+        default:
+            return input_event_convert(event, &input_event) && input_event_queue_push(queue, &input_event);
+    }
+}
+
+void input_manager_apply_event(InputManager* input, const InputEvent* event) {
+    switch(event->type) {
+        case INPUT_EVENT_KEY:
+            input_manager_set_key_at(input, (SDL_Scancode)event->code, event->down ? SDL_TRUE : SDL_FALSE, event->timestamp);
+            break;
+        case INPUT_EVENT_MOUSE_BUTTON:
+            input_manager_set_mouse_button_at(input, event->code, event->down ? SDL_TRUE : SDL_FALSE, event->timestamp);
+            break;
+        case INPUT_EVENT_MOUSE_MOTION:
+            input_manager_add_mouse_motion(input, event->point.x, event->point.y, event->delta.x, event->delta.y, event->timestamp);
+            break;
+        case INPUT_EVENT_MOUSE_WHEEL:
+            input_manager_add_mouse_wheel_at(input, event->point.x, event->point.y, event->timestamp);
+            break;
+        case INPUT_EVENT_GAMEPAD_BUTTON:
+            input_manager_set_gamepad_button_at(input, event->which, event->code, event->down ? SDL_TRUE : SDL_FALSE, event->timestamp);
+            break;
+        case INPUT_EVENT_GAMEPAD_AXIS:
+            input_manager_set_gamepad_axis_at(input, event->which, event->code, event->axis, event->timestamp);
+            break;
+        // The controller stays with the producer, so the gamepad is only fed by the queued events.
+        case INPUT_EVENT_GAMEPAD_ADDED:
+            INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_GAMEPAD_DEVICE], 1);
+            input_manager_add_virtual_gamepad(input, event->which, -1);
+            break;
+        case INPUT_EVENT_GAMEPAD_REMOVED:
+            INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_GAMEPAD_DEVICE], 1);
+            input_manager_remove_virtual_gamepad(input, event->which);
+            break;
+        case INPUT_EVENT_CONTROLLER_DEVICE: {
+            SDL_ControllerDeviceEvent device;
+            SDL_zero(device);
+            device.type = event->down ? SDL_CONTROLLERDEVICEADDED : SDL_CONTROLLERDEVICEREMOVED;
+            device.timestamp = event->timestamp;
+            device.which = event->which;
+            input_manager_controller_event(input, &device);
+            break;
+        }
+        case INPUT_EVENT_TOUCH: {
+            SDL_TouchFingerEvent touch = event->touch;
+            input_manager_touch_event(input, &touch);
+            break;
+        }
+    }
+}
+
+int input_event_queue_drain(InputEventQueue* queue, InputManager* input, Uint32 until) {
+    Uint32 head = (Uint32)SDL_AtomicGet(&queue->head);
+    Uint32 tail = (Uint32)SDL_AtomicGet(&queue->tail);
+    SDL_MemoryBarrierAcquire();
+
+    int applied = 0;
+    for(; head != tail; head++) {
+        const InputEvent* event = &queue->events[head & queue->mask];
+        // Compared with a signed difference so the timestamps can wrap around.
+        if((Sint32)(event->timestamp - until) > 0)
+            break;
+
+        input_manager_apply_event(input, event);
+        applied++;
+    }
+
+    // Hands all of the applied slots back to the producer at once.
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->head, (int)head);
+    return applied;
+}
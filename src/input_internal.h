@@ -0,0 +1,97 @@
+#ifndef SDL_INPUT_INPUT_INTERNAL_H
+#define SDL_INPUT_INPUT_INTERNAL_H
+
+#include <input_manager.h>
+#include <input_event_queue.h>
+
+#include "std_definitions.h"
+#include "input_stats_internal.h"
+
+/*
+    Functions shared between the different ways an <InputManager> can be updated.
+    Everything that fills in the current state should be wrapped in these.
+*/
+
+// Allocations made by an <InputManager>, counted in its stats.
+
+static inline void* input_manager_allocate(InputManager* input, size_t size) {
+    INPUT_STATS_ADD(&input->stats, allocations, 1);
+    return input_allocator_malloc(&input->allocator, size);
+}
+
+static inline void* input_manager_allocate_zeroed(InputManager* input, size_t count, size_t size) {
+    INPUT_STATS_ADD(&input->stats, allocations, 1);
+    return input_allocator_calloc(&input->allocator, count, size);
+}
+
+static inline void* input_manager_reallocate(InputManager* input, void* ptr, size_t size) {
+    if(ptr)
+        INPUT_STATS_ADD(&input->stats, reallocations, 1);
+    else
+        INPUT_STATS_ADD(&input->stats, allocations, 1);
+    return input_allocator_realloc(&input->allocator, ptr, size);
+}
+
+static inline void input_manager_deallocate(InputManager* input, void* ptr) {
+    input_allocator_free(&input->allocator, ptr);
+}
+
+/*
+    Converts an SDL event and adds it to a queue like <input_event_queue_push_sdl>, except that added and removed
+    controllers are left to the manager the queue is drained into, as <INPUT_EVENT_CONTROLLER_DEVICE>.
+*/
+SDL_bool input_event_queue_push_deferred(InputEventQueue* queue, const SDL_Event* event);
+
+// Applies the events that <input_manager_watch_events> saw on other threads.
+void input_manager_drain_watch(InputManager* input);
+
+// Moves the current state of an <InputManager> into the previous state.
+void input_manager_begin_update(InputManager* input);
+
+// Computes the edges of the new state and finishes swapping the touch buffers.
+void input_manager_end_update(InputManager* input);
+
+/*
+    The input_manager_set_* functions, along with the timestamp of the event that caused the change,
+    which is kept to measure the latency of the actions it changes. Pass 0 when there's no event.
+*/
+
+void input_manager_set_key_at(InputManager* input, SDL_Scancode key, SDL_bool down, Uint32 timestamp);
+void input_manager_set_mouse_button_at(InputManager* input, int button, SDL_bool down, Uint32 timestamp);
+void input_manager_add_mouse_wheel_at(InputManager* input, int x, int y, Uint32 timestamp);
+void input_manager_set_gamepad_button_at(InputManager* input, SDL_JoystickID instance_id, int button, SDL_bool down, Uint32 timestamp);
+void input_manager_set_gamepad_axis_at(InputManager* input, SDL_JoystickID instance_id, int axis, Sint16 value, Uint32 timestamp);
+
+// Sets up the finger table and the default gesture settings.
+void input_touch_init(InputManager* input);
+
+// Makes the gestures recognized since the last update visible, and removes the fingers that were lifted before it.
+void input_touch_update(InputManager* input);
+
+// Recognizes the gestures that only depend on time passing, i.e. long presses.
+void input_gesture_advance(InputManager* input, Uint32 time);
+
+// Determines if <input_gesture_advance> depends on the time it's given, which is only while a long press can still be recognized.
+static inline SDL_bool input_gesture_waiting(InputManager* input) {
+    return input->gesture.tap_candidate && input->gesture.fingers_down == 1;
+}
+
+/*
+    Adds a gamepad to the gamepad table without opening it, so recorded or virtual
+    gamepads can be tracked the same way as real ones.
+    @controller The opened controller, or NULL if the state is filled in some other way.
+    @slot The player slot to put the gamepad in, or -1 to use the lowest free slot.
+    Returns NULL if the instance id or slot is already in use, or the table couldn't grow.
+*/
+InputGamepad* input_manager_attach_gamepad(InputManager* input, SDL_GameController* controller, SDL_JoystickID instance_id, int slot);
+
+// Removes a gamepad from the gamepad table. Returns its controller, which the caller is responsible for closing.
+SDL_GameController* input_manager_detach_gamepad(InputManager* input, SDL_JoystickID instance_id);
+
+// Closes a controller through the backend it was opened with.
+static inline void input_manager_close_gamepad(InputManager* input, SDL_GameController* controller) {
+    if(controller && input->backend.close_gamepad)
+        input->backend.close_gamepad(input->backend.ctx, controller);
+}
+
+#endif
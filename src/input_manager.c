@@ -1,49 +1,126 @@
 #include <input_manager.h>
 
 #include "std_definitions.h"
+#include "input_simd.h"
+#include "input_internal.h"
 
 InputManager* input_manager_create(void) {
-    if(!SDL_WasInit(SDL_INIT_GAMECONTROLLER)) {
-        if(SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) != 0)
-            return NULL;
-    }
+    return input_manager_create_with_allocator(NULL);
+}
+
+InputManager* input_manager_create_with_allocator(const InputAllocator* allocator) {
+    return input_manager_create_with_backend(NULL, allocator);
+}
 
-    InputManager* input = input_malloc(sizeof(*input));
+InputManager* input_manager_create_with_backend(const InputBackend* backend, const InputAllocator* allocator) {
+    InputBackend backend_copy = backend ? *backend : input_backend_sdl();
+    if(backend_copy.init && !backend_copy.init(backend_copy.ctx))
+        return NULL;
+
+    InputAllocator copy = allocator ? *allocator : (InputAllocator){ 0 };
+    InputManager* input = input_allocator_calloc(&copy, 1, sizeof(*input));
     if(!input)
         return NULL;
 
+    input->allocator = copy;
+    input->backend = backend_copy;
+
+    input->gamepad_first_slot = -1;
+    if(!input_manager_reserve_gamepads(input, INPUT_MAX_GAMEPADS)) {
+        input_manager_free(input);
+        return NULL;
+    }
+
     input->deadzone = (Uint16)(SDL_MAX_SINT16 * .15f);
-    input->mouse_current = SDL_GetMouseState(&input->mouse_position_current.x, &input->mouse_position_current.y);
-    input->keyboard_current = SDL_GetKeyboardState(NULL);
-
-    input->touch_previous = NULL;
-    input->touch_previous_count = 0;
-    input->touch_previous_capacity = 0;
-    input->touch_current = NULL;
-    input->touch_current_count = 0;
-    input->touch_current_capacity = 0;
-    input->touch_event_poll_count = 0;
+    input->trigger_threshold = (Uint16)(SDL_MAX_SINT16 * .9f);
+    input_touch_init(input);
+
+    for(int i = 0; i < INPUT_AXIS_GROUP_MAX; i++) {
+        InputAxisSettings* settings = &input->axis_settings[i];
+        settings->deadzone = i == INPUT_AXIS_GROUP_TRIGGERS ? .05f : .15f;
+        settings->outer_deadzone = 1.0f;
+        settings->anti_deadzone = 0;
+        settings->curve = INPUT_AXIS_CURVE_LINEAR;
+        settings->exponent = 1.0f;
+        settings->radial = SDL_TRUE;
+    }
+
+    if(input->backend.get_mouse)
+        input->mouse_current = input->backend.get_mouse(input->backend.ctx, &input->mouse_position_current.x, &input->mouse_position_current.y);
+
+    if(input->backend.get_keyboard)
+        input->backend.get_keyboard(input->backend.ctx, input->keyboard_current, INPUT_KEYBOARD_WORDS);
+
+    // Keys that are already held start with a history of being held.
+    for(int key = input_bitset_next(input->keyboard_current, INPUT_KEYBOARD_WORDS, 0);
+        key != -1;
+        key = input_bitset_next(input->keyboard_current, INPUT_KEYBOARD_WORDS, key + 1))
+    {
+        input->keyboard_history[key] = 1;
+    }
 
     return input;
 }
 
+SDL_bool input_manager_set_mouse_relative(InputManager* input, SDL_bool enabled) {
+    if(!input->backend.set_mouse_relative)
+        return SDL_FALSE;
+
+    return input->backend.set_mouse_relative(input->backend.ctx, enabled);
+}
+
 void input_manager_free(InputManager* input) {
-    input_free(input->touch_previous);
-    input_free(input->touch_current);
-    input_free(input);
+    input_manager_watch_events(input, SDL_FALSE);
+
+    for(int i = 0; i < input->gamepad_count; i++)
+        input_manager_close_gamepad(input, input->gamepads[i].controller);
+
+    InputAllocator allocator = input->allocator;
+    input_allocator_free(&allocator, input->gamepads);
+    input_allocator_free(&allocator, input->gamepad_slots);
+    input_allocator_free(&allocator, input->gamepad_lookup);
+    input_allocator_free(&allocator, input->gamepad_axis_values);
+    input_allocator_free(&allocator, input->touch_previous);
+    input_allocator_free(&allocator, input->touch_current);
+    input_allocator_free(&allocator, input);
+}
+
+// Virtual gamepads don't have a controller, so their state only comes from events.
+static inline SDL_bool input_gamepad_polled(InputManager* input, InputGamepad* gamepad) {
+    return gamepad->controller && input->backend.get_gamepad;
+}
+
+static void input_gamepad_poll(InputManager* input, InputGamepad* gamepad) {
+    Uint32 buttons;
+    input->backend.get_gamepad(input->backend.ctx, gamepad->controller, &buttons, gamepad->axes);
+    gamepad->button_state = buttons;
 }
 
+// The stick diagonals, followed by the two directions each one is made from.
+static const int input_gamepad_diagonals[][3] = {
+    { SDL_CONTROLLER_BUTTON_LEFTSTICKUPLEFT, SDL_CONTROLLER_BUTTON_LEFTSTICKUP, SDL_CONTROLLER_BUTTON_LEFTSTICKLEFT },
+    { SDL_CONTROLLER_BUTTON_LEFTSTICKUPRIGHT, SDL_CONTROLLER_BUTTON_LEFTSTICKUP, SDL_CONTROLLER_BUTTON_LEFTSTICKRIGHT },
+    { SDL_CONTROLLER_BUTTON_LEFTSTICKDOWNLEFT, SDL_CONTROLLER_BUTTON_LEFTSTICKDOWN, SDL_CONTROLLER_BUTTON_LEFTSTICKLEFT },
+    { SDL_CONTROLLER_BUTTON_LEFTSTICKDOWNRIGHT, SDL_CONTROLLER_BUTTON_LEFTSTICKDOWN, SDL_CONTROLLER_BUTTON_LEFTSTICKRIGHT },
+    { SDL_CONTROLLER_BUTTON_RIGHTSTICKUPLEFT, SDL_CONTROLLER_BUTTON_RIGHTSTICKUP, SDL_CONTROLLER_BUTTON_RIGHTSTICKLEFT },
+    { SDL_CONTROLLER_BUTTON_RIGHTSTICKUPRIGHT, SDL_CONTROLLER_BUTTON_RIGHTSTICKUP, SDL_CONTROLLER_BUTTON_RIGHTSTICKRIGHT },
+    { SDL_CONTROLLER_BUTTON_RIGHTSTICKDOWNLEFT, SDL_CONTROLLER_BUTTON_RIGHTSTICKDOWN, SDL_CONTROLLER_BUTTON_RIGHTSTICKLEFT },
+    { SDL_CONTROLLER_BUTTON_RIGHTSTICKDOWNRIGHT, SDL_CONTROLLER_BUTTON_RIGHTSTICKDOWN, SDL_CONTROLLER_BUTTON_RIGHTSTICKRIGHT }
+};
+
 static void input_gamepad_update(InputManager* input, InputGamepad* gamepad) {
     gamepad->button_previous = gamepad->button_current;
-    gamepad->button_current = 0;
 
-    for(int i = SDL_CONTROLLER_BUTTON_A; i < SDL_CONTROLLER_BUTTON_MAX; i++) {
-        if(SDL_GameControllerGetButton(gamepad->controller, i))
-            gamepad->button_current |= ___INPUT_GAMEPAD_BUTTON(i);
+    if(!(input->flags & INPUT_MANAGER_GAMEPAD_EVENTS) && input_gamepad_polled(input, gamepad)) {
+        input_gamepad_poll(input, gamepad);
+        INPUT_STATS_ADD(&input->stats, sdl_calls, SDL_CONTROLLER_BUTTON_MAX + SDL_CONTROLLER_AXIS_MAX);
     }
 
+    gamepad->button_current = gamepad->button_state | gamepad->button_taps;
+    gamepad->button_taps = 0;
+
     for(int i = SDL_CONTROLLER_AXIS_LEFTX; i < SDL_CONTROLLER_AXIS_MAX; i++) {
-        Sint16 axis = SDL_GameControllerGetAxis(gamepad->controller, i);
+        Sint16 axis = gamepad->axes[i];
         if(axis < -input->deadzone || axis > input->deadzone) {
             int index;
             switch(i) {
@@ -63,45 +140,201 @@ static void input_gamepad_update(InputManager* input, InputGamepad* gamepad) {
                     index = SDL_CONTROLLER_BUTTON_LEFTTRIGGER;
                     break;
                 case SDL_CONTROLLER_AXIS_TRIGGERRIGHT:
+                default:
                     index = SDL_CONTROLLER_BUTTON_RIGHTTRIGGER;
                     break;
             }
             gamepad->button_current |= ___INPUT_GAMEPAD_BUTTON(index);
         }
     }
+
+    if(gamepad->axes[SDL_CONTROLLER_AXIS_TRIGGERLEFT] >= input->trigger_threshold)
+        gamepad->button_current |= ___INPUT_GAMEPAD_BUTTON(SDL_CONTROLLER_BUTTON_LEFTTRIGGERFULL);
+    if(gamepad->axes[SDL_CONTROLLER_AXIS_TRIGGERRIGHT] >= input->trigger_threshold)
+        gamepad->button_current |= ___INPUT_GAMEPAD_BUTTON(SDL_CONTROLLER_BUTTON_RIGHTTRIGGERFULL);
+
+    for(int i = 0; i < (int)SDL_arraysize(input_gamepad_diagonals); i++) {
+        GamepadButtonMask directions = ___INPUT_GAMEPAD_BUTTON(input_gamepad_diagonals[i][1]) | ___INPUT_GAMEPAD_BUTTON(input_gamepad_diagonals[i][2]);
+        if((gamepad->button_current & directions) == directions)
+            gamepad->button_current |= ___INPUT_GAMEPAD_BUTTON(input_gamepad_diagonals[i][0]);
+    }
 }
 
-void input_manager_update(InputManager* input) {
+// Remaps magnitudes in place using the deadzones and response curve of an axis group.
+static void input_axis_remap(float* values, int count, const InputAxisSettings* settings) {
+    float range = settings->outer_deadzone - settings->deadzone;
+    float scale = range > 0 ? 1.0f / range : 1e9f;
+
+    if(settings->curve != INPUT_AXIS_CURVE_POWER) {
+        input_simd_remap(values, count, settings->deadzone, scale, settings->anti_deadzone, (int)settings->curve + 1);
+        return;
+    }
+
+    input_simd_remap(values, count, settings->deadzone, scale, 0, 1);
+    for(int i = 0; i < count; i++) {
+        if(values[i] > 0)
+            values[i] = settings->anti_deadzone + (1.0f - settings->anti_deadzone) * SDL_powf(values[i], settings->exponent);
+    }
+}
+
+static void input_axis_stick(float* x, float* y, float* scratch, int count, const InputAxisSettings* settings) {
+    if(settings->radial) {
+        input_simd_length(x, y, scratch, count);
+        for(int i = 0; i < count; i++)
+            scratch[i] = scratch[i] > 1.0f ? 1.0f : scratch[i];
+
+        // The remapped length is divided by the original length so the direction is kept.
+        float* length = scratch + count;
+        input_memcpy(length, scratch, count * sizeof(*length));
+        input_axis_remap(scratch, count, settings);
+
+        for(int i = 0; i < count; i++) {
+            float factor = length[i] > 0 ? scratch[i] / length[i] : 0;
+            x[i] *= factor;
+            y[i] *= factor;
+        }
+        return;
+    }
+
+    float* axes[2] = { x, y };
+    for(int axis = 0; axis < 2; axis++) {
+        float* values = axes[axis];
+        for(int i = 0; i < count; i++)
+            scratch[i] = values[i] < 0 ? -values[i] : values[i];
+
+        input_axis_remap(scratch, count, settings);
+
+        for(int i = 0; i < count; i++)
+            values[i] = values[i] < 0 ? -scratch[i] : scratch[i];
+    }
+}
+
+// Samples the raw axes of every gamepad and turns them into normalized values, one axis group at a time.
+static void input_gamepad_process_axes(InputManager* input) {
+    int count = input->gamepad_count;
+    int stride = input->gamepad_capacity;
+    float* values = input->gamepad_axis_values;
+    float* scratch = values + SDL_CONTROLLER_AXIS_MAX * stride;
+
+    if(count == 0)
+        return;
+
+    for(int axis = SDL_CONTROLLER_AXIS_LEFTX; axis < SDL_CONTROLLER_AXIS_MAX; axis++) {
+        float* row = values + axis * stride;
+        for(int i = 0; i < count; i++) {
+#if INPUT_ENABLE_STATS
+            input->gamepads[i].axis_values_previous[axis] = row[i];
+#endif
+            // The negative range is one larger than the positive one.
+            float value = input->gamepads[i].axes[axis] * (1.0f / SDL_MAX_SINT16);
+            row[i] = value < -1.0f ? -1.0f : value;
+        }
+    }
+
+    input_axis_stick(values + SDL_CONTROLLER_AXIS_LEFTX * stride,
+                     values + SDL_CONTROLLER_AXIS_LEFTY * stride,
+                     scratch,
+                     count,
+                     &input->axis_settings[INPUT_AXIS_GROUP_LEFT_STICK]);
+
+    input_axis_stick(values + SDL_CONTROLLER_AXIS_RIGHTX * stride,
+                     values + SDL_CONTROLLER_AXIS_RIGHTY * stride,
+                     scratch,
+                     count,
+                     &input->axis_settings[INPUT_AXIS_GROUP_RIGHT_STICK]);
+
+    input_axis_remap(values + SDL_CONTROLLER_AXIS_TRIGGERLEFT * stride, count, &input->axis_settings[INPUT_AXIS_GROUP_TRIGGERS]);
+    input_axis_remap(values + SDL_CONTROLLER_AXIS_TRIGGERRIGHT * stride, count, &input->axis_settings[INPUT_AXIS_GROUP_TRIGGERS]);
+}
+
+void input_manager_drain_watch(InputManager* input) {
+    InputEvent event;
+    while(input->watch_queue && input_event_queue_pop(input->watch_queue, &event))
+        input_manager_apply_event(input, &event);
+}
+
+void input_manager_begin_update(InputManager* input) {
+    INPUT_STATS_BEGIN(&input->stats, "input_manager_update");
+
+    // Events the watch saw on other threads belong to this update, the same as the ones applied right away.
+    input_manager_drain_watch(input);
+
     input->mouse_previous = input->mouse_current;
     input->mouse_position_previous = input->mouse_position_current;
-    input->keyboard_previous = input->keyboard_current;
+    input_memcpy(input->keyboard_previous, input->keyboard_current, sizeof(input->keyboard_current));
 
-    input->mouse_wheel_x = input->mouse_poll_scroll_x;
-    input->mouse_wheel_y = input->mouse_poll_scroll_y;
-    input->mouse_poll_scroll_x = input->mouse_poll_scroll_y = 0;
-    input->mouse_current = SDL_GetMouseState(&input->mouse_position_current.x, &input->mouse_position_current.y);
+#if INPUT_ENABLE_STATS
+    // The events since the last update belong to this one. Anything older has already been
+    // measured, so it can't be mistaken for the cause of a change that was polled.
+    input_memcpy(input->keyboard_times, input->keyboard_event_times, sizeof(input->keyboard_times));
+    input_memset(input->keyboard_event_times, 0, sizeof(input->keyboard_event_times));
+    input_memcpy(input->mouse_times, input->mouse_event_times, sizeof(input->mouse_times));
+    input_memset(input->mouse_event_times, 0, sizeof(input->mouse_event_times));
 
-    if(input->mouse_wheel_x < 0)
-        input->mouse_current |= SDL_BUTTON(SDL_MouseScrollLeft);
-    else if(input->mouse_wheel_x > 0)
-        input->mouse_current |= SDL_BUTTON(SDL_MouseScrollRight);
+    for(int i = 0; i < input->gamepad_count; i++) {
+        InputGamepad* gamepad = &input->gamepads[i];
+        input_memcpy(gamepad->button_times, gamepad->button_event_times, sizeof(gamepad->button_times));
+        input_memset(gamepad->button_event_times, 0, sizeof(gamepad->button_event_times));
+        input_memcpy(gamepad->axis_times, gamepad->axis_event_times, sizeof(gamepad->axis_times));
+        input_memset(gamepad->axis_event_times, 0, sizeof(gamepad->axis_event_times));
+    }
+#endif
+}
 
-    if(input->mouse_wheel_y < 0)
-        input->mouse_current |= SDL_BUTTON(SDL_MouseScrollDown);
-    else if(input->mouse_wheel_y > 0)
-        input->mouse_current |= SDL_BUTTON(SDL_MouseScrollUp);
+// Writes the history of the buttons that changed. Everything else is shifted when it's read.
+static void input_manager_update_history(InputManager* input) {
+    Uint32 frame = input->frame;
+
+    for(int word = 0; word < INPUT_KEYBOARD_WORDS; word++) {
+        for(Uint64 changed = input->keyboard_pressed[word] | input->keyboard_released[word]; changed; changed &= changed - 1) {
+            int key = word * 64 + input_bits_lowest(changed);
+            input_history_push(&input->keyboard_history[key],
+                               &input->keyboard_history_frames[key],
+                               frame,
+                               input_bitset_test(input->keyboard_current, key));
+        }
+    }
 
+    for(int i = 0; i < input->gamepad_count; i++) {
+        InputGamepad* gamepad = &input->gamepads[i];
+        for(GamepadButtonMask changed = gamepad->button_current ^ gamepad->button_history_state; changed; changed &= changed - 1) {
+            int button = input_bits_lowest(changed);
+            input_history_push(&gamepad->button_history[button],
+                               &gamepad->button_history_frames[button],
+                               frame,
+                               (gamepad->button_current & ___INPUT_GAMEPAD_BUTTON(button)) != 0);
+        }
+        gamepad->button_history_state = gamepad->button_current;
+    }
+}
 
-    input->keyboard_current = SDL_GetKeyboardState(NULL);
+void input_manager_end_update(InputManager* input) {
+    input_gamepad_process_axes(input);
 
-    for(int i = 0; i < input->controller_count; i++)
-        input_gamepad_update(input, &input->gamepads[input->controllers[i]]);
+    input_simd_diff(input->keyboard_current,
+                    input->keyboard_previous,
+                    input->keyboard_pressed,
+                    input->keyboard_released,
+                    INPUT_KEYBOARD_WORDS);
+
+    // The edges of every gamepad are found in one pass, so checking them is a single mask test.
+    for(int i = 0; i < input->gamepad_count; i++) {
+        InputGamepad* gamepad = &input->gamepads[i];
+        gamepad->button_pressed = gamepad->button_current & ~gamepad->button_previous;
+        gamepad->button_released = gamepad->button_previous & ~gamepad->button_current;
+    }
+
+    input->frame++;
+    input_manager_update_history(input);
 
     // During the pre-update phase where the caller should have polled for events,
     // input->touch_previous was overwritten with the newest events.
     // Here, we need to swap the values for current and previous
     // to finish updating the touch state.
 
+    input->touch_previous_count = input->touch_event_poll_count;
+    input->touch_event_poll_count = 0;
+
     SDL_TouchFingerEvent* temp = input->touch_current;
     unsigned int temp_capacity = input->touch_current_capacity;
     unsigned int temp_count = input->touch_current_count;
@@ -113,68 +346,625 @@ void input_manager_update(InputManager* input) {
     input->touch_previous = temp;
     input->touch_previous_count = temp_count;
     input->touch_previous_capacity = temp_capacity;
+
+    input_touch_update(input);
+
+    INPUT_STATS_END(&input->stats, "input_manager_update");
 }
 
-static void input_gamepad_open(InputManager* input, int index) {
-    SDL_GameController* controller = SDL_GameControllerOpen(index);
+void input_manager_update(InputManager* input) {
+    input_manager_begin_update(input);
 
-    if(!controller)
-        return;
+    input->mouse_wheel_x = input->mouse_poll_scroll_x;
+    input->mouse_wheel_y = input->mouse_poll_scroll_y;
+    input->mouse_poll_scroll_x = input->mouse_poll_scroll_y = 0;
+
+    input->mouse_delta = input->mouse_poll_delta;
+    input->mouse_poll_delta.x = input->mouse_poll_delta.y = 0;
+    input_memcpy(input->mouse_presses, input->mouse_poll_presses, sizeof(input->mouse_presses));
+    input_memset(input->mouse_poll_presses, 0, sizeof(input->mouse_poll_presses));
+    input_memcpy(input->mouse_samples, input->mouse_poll_samples, input->mouse_poll_sample_count * sizeof(*input->mouse_samples));
+    input->mouse_sample_count = input->mouse_poll_sample_count;
+    input->mouse_poll_sample_count = 0;
+
+    if((input->flags & INPUT_MANAGER_MOUSE_EVENTS) || !input->backend.get_mouse) {
+        input->mouse_current = input->mouse_state;
+        input->mouse_position_current = input->mouse_position_state;
+    } else {
+        input->mouse_current = input->backend.get_mouse(input->backend.ctx, &input->mouse_position_current.x, &input->mouse_position_current.y);
+        INPUT_STATS_ADD(&input->stats, sdl_calls, 1);
+    }
+
+    // Clicks that were released before the update still count as down for it,
+    // even when the state is polled, as long as the button events are passed along.
+    // Keys and gamepad buttons follow the same rule.
+    input->mouse_current |= input->mouse_taps;
+    input->mouse_taps = 0;
+
+    if(input->mouse_wheel_x < 0)
+        input->mouse_current |= SDL_BUTTON(SDL_MouseScrollLeft);
+    else if(input->mouse_wheel_x > 0)
+        input->mouse_current |= SDL_BUTTON(SDL_MouseScrollRight);
+
+    if(input->mouse_wheel_y < 0)
+        input->mouse_current |= SDL_BUTTON(SDL_MouseScrollDown);
+    else if(input->mouse_wheel_y > 0)
+        input->mouse_current |= SDL_BUTTON(SDL_MouseScrollUp);
+
+    if((input->flags & INPUT_MANAGER_KEYBOARD_EVENTS) || !input->backend.get_keyboard) {
+        input_memcpy(input->keyboard_current, input->keyboard_state, sizeof(input->keyboard_current));
+    } else {
+        input->backend.get_keyboard(input->backend.ctx, input->keyboard_current, INPUT_KEYBOARD_WORDS);
+        INPUT_STATS_ADD(&input->stats, sdl_calls, 1);
+    }
+
+    for(int i = 0; i < INPUT_KEYBOARD_WORDS; i++) {
+        input->keyboard_current[i] |= input->keyboard_taps[i];
+        input->keyboard_taps[i] = 0;
+    }
+
+    for(int i = 0; i < input->gamepad_count; i++)
+        input_gamepad_update(input, &input->gamepads[i]);
+
+    // Long presses can finish without any events, so they're checked against the clock as well.
+    if(input->backend.get_ticks) {
+        input->gesture.update_time = input->backend.get_ticks(input->backend.ctx);
+        INPUT_STATS_ADD(&input->stats, sdl_calls, 1);
+    } else {
+        input->gesture.update_time = input->gesture.time;
+    }
+
+    input_gesture_advance(input, input->gesture.update_time);
+
+    input_manager_end_update(input);
+}
+
+static inline Uint32 input_gamepad_hash(SDL_JoystickID instance_id, int capacity) {
+    // Fibonacci hashing, so sequential instance ids spread across the table.
+    return ((Uint32)instance_id * 0x9E3779B1u) & (Uint32)(capacity - 1);
+}
+
+static InputGamepadLookup* input_gamepad_lookup(InputManager* input, SDL_JoystickID instance_id) {
+    if(input->gamepad_lookup_capacity == 0)
+        return NULL;
+
+    Uint32 mask = (Uint32)input->gamepad_lookup_capacity - 1;
+    Uint32 i = input_gamepad_hash(instance_id, input->gamepad_lookup_capacity);
+
+    // The table is never more than half full, so there's always an empty entry to stop at.
+    for(;; i = (i + 1) & mask) {
+        InputGamepadLookup* entry = input->gamepad_lookup + i;
+        if(entry->index == -1)
+            return NULL;
+        if(entry->instance_id == instance_id)
+            return entry;
+    }
+}
+
+static void input_gamepad_lookup_insert(InputGamepadLookup* table, int capacity, SDL_JoystickID instance_id, int index) {
+    Uint32 mask = (Uint32)capacity - 1;
+    Uint32 i = input_gamepad_hash(instance_id, capacity);
+
+    while(table[i].index != -1)
+        i = (i + 1) & mask;
+
+    table[i].instance_id = instance_id;
+    table[i].index = index;
+}
+
+static void input_gamepad_lookup_remove(InputManager* input, InputGamepadLookup* entry) {
+    Uint32 mask = (Uint32)input->gamepad_lookup_capacity - 1;
+    Uint32 hole = (Uint32)(entry - input->gamepad_lookup);
+    Uint32 i = hole;
+
+    // Shifts the following entries back into the hole instead of leaving a tombstone,
+    // so lookups never have to skip over removed gamepads.
+    for(;;) {
+        i = (i + 1) & mask;
+        InputGamepadLookup* next = input->gamepad_lookup + i;
+        if(next->index == -1)
+            break;
+
+        Uint32 home = input_gamepad_hash(next->instance_id, input->gamepad_lookup_capacity);
+        if(((i - home) & mask) >= ((i - hole) & mask)) {
+            input->gamepad_lookup[hole] = *next;
+            hole = i;
+        }
+    }
+
+    input->gamepad_lookup[hole].index = -1;
+}
+
+SDL_bool input_manager_reserve_gamepads(InputManager* input, int count) {
+    if(count > input->gamepad_capacity) {
+        int capacity = input->gamepad_capacity == 0 ? 4 : input->gamepad_capacity;
+        while(capacity < count)
+            capacity *= 2;
+
+        // The scratch row at the end is twice as long, so radial sticks can keep the original lengths.
+        float* values = input_manager_allocate_zeroed(input, (SDL_CONTROLLER_AXIS_MAX + 2) * capacity, sizeof(*values));
+        if(!values)
+            return SDL_FALSE;
+
+        InputGamepad* gamepads = input_manager_reallocate(input, input->gamepads, capacity * sizeof(*gamepads));
+        if(!gamepads) {
+            input_manager_deallocate(input, values);
+            return SDL_FALSE;
+        }
 
+        for(int axis = 0; axis < SDL_CONTROLLER_AXIS_MAX && input->gamepad_count > 0; axis++) {
+            input_memcpy(values + axis * capacity,
+                         input->gamepad_axis_values + axis * input->gamepad_capacity,
+                         input->gamepad_count * sizeof(*values));
+        }
+
+        input_manager_deallocate(input, input->gamepad_axis_values);
+        input->gamepad_axis_values = values;
+        input->gamepads = gamepads;
+        input->gamepad_capacity = capacity;
+    }
+
+    if(count > input->gamepad_slot_capacity) {
+        int capacity = input->gamepad_slot_capacity == 0 ? 4 : input->gamepad_slot_capacity;
+        while(capacity < count)
+            capacity *= 2;
+
+        int* slots = input_manager_reallocate(input, input->gamepad_slots, capacity * sizeof(*slots));
+        if(!slots)
+            return SDL_FALSE;
+        for(int i = input->gamepad_slot_capacity; i < capacity; i++)
+            slots[i] = -1;
+        input->gamepad_slots = slots;
+        input->gamepad_slot_capacity = capacity;
+    }
+
+    if(count * 2 > input->gamepad_lookup_capacity) {
+        int capacity = input->gamepad_lookup_capacity == 0 ? 8 : input->gamepad_lookup_capacity;
+        while(capacity < count * 2)
+            capacity *= 2;
+
+        InputGamepadLookup* lookup = input_manager_allocate(input, capacity * sizeof(*lookup));
+        if(!lookup)
+            return SDL_FALSE;
+        for(int i = 0; i < capacity; i++)
+            lookup[i].index = -1;
+        for(int i = 0; i < input->gamepad_count; i++)
+            input_gamepad_lookup_insert(lookup, capacity, input->gamepads[i].instance_id, i);
+
+        input_manager_deallocate(input, input->gamepad_lookup);
+        input->gamepad_lookup = lookup;
+        input->gamepad_lookup_capacity = capacity;
+    }
+
+    return SDL_TRUE;
+}
+
+int input_gamepad_slot(InputManager* input, SDL_JoystickID instance_id) {
+    InputGamepadLookup* entry = input_gamepad_lookup(input, instance_id);
+    return entry ? input->gamepads[entry->index].slot : -1;
+}
+
+InputGamepad* input_manager_attach_gamepad(InputManager* input, SDL_GameController* controller, SDL_JoystickID instance_id, int slot) {
+    if(input_gamepad_lookup(input, instance_id))
+        return NULL;
+
+    if(slot < 0) {
+        slot = 0;
+        while(slot < input->gamepad_slot_capacity && input->gamepad_slots[slot] != -1)
+            slot++;
+    } else if(slot < input->gamepad_slot_capacity && input->gamepad_slots[slot] != -1) {
+        return NULL;
+    }
+
+    int count = input->gamepad_count + 1;
+    if(!input_manager_reserve_gamepads(input, count > slot + 1 ? count : slot + 1))
+        return NULL;
+
+    int index = input->gamepad_count++;
     InputGamepad* gp = input->gamepads + index;
+    input_memset(gp, 0, sizeof(*gp));
     gp->controller = controller;
+    gp->instance_id = instance_id;
+    gp->slot = slot;
     gp->active = SDL_TRUE;
+
+    for(int axis = 0; axis < SDL_CONTROLLER_AXIS_MAX; axis++)
+        input->gamepad_axis_values[axis * input->gamepad_capacity + index] = 0;
+
+    input->gamepad_slots[slot] = index;
+    input_gamepad_lookup_insert(input->gamepad_lookup, input->gamepad_lookup_capacity, instance_id, index);
+
+    if(input->gamepad_first_slot == -1 || slot < input->gamepad_first_slot)
+        input->gamepad_first_slot = slot;
+
+    return gp;
+}
+
+SDL_GameController* input_manager_detach_gamepad(InputManager* input, SDL_JoystickID instance_id) {
+    InputGamepadLookup* entry = input_gamepad_lookup(input, instance_id);
+    if(!entry)
+        return NULL;
+
+    int index = entry->index;
+    InputGamepad* gp = input->gamepads + index;
+    SDL_GameController* controller = gp->controller;
+    int slot = gp->slot;
+
+    input_gamepad_lookup_remove(input, entry);
+    input->gamepad_slots[slot] = -1;
+
+    // Moves the last gamepad into the hole so the table stays densely packed.
+    int last = --input->gamepad_count;
+    if(index != last) {
+        *gp = input->gamepads[last];
+        for(int axis = 0; axis < SDL_CONTROLLER_AXIS_MAX; axis++) {
+            float* row = input->gamepad_axis_values + axis * input->gamepad_capacity;
+            row[index] = row[last];
+        }
+        input->gamepad_slots[gp->slot] = index;
+        input_gamepad_lookup(input, gp->instance_id)->index = index;
+    }
+
+    if(slot == input->gamepad_first_slot) {
+        int next = slot + 1;
+        while(next < input->gamepad_slot_capacity && input->gamepad_slots[next] == -1)
+            next++;
+        input->gamepad_first_slot = next < input->gamepad_slot_capacity ? next : -1;
+    }
+
+    return controller;
+}
+
+static void input_gamepad_open(InputManager* input, int device_index) {
+    if(!input->backend.open_gamepad)
+        return;
+
+    SDL_JoystickID instance_id;
+    SDL_GameController* controller = input->backend.open_gamepad(input->backend.ctx, device_index, &instance_id);
+
+    if(!controller)
+        return;
+
+    // Some platforms send an added event for controllers that were already opened,
+    // which also fails to attach, so the extra reference is closed again.
+    InputGamepad* gp = input_manager_attach_gamepad(input, controller, instance_id, -1);
+    if(!gp) {
+        input_manager_close_gamepad(input, controller);
+        return;
+    }
+
+    // Events only report changes, so the initial state is always polled.
+    if(input_gamepad_polled(input, gp))
+        input_gamepad_poll(input, gp);
     input_gamepad_update(input, gp);
-    input->controllers[input->controller_count++] = index;
 }
 
 void input_manager_controller_event(InputManager* input, SDL_ControllerDeviceEvent* event) {
+    INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_GAMEPAD_DEVICE], 1);
     switch(event->type) {
         case SDL_CONTROLLERDEVICEADDED:
             input_gamepad_open(input, event->which);
             break;
-        case SDL_CONTROLLERDEVICEREMOVED:
-            for(int i = 0; i < INPUT_MAX_GAMEPADS; i++) {
-                if(input->controllers[i] == event->which) {
-                    input->gamepads[i].active = SDL_FALSE;
-                    if(i != input->controller_count - 1) {
-                        input_memmove(input->controllers + i, 
-                                      input->controllers + i + 1, 
-                                      (--input->controller_count - i) * sizeof(*input->controllers));
-                        input->controllers[input->controller_count] = -1;
-                        break;
-                    }
-                }
-            }
+        case SDL_CONTROLLERDEVICEREMOVED: {
+            // Unlike the added event, which is the joystick instance id here.
+            SDL_GameController* controller = input_manager_detach_gamepad(input, event->which);
+            input_manager_close_gamepad(input, controller);
             break;
+        }
+    }
+}
+
+int input_manager_add_virtual_gamepad(InputManager* input, SDL_JoystickID instance_id, int slot) {
+    InputGamepad* gp = input_manager_attach_gamepad(input, NULL, instance_id, slot);
+    return gp ? gp->slot : -1;
+}
+
+void input_manager_remove_virtual_gamepad(InputManager* input, SDL_JoystickID instance_id) {
+    InputGamepadLookup* entry = input_gamepad_lookup(input, instance_id);
+    if(entry && !input->gamepads[entry->index].controller)
+        input_manager_detach_gamepad(input, instance_id);
+}
+
+static InputGamepad* input_gamepad_find(InputManager* input, SDL_JoystickID instance_id) {
+    InputGamepadLookup* entry = input_gamepad_lookup(input, instance_id);
+    return entry ? input->gamepads + entry->index : NULL;
+}
+
+void input_manager_set_gamepad_button_at(InputManager* input, SDL_JoystickID instance_id, int button, SDL_bool down, Uint32 timestamp) {
+    INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_GAMEPAD_BUTTON], 1);
+    InputGamepad* gp = input_gamepad_find(input, instance_id);
+    if(!gp || button < 0 || button >= SDL_CONTROLLER_BUTTON_MAX)
+        return;
+
+    INPUT_STATS_STAMP(gp->button_event_times[button], timestamp);
+
+    if(down) {
+        gp->button_state |= ___INPUT_GAMEPAD_BUTTON(button);
+        gp->button_taps |= ___INPUT_GAMEPAD_BUTTON(button);
+    } else {
+        gp->button_state &= ~___INPUT_GAMEPAD_BUTTON(button);
+    }
+}
+
+void input_manager_set_gamepad_button(InputManager* input, SDL_JoystickID instance_id, int button, SDL_bool down) {
+    input_manager_set_gamepad_button_at(input, instance_id, button, down, 0);
+}
+
+void input_manager_set_gamepad_axis_at(InputManager* input, SDL_JoystickID instance_id, int axis, Sint16 value, Uint32 timestamp) {
+    INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_GAMEPAD_AXIS], 1);
+    InputGamepad* gp = input_gamepad_find(input, instance_id);
+    if(!gp || axis < 0 || axis >= SDL_CONTROLLER_AXIS_MAX)
+        return;
+
+    INPUT_STATS_STAMP(gp->axis_event_times[axis], timestamp);
+    gp->axes[axis] = value;
+}
+
+void input_manager_set_gamepad_axis(InputManager* input, SDL_JoystickID instance_id, int axis, Sint16 value) {
+    input_manager_set_gamepad_axis_at(input, instance_id, axis, value, 0);
+}
+
+void input_manager_set_key_at(InputManager* input, SDL_Scancode key, SDL_bool down, Uint32 timestamp) {
+    INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_KEY], 1);
+    if(key < 0 || key >= SDL_NUM_SCANCODES)
+        return;
+
+    INPUT_STATS_STAMP(input->keyboard_event_times[key], timestamp);
+
+    if(down) {
+        input_bitset_set(input->keyboard_state, key);
+        input_bitset_set(input->keyboard_taps, key);
+    } else {
+        input_bitset_clear(input->keyboard_state, key);
     }
 }
 
+void input_manager_set_key(InputManager* input, SDL_Scancode key, SDL_bool down) {
+    input_manager_set_key_at(input, key, down, 0);
+}
+
+void input_manager_set_mouse_button_at(InputManager* input, int button, SDL_bool down, Uint32 timestamp) {
+    INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_MOUSE_BUTTON], 1);
+    if(button < 1 || button > 32)
+        return;
+
+    INPUT_STATS_STAMP(input->mouse_event_times[button - 1], timestamp);
+
+    // SDL_BUTTON shifts an int, which overflows for button 32.
+    MouseButton bit = (MouseButton)1 << (button - 1);
+    if(down) {
+        input->mouse_state |= bit;
+        input->mouse_taps |= bit;
+        if(button <= INPUT_MOUSE_BUTTONS && input->mouse_poll_presses[button - 1] < 255)
+            input->mouse_poll_presses[button - 1]++;
+    } else {
+        input->mouse_state &= ~bit;
+    }
+}
+
+void input_manager_set_mouse_button(InputManager* input, int button, SDL_bool down) {
+    input_manager_set_mouse_button_at(input, button, down, 0);
+}
+
+void input_manager_set_mouse_position(InputManager* input, int x, int y) {
+    INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_MOUSE_MOTION], 1);
+    input->mouse_position_state.x = x;
+    input->mouse_position_state.y = y;
+}
+
+void input_manager_add_mouse_motion(InputManager* input, int x, int y, int dx, int dy, Uint32 timestamp) {
+    input_manager_set_mouse_position(input, x, y);
+    input->mouse_poll_delta.x += dx;
+    input->mouse_poll_delta.y += dy;
+
+    if(!(input->flags & INPUT_MANAGER_MOUSE_SAMPLES))
+        return;
+
+    // Once the samples are full, the newest ones are merged into the last so the deltas still add up.
+    InputMouseSample* sample;
+    if(input->mouse_poll_sample_count < INPUT_MAX_MOUSE_SAMPLES) {
+        sample = &input->mouse_poll_samples[input->mouse_poll_sample_count++];
+        sample->delta.x = sample->delta.y = 0;
+    } else {
+        sample = &input->mouse_poll_samples[INPUT_MAX_MOUSE_SAMPLES - 1];
+    }
+
+    sample->timestamp = timestamp;
+    sample->position.x = x;
+    sample->position.y = y;
+    sample->delta.x += dx;
+    sample->delta.y += dy;
+}
+
+void input_manager_add_mouse_wheel_at(InputManager* input, int x, int y, Uint32 timestamp) {
+    INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_MOUSE_WHEEL], 1);
+    input->mouse_poll_scroll_x += x;
+    input->mouse_poll_scroll_y += y;
+
+    // The wheel shows up as the scroll buttons.
+    if(x)
+        INPUT_STATS_STAMP(input->mouse_event_times[(x < 0 ? SDL_MouseScrollLeft : SDL_MouseScrollRight) - 1], timestamp);
+    if(y)
+        INPUT_STATS_STAMP(input->mouse_event_times[(y < 0 ? SDL_MouseScrollDown : SDL_MouseScrollUp) - 1], timestamp);
+}
+
+void input_manager_add_mouse_wheel(InputManager* input, int x, int y) {
+    input_manager_add_mouse_wheel_at(input, x, y, 0);
+}
+
+void input_manager_controller_button_event(InputManager* input, SDL_ControllerButtonEvent* event) {
+    input_manager_set_gamepad_button_at(input, event->which, event->button, event->state ? SDL_TRUE : SDL_FALSE, event->timestamp);
+}
+
+void input_manager_controller_axis_event(InputManager* input, SDL_ControllerAxisEvent* event) {
+    input_manager_set_gamepad_axis_at(input, event->which, event->axis, event->value, event->timestamp);
+}
+
+void input_manager_key_event(InputManager* input, SDL_KeyboardEvent* event) {
+    // Repeats don't change the state.
+    if(event->repeat)
+        return;
+
+    input_manager_set_key_at(input, event->keysym.scancode, event->state ? SDL_TRUE : SDL_FALSE, event->timestamp);
+}
+
+void input_manager_mouse_button_event(InputManager* input, SDL_MouseButtonEvent* event) {
+    input_manager_set_mouse_button_at(input, event->button, event->state ? SDL_TRUE : SDL_FALSE, event->timestamp);
+}
+
+void input_manager_mouse_motion_event(InputManager* input, SDL_MouseMotionEvent* event) {
+    input_manager_add_mouse_motion(input, event->x, event->y, event->xrel, event->yrel, event->timestamp);
+}
+
 void input_manager_mouse_wheel_event(InputManager* input, SDL_MouseWheelEvent* event) {
     if(event->x != 0) {
         int x = event->x;
         if(event->direction == SDL_MOUSEWHEEL_FLIPPED)
             x *= -1;
 
-        input->mouse_poll_scroll_x += x;
+        input_manager_add_mouse_wheel_at(input, x, 0, event->timestamp);
     } else {
         int y = event->y;
         if(event->direction == SDL_MOUSEWHEEL_FLIPPED)
             y *= -1;
 
-        input->mouse_poll_scroll_y += y;
+        input_manager_add_mouse_wheel_at(input, 0, y, event->timestamp);
     }
 }
 
-void input_manager_touch_event(InputManager* input, SDL_TouchFingerEvent* event) {
-    if(input->touch_event_poll_count == input->touch_previous_capacity) {
-        unsigned int capacity = input->touch_previous_capacity == 0 ? 4 : input->touch_previous_capacity * 2;
-        void* buffer = input_realloc(input->touch_previous, capacity * sizeof(*input->touch_previous));
-        if(!buffer)
-            return;
-        input->touch_previous_capacity = capacity;
-        input->touch_previous = buffer;
+SDL_bool input_manager_event(InputManager* input, SDL_Event* event) {
+    switch(event->type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            input_manager_key_event(input, &event->key);
+            return SDL_TRUE;
+        case SDL_MOUSEMOTION:
+            input_manager_mouse_motion_event(input, &event->motion);
+            return SDL_TRUE;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            input_manager_mouse_button_event(input, &event->button);
+            return SDL_TRUE;
+        case SDL_MOUSEWHEEL:
+            input_manager_mouse_wheel_event(input, &event->wheel);
+            return SDL_TRUE;
+        case SDL_CONTROLLERAXISMOTION:
+            input_manager_controller_axis_event(input, &event->caxis);
+            return SDL_TRUE;
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+            input_manager_controller_button_event(input, &event->cbutton);
+            return SDL_TRUE;
+        case SDL_CONTROLLERDEVICEADDED:
+        case SDL_CONTROLLERDEVICEREMOVED:
+            input_manager_controller_event(input, &event->cdevice);
+            return SDL_TRUE;
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+        case SDL_FINGERMOTION:
+            input_manager_touch_event(input, &event->tfinger);
+            return SDL_TRUE;
+        default:
+            return SDL_FALSE;
     }
+}
+
+// Removes the events in a type range from the SDL queue and applies them. Returns the amount of events applied.
+static int input_manager_poll_range(InputManager* input, SDL_Event* events, Uint32 min_type, Uint32 max_type) {
+    int total = 0;
+    int count;
+
+    do {
+        count = SDL_PeepEvents(events, INPUT_EVENT_BATCH, SDL_GETEVENT, min_type, max_type);
+        INPUT_STATS_ADD(&input->stats, sdl_calls, 1);
+        if(count <= 0)
+            break;
+
+        // Each range only holds one kind of device, so every range gets its own loop that only
+        // tells apart the few event types of that device instead of going through input_manager_event.
+        switch(min_type) {
+            case SDL_KEYDOWN:
+                for(int i = 0; i < count; i++)
+                    input_manager_key_event(input, &events[i].key);
+                break;
+            case SDL_MOUSEMOTION:
+                for(int i = 0; i < count; i++) {
+                    SDL_Event* event = &events[i];
+                    if(event->type == SDL_MOUSEMOTION)
+                        input_manager_mouse_motion_event(input, &event->motion);
+                    else if(event->type == SDL_MOUSEWHEEL)
+                        input_manager_mouse_wheel_event(input, &event->wheel);
+                    else
+                        input_manager_mouse_button_event(input, &event->button);
+                }
+                break;
+            case SDL_CONTROLLERAXISMOTION:
+                for(int i = 0; i < count; i++) {
+                    SDL_Event* event = &events[i];
+                    if(event->type == SDL_CONTROLLERAXISMOTION)
+                        input_manager_controller_axis_event(input, &event->caxis);
+                    else if(event->type <= SDL_CONTROLLERBUTTONUP)
+                        input_manager_controller_button_event(input, &event->cbutton);
+                    else
+                        input_manager_controller_event(input, &event->cdevice);
+                }
+                break;
+            case SDL_FINGERDOWN:
+                for(int i = 0; i < count; i++)
+                    input_manager_touch_event(input, &events[i].tfinger);
+                break;
+        }
 
-    input->touch_previous[input->touch_event_poll_count++] = *event;
-}
\ No newline at end of file
+        total += count;
+    } while(count == INPUT_EVENT_BATCH);
+
+    return total;
+}
+
+int input_manager_poll_events(InputManager* input) {
+    SDL_Event events[INPUT_EVENT_BATCH];
+
+    SDL_PumpEvents();
+
+    return input_manager_poll_range(input, events, SDL_KEYDOWN, SDL_KEYUP) +
+           input_manager_poll_range(input, events, SDL_MOUSEMOTION, SDL_MOUSEWHEEL) +
+           input_manager_poll_range(input, events, SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERDEVICEREMOVED) +
+           input_manager_poll_range(input, events, SDL_FINGERDOWN, SDL_FINGERMOTION);
+}
+
+static int input_manager_watch(void* userdata, SDL_Event* event) {
+    InputManager* input = userdata;
+
+    // SDL calls the watches one event at a time, so the other threads never push at the same time.
+    if(SDL_ThreadID() == input->watch_thread)
+        input_manager_event(input, event);
+    else
+        input_event_queue_push_deferred(input->watch_queue, event);
+
+    // The return value of an event watch is ignored.
+    return 1;
+}
+
+SDL_bool input_manager_watch_events(InputManager* input, SDL_bool enabled) {
+    if(enabled == input->watching)
+        return SDL_TRUE;
+
+    if(enabled) {
+        input->watch_queue = input_event_queue_create(INPUT_WATCH_QUEUE_SIZE);
+        if(!input->watch_queue)
+            return SDL_FALSE;
+
+        input->watch_thread = SDL_ThreadID();
+        SDL_AddEventWatch(input_manager_watch, input);
+    } else {
+        SDL_DelEventWatch(input_manager_watch, input);
+
+        // Anything from other threads since the last update is still applied by the next one.
+        input_manager_drain_watch(input);
+        input_event_queue_free(input->watch_queue);
+        input->watch_queue = NULL;
+    }
+
+    input->watching = enabled;
+    return SDL_TRUE;
+}
@@ -0,0 +1,663 @@
+#include <input_recorder.h>
+
+#include "std_definitions.h"
+#include "input_internal.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define INPUT_REPLAY_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+    File layout:
+
+    header: "SDLI", version byte, INPUT_RECORD_MAX_GAMEPADS byte
+    frame:  varint section flags, followed by each section that's set, in flag order.
+
+    The gesture time section holds the clock the update checked long presses against,
+    stored as the difference from the previous frame.
+
+    Gamepads are stored by player slot. Connecting or disconnecting a gamepad
+    toggles the active flag of its slot.
+
+    All integers are varints (7 bits per byte, low bits first). Signed values
+    are zigzag encoded first. Floats are stored as 4 little endian bytes.
+*/
+
+#define INPUT_RECORD_VERSION 4
+
+// The size of the buffer frames are written into before being flushed to the file.
+#ifndef INPUT_RECORDER_BUFFER_SIZE
+#define INPUT_RECORDER_BUFFER_SIZE 65536
+#endif
+
+// The amount of player slots that are recorded. Gamepads in higher slots are ignored.
+#ifndef INPUT_RECORD_MAX_GAMEPADS
+#define INPUT_RECORD_MAX_GAMEPADS 64
+#endif
+
+// The most bytes a frame can take up, not counting touch events.
+#define INPUT_RECORD_FRAME_MAX (256 + INPUT_KEYBOARD_WORDS * 10 + INPUT_RECORD_MAX_GAMEPADS * (32 + SDL_CONTROLLER_AXIS_MAX * 5))
+
+// The most bytes a single touch event can take up.
+#define INPUT_RECORD_TOUCH_MAX 64
+
+// The most bytes the sections after the touch events can take up, so they need their own space.
+#define INPUT_RECORD_MOUSE_DELTA_MAX 10
+#define INPUT_RECORD_GESTURE_TIME_MAX 5
+
+typedef enum InputRecordSection {
+    INPUT_RECORD_KEYBOARD = 1 << 0,
+    INPUT_RECORD_MOUSE_BUTTONS = 1 << 1,
+    INPUT_RECORD_MOUSE_POSITION = 1 << 2,
+    INPUT_RECORD_MOUSE_WHEEL = 1 << 3,
+    INPUT_RECORD_GAMEPADS = 1 << 4,
+    INPUT_RECORD_TOUCH = 1 << 5,
+    INPUT_RECORD_MOUSE_DELTA = 1 << 6,
+    INPUT_RECORD_GESTURE_TIME = 1 << 7
+} InputRecordSection;
+
+// Flags stored before each changed gamepad.
+typedef enum InputRecordGamepadFlags {
+    INPUT_RECORD_GAMEPAD_ACTIVE = 1 << 0,
+    INPUT_RECORD_GAMEPAD_BUTTONS = 1 << 1,
+    // One bit per axis, starting here.
+    INPUT_RECORD_GAMEPAD_AXES = 1 << 2
+} InputRecordGamepadFlags;
+
+typedef struct InputRecordGamepad {
+    SDL_bool active;
+    GamepadButtonMask buttons;
+    Sint16 axes[SDL_CONTROLLER_AXIS_MAX];
+} InputRecordGamepad;
+
+// The state that frames are delta encoded against.
+typedef struct InputRecordState {
+    Uint64 keyboard[INPUT_KEYBOARD_WORDS];
+    MouseButton mouse;
+    SDL_Point position;
+    int wheel_x;
+    int wheel_y;
+    SDL_Point delta;
+    Uint32 gesture_time;
+    // One past the highest slot that's ever had a gamepad in it.
+    int gamepad_slots;
+    InputRecordGamepad gamepads[INPUT_RECORD_MAX_GAMEPADS];
+} InputRecordState;
+
+struct InputRecorder {
+    SDL_RWops* file;
+    InputRecordState state;
+    size_t length;
+    Uint8 buffer[INPUT_RECORDER_BUFFER_SIZE];
+};
+
+struct InputReplay {
+    const Uint8* data;
+    size_t size;
+    size_t position;
+    Uint64 frame;
+    SDL_bool corrupt;
+    InputRecordState state;
+    // How the data needs to be released: mapped, loaded with SDL_LoadFile, or borrowed.
+    void* mapping;
+    void* loaded;
+#if defined(_WIN32)
+    HANDLE file_handle;
+    HANDLE mapping_handle;
+#endif
+};
+
+static const Uint8 input_record_magic[4] = { 'S', 'D', 'L', 'I' };
+
+static Uint32 input_zigzag_encode(Sint32 value) {
+    return ((Uint32)value << 1) ^ (Uint32)(value >> 31);
+}
+
+static Sint32 input_zigzag_decode(Uint32 value) {
+    return (Sint32)(value >> 1) ^ -(Sint32)(value & 1);
+}
+
+static void input_recorder_write_varint(InputRecorder* recorder, Uint64 value) {
+    while(value >= 0x80) {
+        recorder->buffer[recorder->length++] = (Uint8)(value | 0x80);
+        value >>= 7;
+    }
+    recorder->buffer[recorder->length++] = (Uint8)value;
+}
+
+static void input_recorder_write_signed(InputRecorder* recorder, Sint32 value) {
+    input_recorder_write_varint(recorder, input_zigzag_encode(value));
+}
+
+static void input_recorder_write_float(InputRecorder* recorder, float value) {
+    Uint32 bits;
+    input_memcpy(&bits, &value, sizeof(bits));
+    for(int i = 0; i < 4; i++)
+        recorder->buffer[recorder->length++] = (Uint8)(bits >> (i * 8));
+}
+
+// Makes sure there's enough space in the buffer for the specified amount of bytes.
+static SDL_bool input_recorder_reserve(InputRecorder* recorder, size_t size) {
+    if(recorder->length + size > INPUT_RECORDER_BUFFER_SIZE)
+        return input_recorder_flush(recorder);
+
+    return SDL_TRUE;
+}
+
+InputRecorder* input_recorder_create(const char* path) {
+    InputRecorder* recorder = input_calloc(1, sizeof(*recorder));
+    if(!recorder)
+        return NULL;
+
+    recorder->file = SDL_RWFromFile(path, "wb");
+    if(!recorder->file) {
+        input_free(recorder);
+        return NULL;
+    }
+
+    input_memcpy(recorder->buffer, input_record_magic, sizeof(input_record_magic));
+    recorder->length = sizeof(input_record_magic);
+    recorder->buffer[recorder->length++] = INPUT_RECORD_VERSION;
+    recorder->buffer[recorder->length++] = INPUT_RECORD_MAX_GAMEPADS;
+
+    return recorder;
+}
+
+void input_recorder_free(InputRecorder* recorder) {
+    input_recorder_flush(recorder);
+    SDL_RWclose(recorder->file);
+    input_free(recorder);
+}
+
+SDL_bool input_recorder_flush(InputRecorder* recorder) {
+    if(recorder->length == 0)
+        return SDL_TRUE;
+
+    size_t length = recorder->length;
+    recorder->length = 0;
+    return SDL_RWwrite(recorder->file, recorder->buffer, 1, length) == length ? SDL_TRUE : SDL_FALSE;
+}
+
+// Copies the recorded values of a gamepad. An empty slot is recorded as an inactive gamepad with nothing pressed.
+static void input_recorder_gamepad_state(InputRecordGamepad* recorded, InputGamepad* gamepad) {
+    if(!gamepad) {
+        input_memset(recorded, 0, sizeof(*recorded));
+        return;
+    }
+
+    recorded->active = gamepad->active;
+    recorded->buttons = gamepad->button_current;
+    input_memcpy(recorded->axes, gamepad->axes, sizeof(recorded->axes));
+}
+
+static Uint32 input_recorder_gamepad_flags(InputRecordGamepad* previous, InputRecordGamepad* gamepad) {
+    Uint32 flags = 0;
+
+    if(gamepad->active != previous->active)
+        flags |= INPUT_RECORD_GAMEPAD_ACTIVE;
+
+    if(gamepad->buttons != previous->buttons)
+        flags |= INPUT_RECORD_GAMEPAD_BUTTONS;
+
+    for(int i = 0; i < SDL_CONTROLLER_AXIS_MAX; i++) {
+        if(gamepad->axes[i] != previous->axes[i])
+            flags |= INPUT_RECORD_GAMEPAD_AXES << i;
+    }
+
+    return flags;
+}
+
+SDL_bool input_recorder_record(InputRecorder* recorder, InputManager* input) {
+    InputRecordState* state = &recorder->state;
+    Uint32 sections = 0;
+    Uint32 key_words = 0;
+    InputRecordGamepad gamepads[INPUT_RECORD_MAX_GAMEPADS];
+    Uint32 gamepad_flags[INPUT_RECORD_MAX_GAMEPADS];
+    int gamepads_changed = 0;
+
+    for(int i = 0; i < INPUT_KEYBOARD_WORDS; i++) {
+        if(input->keyboard_current[i] != state->keyboard[i])
+            key_words |= 1u << i;
+    }
+
+    if(key_words)
+        sections |= INPUT_RECORD_KEYBOARD;
+
+    if(input->mouse_current != state->mouse)
+        sections |= INPUT_RECORD_MOUSE_BUTTONS;
+
+    if(input->mouse_position_current.x != state->position.x || input->mouse_position_current.y != state->position.y)
+        sections |= INPUT_RECORD_MOUSE_POSITION;
+
+    if(input->mouse_wheel_x != state->wheel_x || input->mouse_wheel_y != state->wheel_y)
+        sections |= INPUT_RECORD_MOUSE_WHEEL;
+
+    // Slots past the end of both the gamepad table and the recorded state are known to be empty.
+    int slots = input->gamepad_slot_capacity < INPUT_RECORD_MAX_GAMEPADS ? input->gamepad_slot_capacity : INPUT_RECORD_MAX_GAMEPADS;
+    if(state->gamepad_slots > slots)
+        slots = state->gamepad_slots;
+
+    for(int i = 0; i < slots; i++) {
+        input_recorder_gamepad_state(&gamepads[i], input_gamepad_get(input, i));
+        gamepad_flags[i] = input_recorder_gamepad_flags(&state->gamepads[i], &gamepads[i]);
+        if(gamepad_flags[i])
+            gamepads_changed++;
+    }
+
+    if(gamepads_changed)
+        sections |= INPUT_RECORD_GAMEPADS;
+
+    if(input->touch_current_count)
+        sections |= INPUT_RECORD_TOUCH;
+
+    if(input->mouse_delta.x != state->delta.x || input->mouse_delta.y != state->delta.y)
+        sections |= INPUT_RECORD_MOUSE_DELTA;
+
+    // The clock only changes the replay while a long press is pending, so idle frames don't need it.
+    if(input_gesture_waiting(input) && input->gesture.update_time != state->gesture_time)
+        sections |= INPUT_RECORD_GESTURE_TIME;
+
+    if(!input_recorder_reserve(recorder, INPUT_RECORD_FRAME_MAX))
+        return SDL_FALSE;
+
+    input_recorder_write_varint(recorder, sections);
+
+    if(sections & INPUT_RECORD_KEYBOARD) {
+        input_recorder_write_varint(recorder, key_words);
+        for(int i = 0; i < INPUT_KEYBOARD_WORDS; i++) {
+            if(key_words & (1u << i)) {
+                // Only the bits that flipped are set, which keeps the varint small.
+                input_recorder_write_varint(recorder, input->keyboard_current[i] ^ state->keyboard[i]);
+                state->keyboard[i] = input->keyboard_current[i];
+            }
+        }
+    }
+
+    if(sections & INPUT_RECORD_MOUSE_BUTTONS) {
+        input_recorder_write_varint(recorder, input->mouse_current);
+        state->mouse = input->mouse_current;
+    }
+
+    if(sections & INPUT_RECORD_MOUSE_POSITION) {
+        input_recorder_write_signed(recorder, input->mouse_position_current.x - state->position.x);
+        input_recorder_write_signed(recorder, input->mouse_position_current.y - state->position.y);
+        state->position = input->mouse_position_current;
+    }
+
+    if(sections & INPUT_RECORD_MOUSE_WHEEL) {
+        input_recorder_write_signed(recorder, input->mouse_wheel_x);
+        input_recorder_write_signed(recorder, input->mouse_wheel_y);
+        state->wheel_x = input->mouse_wheel_x;
+        state->wheel_y = input->mouse_wheel_y;
+    }
+
+    if(sections & INPUT_RECORD_GAMEPADS) {
+        input_recorder_write_varint(recorder, gamepads_changed);
+        for(int i = 0; i < slots; i++) {
+            if(!gamepad_flags[i])
+                continue;
+
+            InputRecordGamepad* gamepad = &gamepads[i];
+            InputRecordGamepad* previous = &state->gamepads[i];
+
+            input_recorder_write_varint(recorder, i);
+            input_recorder_write_varint(recorder, gamepad_flags[i]);
+
+            if(gamepad_flags[i] & INPUT_RECORD_GAMEPAD_BUTTONS)
+                input_recorder_write_varint(recorder, gamepad->buttons);
+
+            for(int axis = 0; axis < SDL_CONTROLLER_AXIS_MAX; axis++) {
+                if(gamepad_flags[i] & (INPUT_RECORD_GAMEPAD_AXES << axis))
+                    input_recorder_write_signed(recorder, gamepad->axes[axis] - previous->axes[axis]);
+            }
+
+            *previous = *gamepad;
+        }
+
+        state->gamepad_slots = slots;
+    }
+
+    if(sections & INPUT_RECORD_TOUCH) {
+        input_recorder_write_varint(recorder, input->touch_current_count);
+        for(unsigned int i = 0; i < input->touch_current_count; i++) {
+            if(!input_recorder_reserve(recorder, INPUT_RECORD_TOUCH_MAX))
+                return SDL_FALSE;
+
+            SDL_TouchFingerEvent* event = &input->touch_current[i];
+            input_recorder_write_varint(recorder, event->type);
+            input_recorder_write_varint(recorder, event->timestamp);
+            input_recorder_write_varint(recorder, (Uint64)event->touchId);
+            input_recorder_write_varint(recorder, (Uint64)event->fingerId);
+            input_recorder_write_float(recorder, event->x);
+            input_recorder_write_float(recorder, event->y);
+            input_recorder_write_float(recorder, event->dx);
+            input_recorder_write_float(recorder, event->dy);
+            input_recorder_write_float(recorder, event->pressure);
+            input_recorder_write_varint(recorder, event->windowID);
+        }
+    }
+
+    if(sections & INPUT_RECORD_MOUSE_DELTA) {
+        if(!input_recorder_reserve(recorder, INPUT_RECORD_MOUSE_DELTA_MAX))
+            return SDL_FALSE;
+
+        input_recorder_write_signed(recorder, input->mouse_delta.x);
+        input_recorder_write_signed(recorder, input->mouse_delta.y);
+        state->delta = input->mouse_delta;
+    }
+
+    if(sections & INPUT_RECORD_GESTURE_TIME) {
+        if(!input_recorder_reserve(recorder, INPUT_RECORD_GESTURE_TIME_MAX))
+            return SDL_FALSE;
+
+        // The clock wraps, so the difference is taken as signed.
+        input_recorder_write_signed(recorder, (Sint32)(input->gesture.update_time - state->gesture_time));
+        state->gesture_time = input->gesture.update_time;
+    }
+
+    return SDL_TRUE;
+}
+
+static Uint64 input_replay_read_varint(InputReplay* replay) {
+    Uint64 value = 0;
+    for(int shift = 0; shift < 64; shift += 7) {
+        if(replay->position >= replay->size)
+            break;
+
+        Uint8 byte = replay->data[replay->position++];
+        value |= (Uint64)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+            return value;
+    }
+
+    replay->corrupt = SDL_TRUE;
+    return 0;
+}
+
+static Sint32 input_replay_read_signed(InputReplay* replay) {
+    return input_zigzag_decode((Uint32)input_replay_read_varint(replay));
+}
+
+static float input_replay_read_float(InputReplay* replay) {
+    if(replay->size - replay->position < 4) {
+        replay->corrupt = SDL_TRUE;
+        replay->position = replay->size;
+        return 0;
+    }
+
+    Uint32 bits = 0;
+    for(int i = 0; i < 4; i++)
+        bits |= (Uint32)replay->data[replay->position++] << (i * 8);
+
+    float value;
+    input_memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static InputReplay* input_replay_create(const void* data, size_t size) {
+    InputReplay* replay = input_calloc(1, sizeof(*replay));
+    if(!replay)
+        return NULL;
+
+    replay->data = data;
+    replay->size = size;
+
+    if(size < sizeof(input_record_magic) + 2 ||
+       SDL_memcmp(data, input_record_magic, sizeof(input_record_magic)) != 0 ||
+       replay->data[4] != INPUT_RECORD_VERSION ||
+       replay->data[5] > INPUT_RECORD_MAX_GAMEPADS)
+    {
+        SDL_SetError("Invalid input recording");
+        input_free(replay);
+        return NULL;
+    }
+
+    replay->position = sizeof(input_record_magic) + 2;
+    return replay;
+}
+
+InputReplay* input_replay_open_memory(const void* data, size_t size) {
+    return input_replay_create(data, size);
+}
+
+InputReplay* input_replay_open(const char* path) {
+    InputReplay* replay = NULL;
+
+#if defined(INPUT_REPLAY_MMAP)
+    int fd = open(path, O_RDONLY);
+    if(fd != -1) {
+        struct stat info;
+        if(fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapping != MAP_FAILED) {
+#ifdef POSIX_MADV_SEQUENTIAL
+                posix_madvise(mapping, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+                replay = input_replay_create(mapping, (size_t)info.st_size);
+                if(replay)
+                    replay->mapping = mapping;
+                else
+                    munmap(mapping, (size_t)info.st_size);
+            }
+        }
+        close(fd);
+        if(replay)
+            return replay;
+    }
+#elif defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        HANDLE mapping_handle = NULL;
+        void* mapping = NULL;
+        if(GetFileSizeEx(file, &size) && size.QuadPart > 0)
+            mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(mapping_handle)
+            mapping = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+        if(mapping) {
+            replay = input_replay_create(mapping, (size_t)size.QuadPart);
+            if(replay) {
+                replay->mapping = mapping;
+                replay->file_handle = file;
+                replay->mapping_handle = mapping_handle;
+                return replay;
+            }
+            UnmapViewOfFile(mapping);
+        }
+        if(mapping_handle)
+            CloseHandle(mapping_handle);
+        CloseHandle(file);
+    }
+#endif
+
+    // Falls back to reading the whole file when it can't be mapped.
+    size_t size;
+    void* data = SDL_LoadFile(path, &size);
+    if(!data)
+        return NULL;
+
+    replay = input_replay_create(data, size);
+    if(!replay) {
+        SDL_free(data);
+        return NULL;
+    }
+
+    replay->loaded = data;
+    return replay;
+}
+
+void input_replay_close(InputReplay* replay) {
+    if(replay->mapping) {
+#if defined(INPUT_REPLAY_MMAP)
+        munmap(replay->mapping, replay->size);
+#elif defined(_WIN32)
+        UnmapViewOfFile(replay->mapping);
+        CloseHandle(replay->mapping_handle);
+        CloseHandle(replay->file_handle);
+#endif
+    }
+
+    if(replay->loaded)
+        SDL_free(replay->loaded);
+
+    input_free(replay);
+}
+
+SDL_bool input_replay_finished(InputReplay* replay) {
+    return replay->corrupt || replay->position >= replay->size;
+}
+
+Uint64 input_replay_frame(InputReplay* replay) {
+    return replay->frame;
+}
+
+// Decodes the next frame into the replay state. Touch events are passed straight to the input manager.
+static SDL_bool input_replay_decode(InputReplay* replay, InputManager* input) {
+    InputRecordState* state = &replay->state;
+    Uint32 sections = (Uint32)input_replay_read_varint(replay);
+
+    if(sections & INPUT_RECORD_KEYBOARD) {
+        Uint32 key_words = (Uint32)input_replay_read_varint(replay);
+        for(int i = 0; i < INPUT_KEYBOARD_WORDS; i++) {
+            if(key_words & (1u << i))
+                state->keyboard[i] ^= input_replay_read_varint(replay);
+        }
+    }
+
+    if(sections & INPUT_RECORD_MOUSE_BUTTONS)
+        state->mouse = (MouseButton)input_replay_read_varint(replay);
+
+    if(sections & INPUT_RECORD_MOUSE_POSITION) {
+        state->position.x += input_replay_read_signed(replay);
+        state->position.y += input_replay_read_signed(replay);
+    }
+
+    if(sections & INPUT_RECORD_MOUSE_WHEEL) {
+        state->wheel_x = input_replay_read_signed(replay);
+        state->wheel_y = input_replay_read_signed(replay);
+    }
+
+    if(sections & INPUT_RECORD_GAMEPADS) {
+        Uint64 count = input_replay_read_varint(replay);
+        for(Uint64 i = 0; i < count && !replay->corrupt; i++) {
+            Uint64 index = input_replay_read_varint(replay);
+            if(index >= INPUT_RECORD_MAX_GAMEPADS)
+                return SDL_FALSE;
+
+            if((int)index >= state->gamepad_slots)
+                state->gamepad_slots = (int)index + 1;
+
+            InputRecordGamepad* gamepad = &state->gamepads[index];
+            Uint32 flags = (Uint32)input_replay_read_varint(replay);
+
+            if(flags & INPUT_RECORD_GAMEPAD_ACTIVE)
+                gamepad->active = !gamepad->active;
+
+            if(flags & INPUT_RECORD_GAMEPAD_BUTTONS)
+                gamepad->buttons = (GamepadButtonMask)input_replay_read_varint(replay);
+
+            for(int axis = 0; axis < SDL_CONTROLLER_AXIS_MAX; axis++) {
+                if(flags & (INPUT_RECORD_GAMEPAD_AXES << axis))
+                    gamepad->axes[axis] = (Sint16)(gamepad->axes[axis] + input_replay_read_signed(replay));
+            }
+        }
+    }
+
+    if(sections & INPUT_RECORD_TOUCH) {
+        Uint64 count = input_replay_read_varint(replay);
+        for(Uint64 i = 0; i < count && !replay->corrupt; i++) {
+            SDL_TouchFingerEvent event;
+            event.type = (Uint32)input_replay_read_varint(replay);
+            event.timestamp = (Uint32)input_replay_read_varint(replay);
+            event.touchId = (SDL_TouchID)input_replay_read_varint(replay);
+            event.fingerId = (SDL_FingerID)input_replay_read_varint(replay);
+            event.x = input_replay_read_float(replay);
+            event.y = input_replay_read_float(replay);
+            event.dx = input_replay_read_float(replay);
+            event.dy = input_replay_read_float(replay);
+            event.pressure = input_replay_read_float(replay);
+            event.windowID = (Uint32)input_replay_read_varint(replay);
+            input_manager_touch_event(input, &event);
+        }
+    }
+
+    if(sections & INPUT_RECORD_MOUSE_DELTA) {
+        state->delta.x = input_replay_read_signed(replay);
+        state->delta.y = input_replay_read_signed(replay);
+    }
+
+    if(sections & INPUT_RECORD_GESTURE_TIME)
+        state->gesture_time += (Uint32)input_replay_read_signed(replay);
+
+    return !replay->corrupt;
+}
+
+SDL_bool input_replay_update(InputReplay* replay, InputManager* input) {
+    if(input_replay_finished(replay))
+        return SDL_FALSE;
+
+    InputRecordState* state = &replay->state;
+
+    input_manager_begin_update(input);
+
+    if(!input_replay_decode(replay, input)) {
+        replay->corrupt = SDL_TRUE;
+        input_manager_end_update(input);
+        return SDL_FALSE;
+    }
+
+    input_memcpy(input->keyboard_current, state->keyboard, sizeof(state->keyboard));
+    input->mouse_current = state->mouse;
+    input->mouse_position_current = state->position;
+    input->mouse_wheel_x = state->wheel_x;
+    input->mouse_wheel_y = state->wheel_y;
+    input->mouse_delta = state->delta;
+    input->mouse_sample_count = 0;
+
+    // Only the state is recorded, so each press is counted once.
+    for(int i = 0; i < INPUT_MOUSE_BUTTONS; i++)
+        input->mouse_presses[i] = input_mouse_pressed(input, SDL_BUTTON(i + 1)) ? 1 : 0;
+
+    for(int i = 0; i < state->gamepad_slots; i++) {
+        InputGamepad* gamepad = input_gamepad_get(input, i);
+        InputRecordGamepad* recorded = &state->gamepads[i];
+
+        // Recorded gamepads are replayed as virtual gamepads without a controller,
+        // using negative instance ids so they can't collide with real ones.
+        if(!recorded->active) {
+            if(gamepad) {
+                SDL_GameController* controller = input_manager_detach_gamepad(input, gamepad->instance_id);
+                input_manager_close_gamepad(input, controller);
+            }
+            continue;
+        }
+
+        if(!gamepad) {
+            gamepad = input_manager_attach_gamepad(input, NULL, -2 - i, i);
+            if(!gamepad)
+                continue;
+        }
+
+        gamepad->button_previous = gamepad->button_current;
+        gamepad->button_current = recorded->buttons;
+        gamepad->button_state = recorded->buttons;
+        gamepad->active = recorded->active;
+        input_memcpy(gamepad->axes, recorded->axes, sizeof(gamepad->axes));
+    }
+
+    // Long presses are checked against the same clock as the recorded update,
+    // after its touch events, the same as <input_manager_update>.
+    input->gesture.update_time = state->gesture_time;
+    input_gesture_advance(input, state->gesture_time);
+
+    input_manager_end_update(input);
+    replay->frame++;
+    return SDL_TRUE;
+}
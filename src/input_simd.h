@@ -0,0 +1,151 @@
+#ifndef SDL_INPUT_INPUT_SIMD_H
+#define SDL_INPUT_INPUT_SIMD_H
+
+#include <SDL.h>
+
+#include "std_definitions.h"
+
+/*
+    Vectorized helpers used on the per-frame update path.
+    SSE2 is used when available, otherwise a portable scalar version
+    is used instead.
+*/
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INPUT_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/*
+    Packs an array of bytes where any non-zero value means "down"
+    (i.e. the array returned by SDL_GetKeyboardState) into a bitset.
+
+    @count The amount of bytes to read. Bits past count are cleared.
+    @words The amount of words in out.
+*/
+static inline void input_simd_pack_bytes(const Uint8* bytes, int count, Uint64* out, int words) {
+    int word = 0;
+
+#ifdef INPUT_SIMD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for(; word < words && (word + 1) * 64 <= count; word++) {
+        const Uint8* src = bytes + word * 64;
+        Uint64 m0 = (Uint16)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(src + 0)), zero));
+        Uint64 m1 = (Uint16)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(src + 16)), zero));
+        Uint64 m2 = (Uint16)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(src + 32)), zero));
+        Uint64 m3 = (Uint16)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(src + 48)), zero));
+        out[word] = ~(m0 | (m1 << 16) | (m2 << 32) | (m3 << 48));
+    }
+#elif SDL_BYTEORDER == SDL_LIL_ENDIAN
+    // Multiplying 8 bytes that are each 0 or 1 by this constant gathers
+    // them into the top byte of the product, one bit per byte.
+    for(; word < words && (word + 1) * 64 <= count; word++) {
+        const Uint8* src = bytes + word * 64;
+        Uint64 result = 0;
+        for(int i = 0; i < 8; i++) {
+            Uint64 chunk;
+            input_memcpy(&chunk, src + i * 8, sizeof(chunk));
+            // Normalize any non-zero byte to 1 before gathering.
+            chunk = ((chunk | (chunk >> 1) | (chunk >> 2) | (chunk >> 3) |
+                      (chunk >> 4) | (chunk >> 5) | (chunk >> 6) | (chunk >> 7)) & 0x0101010101010101ull);
+            result |= ((chunk * 0x0102040810204080ull) >> 56) << (i * 8);
+        }
+        out[word] = result;
+    }
+#endif
+
+    // Handles the tail, or everything on platforms without a fast path.
+    for(; word < words; word++) {
+        Uint64 result = 0;
+        for(int i = 0; i < 64 && word * 64 + i < count; i++) {
+            if(bytes[word * 64 + i])
+                result |= (Uint64)1 << i;
+        }
+        out[word] = result;
+    }
+}
+
+/*
+    Computes the edges between two bitsets.
+    pressed = current & ~previous, released = previous & ~current.
+*/
+static inline void input_simd_diff(const Uint64* current, const Uint64* previous, Uint64* pressed, Uint64* released, int words) {
+    int word = 0;
+
+#ifdef INPUT_SIMD_SSE2
+    for(; word + 2 <= words; word += 2) {
+        __m128i cur = _mm_loadu_si128((const __m128i*)(current + word));
+        __m128i prev = _mm_loadu_si128((const __m128i*)(previous + word));
+        _mm_storeu_si128((__m128i*)(pressed + word), _mm_andnot_si128(prev, cur));
+        _mm_storeu_si128((__m128i*)(released + word), _mm_andnot_si128(cur, prev));
+    }
+#endif
+
+    for(; word < words; word++) {
+        pressed[word] = current[word] & ~previous[word];
+        released[word] = previous[word] & ~current[word];
+    }
+}
+
+/*
+    Computes the length of each (x, y) pair.
+*/
+static inline void input_simd_length(const float* x, const float* y, float* out, int count) {
+    int i = 0;
+
+#ifdef INPUT_SIMD_SSE2
+    for(; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy))));
+    }
+#endif
+
+    for(; i < count; i++)
+        out[i] = SDL_sqrtf(x[i] * x[i] + y[i] * y[i]);
+}
+
+/*
+    Remaps magnitudes in place through a deadzone and a polynomial response curve:
+    t = clamp((value - inner) * scale, 0, 1), value = value > inner ? anti + (1 - anti) * t^degree : 0
+
+    @degree The power of the curve, from 1 to 3.
+*/
+static inline void input_simd_remap(float* values, int count, float inner, float scale, float anti, int degree) {
+    int i = 0;
+
+#ifdef INPUT_SIMD_SSE2
+    const __m128 vinner = _mm_set1_ps(inner);
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vanti = _mm_set1_ps(anti);
+    const __m128 vrest = _mm_set1_ps(1.0f - anti);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for(; i + 4 <= count; i += 4) {
+        __m128 value = _mm_loadu_ps(values + i);
+        __m128 t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(value, vinner), vscale), zero), one);
+        __m128 curve = t;
+        if(degree >= 2)
+            curve = _mm_mul_ps(curve, t);
+        if(degree >= 3)
+            curve = _mm_mul_ps(curve, t);
+        __m128 result = _mm_add_ps(vanti, _mm_mul_ps(vrest, curve));
+        _mm_storeu_ps(values + i, _mm_and_ps(result, _mm_cmpgt_ps(value, vinner)));
+    }
+#endif
+
+    for(; i < count; i++) {
+        float value = values[i];
+        float t = (value - inner) * scale;
+        t = t < 0 ? 0 : (t > 1 ? 1 : t);
+        float curve = t;
+        if(degree >= 2)
+            curve *= t;
+        if(degree >= 3)
+            curve *= t;
+        values[i] = value > inner ? anti + (1.0f - anti) * curve : 0;
+    }
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include <input_stats.h>
+
+#include <stdarg.h>
+
+#include "std_definitions.h"
+
+Uint32 input_latency_percentile(const InputLatencyHistogram* histogram, float fraction) {
+    if(histogram->samples == 0)
+        return 0;
+
+    Uint64 target = (Uint64)(fraction * (double)histogram->samples);
+    Uint64 seen = 0;
+    for(int i = 0; i < INPUT_LATENCY_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if(seen > target || seen == histogram->samples)
+            return input_latency_bucket_min(i);
+    }
+
+    return input_latency_bucket_min(INPUT_LATENCY_BUCKETS - 1);
+}
+
+// The longest line <input_latency_write> can write.
+#define INPUT_LATENCY_LINE_SIZE 1024
+
+// Appends to a line of JSON. Returns SDL_FALSE if it doesn't fit, leaving the length unchanged.
+static SDL_bool input_latency_append(char* line, size_t* length, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = SDL_vsnprintf(line + *length, INPUT_LATENCY_LINE_SIZE - *length, format, args);
+    va_end(args);
+
+    if(written < 0 || (size_t)written >= INPUT_LATENCY_LINE_SIZE - *length)
+        return SDL_FALSE;
+
+    *length += (size_t)written;
+    return SDL_TRUE;
+}
+
+// Appends a quoted JSON string, escaping quotes, backslashes and control characters.
+static SDL_bool input_latency_append_string(char* line, size_t* length, const char* text) {
+    if(!input_latency_append(line, length, "\""))
+        return SDL_FALSE;
+
+    for(const unsigned char* c = (const unsigned char*)text; *c; c++) {
+        SDL_bool appended;
+        if(*c == '"' || *c == '\\')
+            appended = input_latency_append(line, length, "\\%c", *c);
+        else if(*c < 0x20)
+            appended = input_latency_append(line, length, "\\u%04x", (unsigned int)*c);
+        else
+            appended = input_latency_append(line, length, "%c", *c);
+
+        if(!appended)
+            return SDL_FALSE;
+    }
+
+    return input_latency_append(line, length, "\"");
+}
+
+SDL_bool input_latency_write(const InputLatencyHistogram* histogram, const char* name, SDL_RWops* file) {
+    char line[INPUT_LATENCY_LINE_SIZE];
+    size_t length = 0;
+    double mean = histogram->samples ? (double)histogram->total_ms / (double)histogram->samples : 0;
+
+    SDL_bool fits = input_latency_append(line, &length, "{\"device\": ") &&
+                    input_latency_append_string(line, &length, name) &&
+                    input_latency_append(line, &length,
+                                         ", \"samples\": %llu, \"mean_ms\": %.3f, \"max_ms\": %u, \"buckets\": [",
+                                         (unsigned long long)histogram->samples,
+                                         mean,
+                                         (unsigned int)histogram->max_ms);
+
+    // Each bucket is written as [shortest delay, count].
+    for(int i = 0; i < INPUT_LATENCY_BUCKETS && fits; i++) {
+        fits = input_latency_append(line, &length,
+                                    "%s[%u, %llu]",
+                                    i == 0 ? "" : ", ",
+                                    (unsigned int)input_latency_bucket_min(i),
+                                    (unsigned long long)histogram->counts[i]);
+    }
+
+    if(!fits || !input_latency_append(line, &length, "]}\n")) {
+        SDL_SetError("The latency histogram doesn't fit in a line");
+        return SDL_FALSE;
+    }
+
+    return SDL_RWwrite(file, line, 1, length) == length;
+}
@@ -0,0 +1,87 @@
+#ifndef SDL_INPUT_INPUT_STATS_INTERNAL_H
+#define SDL_INPUT_INPUT_STATS_INTERNAL_H
+
+#include <input_stats.h>
+
+/*
+    Macros used to write the stats of a manager. They compile to nothing when
+    INPUT_ENABLE_STATS is 0, so they can be placed on the hot paths.
+*/
+
+#if INPUT_ENABLE_STATS
+
+#define INPUT_STATS_ADD(stats, field, amount) \
+    do { \
+        if((stats)->enabled) \
+            (stats)->pending.field += (amount); \
+    } while(0)
+
+// Records the timestamp of the event that changed an input, so the actions it changes can measure their latency.
+// Timestamps of 0 come from changes that weren't caused by an event, and aren't recorded.
+#define INPUT_STATS_STAMP(dest, time) \
+    do { \
+        if(time) \
+            (dest) = (time); \
+    } while(0)
+
+#define INPUT_STATS_BEGIN(stats, name) input_stats_begin(stats, name)
+#define INPUT_STATS_END(stats, name) input_stats_end(stats, name)
+
+static inline void input_stats_begin(InputStats* stats, const char* name) {
+    if(stats->trace)
+        stats->trace(stats->trace_userdata, name, SDL_TRUE);
+
+    if(stats->enabled)
+        stats->update_start = SDL_GetPerformanceCounter();
+}
+
+// Moves the pending counters into the last frame and the totals.
+static inline void input_stats_end(InputStats* stats, const char* name) {
+    if(stats->enabled) {
+        Uint64 elapsed = SDL_GetPerformanceCounter() - stats->update_start;
+        InputStatsCounters* pending = &stats->pending;
+        pending->updates++;
+        pending->update_ns += (Uint64)((double)elapsed * 1e9 / (double)SDL_GetPerformanceFrequency());
+
+        InputStatsCounters* total = &stats->total;
+        total->updates += pending->updates;
+        total->update_ns += pending->update_ns;
+        total->sdl_calls += pending->sdl_calls;
+        for(int i = 0; i < INPUT_STATS_EVENT_MAX; i++)
+            total->events[i] += pending->events[i];
+        total->allocations += pending->allocations;
+        total->reallocations += pending->reallocations;
+        total->actions_evaluated += pending->actions_evaluated;
+        total->actions_skipped += pending->actions_skipped;
+        total->touch_growths += pending->touch_growths;
+
+        stats->frame = *pending;
+        *pending = (InputStatsCounters){ 0 };
+    }
+
+    if(stats->trace)
+        stats->trace(stats->trace_userdata, name, SDL_FALSE);
+}
+
+static inline void input_latency_add(InputLatencyHistogram* histogram, Uint32 ms) {
+    int bucket = INPUT_LATENCY_BUCKETS - 1;
+    while(bucket > 0 && ms < input_latency_bucket_min(bucket))
+        bucket--;
+
+    histogram->counts[bucket]++;
+    histogram->samples++;
+    histogram->total_ms += ms;
+    if(ms > histogram->max_ms)
+        histogram->max_ms = ms;
+}
+
+#else
+
+#define INPUT_STATS_ADD(stats, field, amount) ((void)0)
+#define INPUT_STATS_STAMP(dest, time) ((void)(time))
+#define INPUT_STATS_BEGIN(stats, name) ((void)0)
+#define INPUT_STATS_END(stats, name) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,330 @@
+#include <input_manager.h>
+
+#include "std_definitions.h"
+#include "input_internal.h"
+
+#define INPUT_TOUCH_PI 3.14159265f
+
+#define INPUT_GESTURE_PAIR_MASK (INPUT_GESTURE_BIT(INPUT_GESTURE_PINCH_IN) | \
+                                 INPUT_GESTURE_BIT(INPUT_GESTURE_PINCH_OUT) | \
+                                 INPUT_GESTURE_BIT(INPUT_GESTURE_ROTATE_CLOCKWISE) | \
+                                 INPUT_GESTURE_BIT(INPUT_GESTURE_ROTATE_COUNTER_CLOCKWISE))
+
+void input_touch_init(InputManager* input) {
+    InputGestureSettings* settings = &input->gesture_settings;
+    settings->tap_time = 250;
+    settings->double_tap_time = 300;
+    settings->double_tap_distance = .05f;
+    settings->long_press_time = 500;
+    settings->tap_distance = .02f;
+    settings->swipe_distance = .1f;
+    settings->swipe_time = 500;
+    settings->pinch_threshold = .1f;
+    settings->rotate_threshold = .26f;
+
+    input->gesture.scale = 1.0f;
+}
+
+static float input_touch_distance_squared(float x0, float y0, float x1, float y1) {
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    return dx * dx + dy * dy;
+}
+
+static SDL_bool input_gesture_is_paired(InputGestureState* gesture, InputFinger* finger) {
+    for(int i = 0; i < 2; i++) {
+        if(gesture->pair_fingers[i] == finger->finger_id && gesture->pair_touches[i] == finger->touch_id)
+            return SDL_TRUE;
+    }
+
+    return SDL_FALSE;
+}
+
+// Gets the distance and angle between the pair of fingers.
+static SDL_bool input_gesture_measure_pair(InputManager* input, float* distance, float* angle) {
+    InputGestureState* gesture = &input->gesture;
+    InputFinger* first = input_touch_find_finger(input, gesture->pair_touches[0], gesture->pair_fingers[0]);
+    InputFinger* second = input_touch_find_finger(input, gesture->pair_touches[1], gesture->pair_fingers[1]);
+    if(!first || !second)
+        return SDL_FALSE;
+
+    *distance = SDL_sqrtf(input_touch_distance_squared(first->x, first->y, second->x, second->y));
+    *angle = SDL_atan2f(second->y - first->y, second->x - first->x);
+    return SDL_TRUE;
+}
+
+static void input_gesture_start_pair(InputManager* input, InputFinger* finger) {
+    InputGestureState* gesture = &input->gesture;
+    InputFinger* other = NULL;
+    for(int i = 0; i < input->finger_count; i++) {
+        if(input->fingers[i].down && &input->fingers[i] != finger) {
+            other = &input->fingers[i];
+            break;
+        }
+    }
+
+    if(!other)
+        return;
+
+    gesture->pair_touches[0] = other->touch_id;
+    gesture->pair_fingers[0] = other->finger_id;
+    gesture->pair_touches[1] = finger->touch_id;
+    gesture->pair_fingers[1] = finger->finger_id;
+
+    float distance;
+    float angle;
+    // Fingers on top of each other can't be measured against.
+    if(!input_gesture_measure_pair(input, &distance, &angle) || distance <= 0)
+        return;
+
+    gesture->pair = SDL_TRUE;
+    gesture->pair_distance = distance;
+    gesture->pair_angle = angle;
+    gesture->scale = 1.0f;
+    gesture->rotation = 0;
+}
+
+static void input_gesture_update_pair(InputManager* input) {
+    InputGestureState* gesture = &input->gesture;
+    InputGestureSettings* settings = &input->gesture_settings;
+
+    float distance;
+    float angle;
+    if(!input_gesture_measure_pair(input, &distance, &angle))
+        return;
+
+    // The rotation is accumulated from the change since the last event, so it can go past a half turn.
+    float turn = angle - gesture->pair_angle;
+    if(turn > INPUT_TOUCH_PI)
+        turn -= 2 * INPUT_TOUCH_PI;
+    else if(turn < -INPUT_TOUCH_PI)
+        turn += 2 * INPUT_TOUCH_PI;
+
+    gesture->rotation += turn;
+    gesture->pair_angle = angle;
+    gesture->scale = distance / gesture->pair_distance;
+
+    gesture->state &= ~INPUT_GESTURE_PAIR_MASK;
+
+    if(gesture->scale < 1.0f - settings->pinch_threshold)
+        gesture->state |= INPUT_GESTURE_BIT(INPUT_GESTURE_PINCH_IN);
+    else if(gesture->scale > 1.0f + settings->pinch_threshold)
+        gesture->state |= INPUT_GESTURE_BIT(INPUT_GESTURE_PINCH_OUT);
+
+    // The y axis points down, so a positive angle is clockwise on screen.
+    if(gesture->rotation > settings->rotate_threshold)
+        gesture->state |= INPUT_GESTURE_BIT(INPUT_GESTURE_ROTATE_CLOCKWISE);
+    else if(gesture->rotation < -settings->rotate_threshold)
+        gesture->state |= INPUT_GESTURE_BIT(INPUT_GESTURE_ROTATE_COUNTER_CLOCKWISE);
+}
+
+static void input_gesture_end_pair(InputGestureState* gesture) {
+    gesture->pair = SDL_FALSE;
+    gesture->scale = 1.0f;
+    gesture->rotation = 0;
+    gesture->state &= ~INPUT_GESTURE_PAIR_MASK;
+}
+
+// Turns a single finger that was just lifted into a tap, double tap, or swipe.
+static void input_gesture_single_release(InputManager* input, InputFinger* finger, Uint32 time) {
+    InputGestureState* gesture = &input->gesture;
+    InputGestureSettings* settings = &input->gesture_settings;
+    Uint32 duration = time - finger->down_time;
+
+    if(gesture->tap_candidate && !(gesture->state & INPUT_GESTURE_BIT(INPUT_GESTURE_LONG_PRESS)) && duration <= settings->tap_time) {
+        if(gesture->last_tap &&
+           time - gesture->last_tap_time <= settings->double_tap_time &&
+           input_touch_distance_squared(gesture->last_tap_x, gesture->last_tap_y, finger->x, finger->y) <=
+               settings->double_tap_distance * settings->double_tap_distance)
+        {
+            gesture->taps |= INPUT_GESTURE_BIT(INPUT_GESTURE_DOUBLE_TAP);
+            gesture->last_tap = SDL_FALSE;
+        } else {
+            gesture->taps |= INPUT_GESTURE_BIT(INPUT_GESTURE_TAP);
+            gesture->last_tap = SDL_TRUE;
+            gesture->last_tap_time = time;
+            gesture->last_tap_x = finger->x;
+            gesture->last_tap_y = finger->y;
+        }
+        return;
+    }
+
+    float dx = finger->x - finger->start_x;
+    float dy = finger->y - finger->start_y;
+    if(duration > settings->swipe_time || dx * dx + dy * dy < settings->swipe_distance * settings->swipe_distance)
+        return;
+
+    if(SDL_fabsf(dx) > SDL_fabsf(dy))
+        gesture->taps |= INPUT_GESTURE_BIT(dx < 0 ? INPUT_GESTURE_SWIPE_LEFT : INPUT_GESTURE_SWIPE_RIGHT);
+    else
+        gesture->taps |= INPUT_GESTURE_BIT(dy < 0 ? INPUT_GESTURE_SWIPE_UP : INPUT_GESTURE_SWIPE_DOWN);
+}
+
+void input_gesture_advance(InputManager* input, Uint32 time) {
+    InputGestureState* gesture = &input->gesture;
+
+    if(input_gesture_waiting(input) && (Sint32)(time - gesture->down_time) >= (Sint32)input->gesture_settings.long_press_time)
+        gesture->state |= INPUT_GESTURE_BIT(INPUT_GESTURE_LONG_PRESS);
+}
+
+static void input_finger_down(InputManager* input, SDL_TouchFingerEvent* event) {
+    InputGestureState* gesture = &input->gesture;
+    InputFinger* finger = input_touch_find_finger(input, event->touchId, event->fingerId);
+
+    // Repeated down events only move the finger.
+    if(finger && finger->down) {
+        finger->x = event->x;
+        finger->y = event->y;
+        return;
+    }
+
+    if(!finger) {
+        if(input->finger_count < INPUT_MAX_FINGERS) {
+            finger = &input->fingers[input->finger_count++];
+        } else {
+            // When the table is full, a lifted finger is replaced before its release is seen.
+            for(int i = 0; i < input->finger_count && !finger; i++) {
+                if(!input->fingers[i].down)
+                    finger = &input->fingers[i];
+            }
+
+            if(!finger)
+                return;
+        }
+    }
+
+    finger->touch_id = event->touchId;
+    finger->finger_id = event->fingerId;
+    finger->x = finger->start_x = event->x;
+    finger->y = finger->start_y = event->y;
+    finger->pressure = event->pressure;
+    finger->down_time = event->timestamp;
+    finger->down = SDL_TRUE;
+    finger->pressed = SDL_FALSE;
+    finger->released = SDL_FALSE;
+    finger->event_pressed = SDL_TRUE;
+
+    if(++gesture->fingers_down == 1) {
+        gesture->fingers_max = 1;
+        gesture->tap_candidate = SDL_TRUE;
+        gesture->down_time = event->timestamp;
+    } else {
+        gesture->tap_candidate = SDL_FALSE;
+        gesture->state &= ~INPUT_GESTURE_BIT(INPUT_GESTURE_LONG_PRESS);
+    }
+
+    if(gesture->fingers_down > gesture->fingers_max)
+        gesture->fingers_max = gesture->fingers_down;
+
+    if(gesture->fingers_down == 2 && !gesture->pair)
+        input_gesture_start_pair(input, finger);
+}
+
+// Moves a finger, ruling out a tap if it moved too far.
+static void input_finger_move(InputManager* input, InputFinger* finger, SDL_TouchFingerEvent* event) {
+    InputGestureState* gesture = &input->gesture;
+    InputGestureSettings* settings = &input->gesture_settings;
+
+    finger->x = event->x;
+    finger->y = event->y;
+    finger->pressure = event->pressure;
+
+    if(gesture->tap_candidate &&
+       input_touch_distance_squared(finger->start_x, finger->start_y, finger->x, finger->y) >
+           settings->tap_distance * settings->tap_distance)
+    {
+        gesture->tap_candidate = SDL_FALSE;
+    }
+}
+
+static void input_finger_motion(InputManager* input, SDL_TouchFingerEvent* event) {
+    InputGestureState* gesture = &input->gesture;
+    InputFinger* finger = input_touch_find_finger(input, event->touchId, event->fingerId);
+    if(!finger || !finger->down)
+        return;
+
+    input_finger_move(input, finger, event);
+
+    if(gesture->pair && input_gesture_is_paired(gesture, finger))
+        input_gesture_update_pair(input);
+}
+
+static void input_finger_up(InputManager* input, SDL_TouchFingerEvent* event) {
+    InputGestureState* gesture = &input->gesture;
+    InputFinger* finger = input_touch_find_finger(input, event->touchId, event->fingerId);
+    if(!finger || !finger->down)
+        return;
+
+    input_finger_move(input, finger, event);
+    finger->down = SDL_FALSE;
+    gesture->fingers_down--;
+
+    if(gesture->pair && input_gesture_is_paired(gesture, finger))
+        input_gesture_end_pair(gesture);
+
+    if(gesture->fingers_down == 0) {
+        if(gesture->fingers_max == 1)
+            input_gesture_single_release(input, finger, event->timestamp);
+
+        gesture->tap_candidate = SDL_FALSE;
+        gesture->state &= ~INPUT_GESTURE_BIT(INPUT_GESTURE_LONG_PRESS);
+    }
+}
+
+void input_manager_touch_event(InputManager* input, SDL_TouchFingerEvent* event) {
+    INPUT_STATS_ADD(&input->stats, events[INPUT_STATS_EVENT_TOUCH], 1);
+
+    if(input->touch_event_poll_count == input->touch_previous_capacity) {
+        unsigned int capacity = input->touch_previous_capacity == 0 ? 4 : input->touch_previous_capacity * 2;
+        void* buffer = input_manager_reallocate(input, input->touch_previous, capacity * sizeof(*input->touch_previous));
+        INPUT_STATS_ADD(&input->stats, touch_growths, 1);
+        if(buffer) {
+            input->touch_previous_capacity = capacity;
+            input->touch_previous = buffer;
+        }
+    }
+
+    // The raw events are still kept for anything that needs them, but the fingers
+    // and gestures don't depend on them.
+    if(input->touch_event_poll_count < input->touch_previous_capacity)
+        input->touch_previous[input->touch_event_poll_count++] = *event;
+
+    input->gesture.time = event->timestamp;
+
+    switch(event->type) {
+        case SDL_FINGERDOWN:
+            input_finger_down(input, event);
+            break;
+        case SDL_FINGERMOTION:
+            input_finger_motion(input, event);
+            break;
+        case SDL_FINGERUP:
+            input_finger_up(input, event);
+            break;
+    }
+
+    input_gesture_advance(input, event->timestamp);
+}
+
+void input_touch_update(InputManager* input) {
+    InputGestureState* gesture = &input->gesture;
+
+    input->gesture_previous = input->gesture_current;
+    input->gesture_current = gesture->state | gesture->taps;
+    gesture->taps = 0;
+
+    // Fingers stay in the table for one update after they're lifted, so the release can be seen.
+    int count = 0;
+    for(int i = 0; i < input->finger_count; i++) {
+        InputFinger finger = input->fingers[i];
+        if(!finger.down && finger.released)
+            continue;
+
+        finger.pressed = finger.event_pressed;
+        finger.event_pressed = SDL_FALSE;
+        finger.released = !finger.down;
+        input->fingers[count++] = finger;
+    }
+
+    input->finger_count = count;
+}
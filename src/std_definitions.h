@@ -10,17 +10,69 @@
     #define input_malloc SDL_malloc
 */
 
-#ifndef input_malloc
-
 #include <stdlib.h>
 #include <string.h>
 
+// Each one has its own guard, so overriding only some of them still works.
+
+#ifndef input_malloc
 #define input_malloc malloc
+#endif
+
+#ifndef input_calloc
 #define input_calloc calloc
+#endif
+
+#ifndef input_realloc
 #define input_realloc realloc
+#endif
+
+#ifndef input_free
 #define input_free free
+#endif
+
+#ifndef input_memmove
 #define input_memmove memmove
+#endif
+
+#ifndef input_memcpy
+#define input_memcpy memcpy
+#endif
 
+#ifndef input_memset
+#define input_memset memset
 #endif
 
+/*
+    Allocations made on behalf of a manager go through its <InputAllocator>,
+    which falls back to the methods above when it isn't set.
+*/
+
+#include <input_allocator.h>
+
+static inline void* input_allocator_malloc(const InputAllocator* allocator, size_t size) {
+    return allocator->alloc ? allocator->alloc(allocator->ctx, size) : input_malloc(size);
+}
+
+static inline void* input_allocator_calloc(const InputAllocator* allocator, size_t count, size_t size) {
+    if(!allocator->alloc)
+        return input_calloc(count, size);
+
+    void* ptr = allocator->alloc(allocator->ctx, count * size);
+    if(ptr)
+        input_memset(ptr, 0, count * size);
+    return ptr;
+}
+
+static inline void* input_allocator_realloc(const InputAllocator* allocator, void* ptr, size_t size) {
+    return allocator->alloc ? allocator->realloc(allocator->ctx, ptr, size) : input_realloc(ptr, size);
+}
+
+static inline void input_allocator_free(const InputAllocator* allocator, void* ptr) {
+    if(!allocator->alloc)
+        input_free(ptr);
+    else if(ptr)
+        allocator->free(allocator->ctx, ptr);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include <stdio.h>
+
+// SDL2main isn't linked, so main has to stay main on every platform.
+#define SDL_MAIN_HANDLED
+#include <action_manager.h>
+#include <action_profile.h>
+
+/*
+    Checks that every key survives the text form of a profile.
+
+    Binds every scancode to an action of its own, writes the profile as text and parses it back,
+    so a key whose name reads back as another key, or that the parser can't read at all, shows up
+    as a mismatch. Every other key also gets a direction, to cover names followed by more tokens.
+*/
+
+// Room for every scancode on a line of its own.
+static char profile_text[SDL_NUM_SCANCODES * 64];
+
+int main(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+
+    ActionManager* actions = action_manager_create(SDL_NUM_SCANCODES);
+    if(!actions) {
+        fprintf(stderr, "Failed to create the action manager: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    for(int key = 0; key < SDL_NUM_SCANCODES; key++) {
+        if(key % 2)
+            action_manager_add_key_direction(actions, key, (SDL_Scancode)key, -1, 0.5f);
+        else
+            action_manager_add_key(actions, key, (SDL_Scancode)key);
+    }
+
+    ActionProfile* written = action_profile_from_manager(actions, NULL);
+    SDL_RWops* file = SDL_RWFromMem(profile_text, sizeof(profile_text));
+    if(!written || !file || !action_profile_write_text(written, file)) {
+        fprintf(stderr, "Failed to write the profile: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    size_t length = (size_t)SDL_RWtell(file);
+    SDL_RWclose(file);
+
+    ActionProfile* parsed = action_profile_parse(profile_text, length, NULL);
+    if(!parsed) {
+        fprintf(stderr, "Failed to parse the profile: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    int failures = 0;
+    if(parsed->action_count != SDL_NUM_SCANCODES) {
+        fprintf(stderr, "The profile has %u actions instead of %d\n", parsed->action_count, SDL_NUM_SCANCODES);
+        failures++;
+    }
+
+    for(int key = 0; key < SDL_NUM_SCANCODES && key < (int)parsed->action_count; key++) {
+        const InputAction* expected = &written->bindings[written->action_offsets[key]];
+        int offset = parsed->action_offsets[key];
+        int count = parsed->action_offsets[key + 1] - offset;
+        const InputAction* actual = &parsed->bindings[offset];
+
+        if(count != 1 || actual->type != INPUT_ACTION_KEYBOARD || actual->key != expected->key ||
+           actual->x != expected->x || actual->y != expected->y) {
+            fprintf(stderr, "Scancode %d (\"%s\") didn't read back as itself\n", key, SDL_GetScancodeName((SDL_Scancode)key));
+            failures++;
+        }
+    }
+
+    action_profile_free(parsed);
+    action_profile_free(written);
+    action_manager_free(actions);
+
+    if(failures)
+        fprintf(stderr, "%d mismatches\n", failures);
+    else
+        printf("Every scancode reads back from a profile\n");
+
+    return failures ? 1 : 0;
+}
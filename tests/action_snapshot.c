@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// SDL2main isn't linked, so main has to stay main on every platform.
+#define SDL_MAIN_HANDLED
+#include <input_manager.h>
+#include <action_manager.h>
+#include <action_snapshot.h>
+
+/*
+    Round trips the snapshots of an <ActionManager> through every path: save, encode, decode and restore,
+    both on their own and as a delta against the previous update, including decoding a delta in place over
+    its own base. Every encoding is checked against <action_snapshot_max_encoded_size>, and every truncated
+    encoding has to be rejected.
+
+    The actions are driven by keys and a stick on a virtual gamepad that change randomly every update,
+    using a virtual backend so SDL doesn't need to be initialized.
+*/
+
+#define TEST_FRAMES 200
+#define TEST_GAMEPAD_ID 1
+
+static const int test_action_counts[] = { 1, 7, 64, 65, 200 };
+
+static Uint32 test_random_state = 0x2545F491;
+
+static Uint32 test_random(void) {
+    // xorshift32, so every run sees the same sequence.
+    test_random_state ^= test_random_state << 13;
+    test_random_state ^= test_random_state >> 17;
+    test_random_state ^= test_random_state << 5;
+    return test_random_state;
+}
+
+static int failures;
+
+#define TEST_CHECK(condition, ...) \
+    do { \
+        if(!(condition)) { \
+            fprintf(stderr, __VA_ARGS__); \
+            fprintf(stderr, "\n"); \
+            failures++; \
+        } \
+    } while(0)
+
+static SDL_Scancode test_action_key(int action) {
+    return (SDL_Scancode)(SDL_SCANCODE_A + action % 200);
+}
+
+static void test_add_bindings(ActionManager* actions, int action_count) {
+    for(int i = 0; i < action_count; i++) {
+        action_manager_add_key(actions, i, test_action_key(i));
+
+        // Every third action also has an analog value that isn't implied by its state.
+        if(i % 3 == 0) {
+            float x_scale = (float)(i % 5 - 2) / 2.0f;
+            float y_scale = (float)(i % 7 - 3) / 3.0f;
+            action_manager_add_gamepad_stick(actions, i, INPUT_AXIS_GROUP_LEFT_STICK, -1, x_scale, y_scale);
+        }
+    }
+}
+
+static void test_randomize_input(InputManager* input, int action_count) {
+    // Roughly one key in eight changes per update, so the deltas stay small but aren't empty.
+    for(int i = 0; i < action_count; i++) {
+        if(test_random() % 8 == 0)
+            input_manager_set_key(input, test_action_key(i), test_random() % 2 ? SDL_TRUE : SDL_FALSE);
+    }
+
+    if(test_random() % 4 == 0) {
+        input_manager_set_gamepad_axis(input, TEST_GAMEPAD_ID, SDL_CONTROLLER_AXIS_LEFTX, (Sint16)test_random());
+        input_manager_set_gamepad_axis(input, TEST_GAMEPAD_ID, SDL_CONTROLLER_AXIS_LEFTY, (Sint16)test_random());
+    }
+}
+
+// Decodes an encoding, along with every truncated copy of it, which all have to be rejected.
+static void test_decode(ActionManager* actions, const Uint8* data, size_t size, const void* base, void* snapshot, const void* expected, const char* kind, int frame) {
+    size_t snapshot_size = action_snapshot_size(actions);
+
+    for(size_t length = 0; length < size; length++) {
+        TEST_CHECK(!action_snapshot_decode(actions, data, length, base, snapshot),
+                   "%d actions, frame %d: %s snapshot truncated to %u of %u bytes was accepted",
+                   actions->action_count, frame, kind, (unsigned int)length, (unsigned int)size);
+    }
+
+    SDL_bool decoded = action_snapshot_decode(actions, data, size, base, snapshot);
+    TEST_CHECK(decoded && memcmp(snapshot, expected, snapshot_size) == 0,
+               "%d actions, frame %d: %s snapshot didn't round trip", actions->action_count, frame, kind);
+}
+
+// Checks that a restored manager reads the same as the one the snapshot was saved from.
+static void test_compare_restored(ActionManager* original, ActionManager* restored, int frame) {
+    // Values are quantized to 127 steps per unit.
+    const float tolerance = 0.5f / 127.0f + 1e-5f;
+
+    for(int i = 0; i < original->action_count; i++) {
+        TEST_CHECK(action_check(original, i) == action_check(restored, i) &&
+                   action_pressed(original, i) == action_pressed(restored, i) &&
+                   action_released(original, i) == action_released(restored, i),
+                   "%d actions, frame %d: restored state of action %d doesn't match", original->action_count, frame, i);
+
+        float dx = original->value_x[i] - restored->value_x[i];
+        float dy = original->value_y[i] - restored->value_y[i];
+        TEST_CHECK(dx <= tolerance && dx >= -tolerance && dy <= tolerance && dy >= -tolerance,
+                   "%d actions, frame %d: restored value of action %d is (%f, %f) instead of (%f, %f)",
+                   original->action_count, frame, i,
+                   restored->value_x[i], restored->value_y[i], original->value_x[i], original->value_y[i]);
+    }
+}
+
+static SDL_bool test_run(int action_count) {
+    InputBackend backend = input_backend_virtual();
+    InputManager* input = input_manager_create_with_backend(&backend, NULL);
+    ActionManager* actions = action_manager_create(action_count);
+    ActionManager* restored = action_manager_create(action_count);
+    if(!input || !actions || !restored || input_manager_add_virtual_gamepad(input, TEST_GAMEPAD_ID, 0) < 0)
+        return SDL_FALSE;
+
+    test_add_bindings(actions, action_count);
+
+    size_t snapshot_size = action_snapshot_size(actions);
+    size_t max_size = action_snapshot_max_encoded_size(actions);
+    // The current and previous snapshot are kept next to each other, like in a rollback ring.
+    Uint8* ring = calloc(2, snapshot_size);
+    Uint8* decoded = calloc(1, snapshot_size);
+    Uint8* buffer = calloc(1, max_size);
+    if(!ring || !decoded || !buffer)
+        return SDL_FALSE;
+
+    TEST_CHECK(snapshot_size % sizeof(Uint64) == 0, "%d actions: snapshots take %u bytes, which isn't a multiple of 8", action_count, (unsigned int)snapshot_size);
+
+    Uint8* snapshot = ring;
+    Uint8* base = ring + snapshot_size;
+
+    for(int frame = 0; frame < TEST_FRAMES; frame++) {
+        snapshot = ring + (frame % 2) * snapshot_size;
+        base = ring + ((frame + 1) % 2) * snapshot_size;
+
+        test_randomize_input(input, action_count);
+        input_manager_update(input);
+        action_manager_update(actions, input);
+        action_snapshot_save(actions, snapshot);
+
+        size_t size = action_snapshot_encode(actions, snapshot, NULL, buffer, max_size);
+        TEST_CHECK(size > 0 && size <= max_size,
+                   "%d actions, frame %d: full snapshot took %u of at most %u bytes", action_count, frame, (unsigned int)size, (unsigned int)max_size);
+        TEST_CHECK(size == 0 || action_snapshot_encode(actions, snapshot, NULL, buffer, size - 1) == 0,
+                   "%d actions, frame %d: full snapshot was written past the capacity", action_count, frame);
+        test_decode(actions, buffer, size, NULL, decoded, snapshot, "full", frame);
+
+        // A delta needs its base, so decoding it on its own has to fail.
+        if(frame > 0) {
+            size = action_snapshot_encode(actions, snapshot, base, buffer, max_size);
+            TEST_CHECK(size > 0 && size <= max_size,
+                       "%d actions, frame %d: delta snapshot took %u of at most %u bytes", action_count, frame, (unsigned int)size, (unsigned int)max_size);
+            test_decode(actions, buffer, size, base, decoded, snapshot, "delta", frame);
+            TEST_CHECK(!action_snapshot_decode(actions, buffer, size, NULL, decoded),
+                       "%d actions, frame %d: delta snapshot was decoded without its base", action_count, frame);
+
+            // Decoding over the base itself, which is how a receiver keeps a single copy.
+            memcpy(decoded, base, snapshot_size);
+            TEST_CHECK(action_snapshot_decode(actions, buffer, size, decoded, decoded) && memcmp(decoded, snapshot, snapshot_size) == 0,
+                       "%d actions, frame %d: delta snapshot decoded over its base didn't round trip", action_count, frame);
+        }
+
+        action_snapshot_restore(restored, snapshot, frame > 0 ? base : NULL);
+        test_compare_restored(actions, restored, frame);
+    }
+
+    // Every action set and every value changed is the largest an encoding can get.
+    for(int i = 0; i < action_count; i++)
+        input_manager_set_key(input, test_action_key(i), SDL_TRUE);
+    input_manager_set_gamepad_axis(input, TEST_GAMEPAD_ID, SDL_CONTROLLER_AXIS_LEFTX, SDL_MAX_SINT16);
+    input_manager_set_gamepad_axis(input, TEST_GAMEPAD_ID, SDL_CONTROLLER_AXIS_LEFTY, -SDL_MAX_SINT16);
+    input_manager_update(input);
+    action_manager_update(actions, input);
+    action_snapshot_save(actions, snapshot);
+    size_t values = INPUT_BITSET_WORDS(action_count) * sizeof(Uint64);
+    memset(base, 0, snapshot_size);
+    memset(base + values, 64, (size_t)action_count * 2);
+
+    size_t size = action_snapshot_encode(actions, snapshot, base, buffer, max_size);
+    TEST_CHECK(size > 0 && size <= max_size,
+               "%d actions: the largest delta took %u of at most %u bytes", action_count, (unsigned int)size, (unsigned int)max_size);
+    test_decode(actions, buffer, size, base, decoded, snapshot, "largest delta", TEST_FRAMES);
+
+    free(ring);
+    free(decoded);
+    free(buffer);
+    action_manager_free(restored);
+    action_manager_free(actions);
+    input_manager_free(input);
+    return SDL_TRUE;
+}
+
+// Data that's clearly invalid, rather than just cut short, has to be rejected as well.
+static void test_corrupt(void) {
+    ActionManager* small = action_manager_create(8);
+    ActionManager* large = action_manager_create(200);
+    if(!small || !large) {
+        TEST_CHECK(SDL_FALSE, "Failed to create the managers for the corrupt data checks");
+        return;
+    }
+
+    // Snapshots start with a bitset, so they're kept aligned for it.
+    Uint64 small_snapshot[32] = { 0 };
+    Uint64 large_snapshot[128] = { 0 };
+    Uint64 large_base[128] = { 0 };
+    Uint8 buffer[1024];
+
+    // A delta without a base.
+    Uint8 delta_flag = 1;
+    TEST_CHECK(!action_snapshot_decode(small, &delta_flag, 1, NULL, small_snapshot), "A delta without a base was accepted");
+
+    // Zeroes make an Elias gamma code that never ends.
+    Uint8 zeroes[64] = { 0 };
+    TEST_CHECK(!action_snapshot_decode(small, zeroes, sizeof(zeroes), NULL, small_snapshot), "A list without an end was accepted");
+
+    // A delta listing more actions than the manager has.
+    for(int i = 0; i < 200; i++)
+        input_bitset_set(large_snapshot, i);
+    size_t size = action_snapshot_encode(large, large_snapshot, large_base, buffer, sizeof(buffer));
+    TEST_CHECK(size > 0, "Failed to encode the delta for the corrupt data checks");
+    TEST_CHECK(!action_snapshot_decode(small, buffer, size, small_snapshot, small_snapshot), "A delta with too many actions was accepted");
+
+    // Random data either decodes or is rejected, but never reads or writes out of bounds.
+    for(int i = 0; i < 1000; i++) {
+        size_t length = test_random() % sizeof(buffer);
+        for(size_t j = 0; j < length; j++)
+            buffer[j] = (Uint8)test_random();
+        action_snapshot_decode(large, buffer, length, large_base, large_snapshot);
+    }
+
+    action_manager_free(small);
+    action_manager_free(large);
+}
+
+int main(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+
+    for(int i = 0; i < (int)SDL_arraysize(test_action_counts); i++) {
+        if(!test_run(test_action_counts[i])) {
+            fprintf(stderr, "Failed to set up %d actions: %s\n", test_action_counts[i], SDL_GetError());
+            return 1;
+        }
+    }
+
+    test_corrupt();
+
+    if(failures)
+        fprintf(stderr, "%d failures\n", failures);
+    else
+        printf("Snapshots round trip for every action count\n");
+
+    return failures ? 1 : 0;
+}
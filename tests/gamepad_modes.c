@@ -0,0 +1,161 @@
+#include <stdio.h>
+
+// SDL2main isn't linked, so main has to stay main on every platform.
+#define SDL_MAIN_HANDLED
+#include <input_manager.h>
+
+/*
+    Checks that a gamepad reads the same whether its state is polled or built from events.
+
+    Runs headless using SDL's dummy video driver, with the gamepad provided by a virtual joystick.
+    A scripted session is played back on the joystick, and every SDL event is passed to two managers,
+    one polling the gamepad and one with <INPUT_MANAGER_GAMEPAD_EVENTS> set. The button state and
+    edges of both are compared after every update.
+*/
+
+typedef struct ScriptStep {
+    int frame;
+    // Either a button or an axis is changed, the other one is -1.
+    int button;
+    int axis;
+    Sint16 value;
+} ScriptStep;
+
+static const ScriptStep script[] = {
+    { 2, SDL_CONTROLLER_BUTTON_A, -1, 1 },
+    { 5, SDL_CONTROLLER_BUTTON_A, -1, 0 },
+    { 6, SDL_CONTROLLER_BUTTON_B, -1, 1 },
+    { 6, SDL_CONTROLLER_BUTTON_X, -1, 1 },
+    { 7, SDL_CONTROLLER_BUTTON_B, -1, 0 },
+    { 9, SDL_CONTROLLER_BUTTON_X, -1, 0 },
+    { 9, SDL_CONTROLLER_BUTTON_DPAD_UP, -1, 1 },
+    { 10, SDL_CONTROLLER_BUTTON_DPAD_UP, -1, 0 },
+    { 10, SDL_CONTROLLER_BUTTON_DPAD_LEFT, -1, 1 },
+    { 11, SDL_CONTROLLER_BUTTON_DPAD_LEFT, -1, 0 },
+    { 12, -1, SDL_CONTROLLER_AXIS_LEFTX, 30000 },
+    { 14, -1, SDL_CONTROLLER_AXIS_LEFTY, -30000 },
+    { 16, -1, SDL_CONTROLLER_AXIS_LEFTX, 0 },
+    { 17, -1, SDL_CONTROLLER_AXIS_LEFTY, 0 },
+    { 18, -1, SDL_CONTROLLER_AXIS_RIGHTY, 20000 },
+    { 19, -1, SDL_CONTROLLER_AXIS_RIGHTY, 0 },
+    { 20, -1, SDL_CONTROLLER_AXIS_TRIGGERLEFT, 10000 },
+    { 21, -1, SDL_CONTROLLER_AXIS_TRIGGERLEFT, SDL_MAX_SINT16 },
+    { 23, -1, SDL_CONTROLLER_AXIS_TRIGGERLEFT, 0 },
+    { 24, SDL_CONTROLLER_BUTTON_START, -1, 1 },
+    { 24, SDL_CONTROLLER_BUTTON_LEFTSHOULDER, -1, 1 },
+    { 26, SDL_CONTROLLER_BUTTON_START, -1, 0 },
+    { 28, SDL_CONTROLLER_BUTTON_LEFTSHOULDER, -1, 0 }
+};
+
+#define SCRIPT_FRAMES 32
+
+static void script_apply(SDL_Joystick* joystick, int frame) {
+    for(int i = 0; i < (int)SDL_arraysize(script); i++) {
+        const ScriptStep* step = &script[i];
+        if(step->frame != frame)
+            continue;
+
+        if(step->button != -1)
+            SDL_JoystickSetVirtualButton(joystick, step->button, (Uint8)step->value);
+        else
+            SDL_JoystickSetVirtualAxis(joystick, step->axis, step->value);
+    }
+}
+
+static GamepadButtonMask gamepad_field(InputManager* input, int field) {
+    InputGamepad* gamepad = input_gamepad_get(input, -1);
+    if(!gamepad)
+        return 0;
+
+    switch(field) {
+        case 0:
+            return gamepad->button_current;
+        case 1:
+            return gamepad->button_pressed;
+        default:
+            return gamepad->button_released;
+    }
+}
+
+static const char* const field_names[] = { "button_current", "button_pressed", "button_released" };
+
+int main(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+
+    SDL_SetMainReady();
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    SDL_SetHint(SDL_HINT_JOYSTICK_ALLOW_BACKGROUND_EVENTS, "1");
+    if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) != 0) {
+        fprintf(stderr, "Failed to initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    int index = SDL_JoystickAttachVirtual(SDL_JOYSTICK_TYPE_GAMECONTROLLER, SDL_CONTROLLER_AXIS_MAX, SDL_CONTROLLER_BUTTON_MAX, 0);
+    SDL_Joystick* joystick = index >= 0 ? SDL_JoystickOpen(index) : NULL;
+    if(!joystick) {
+        fprintf(stderr, "Failed to attach a virtual joystick: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    InputManager* polled = input_manager_create();
+    InputManager* evented = input_manager_create();
+    if(!polled || !evented) {
+        fprintf(stderr, "Failed to create the input managers: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    input_manager_set_flags(evented, INPUT_MANAGER_GAMEPAD_EVENTS);
+
+    int failures = 0;
+    int presses = 0;
+
+    for(int frame = 0; frame < SCRIPT_FRAMES; frame++) {
+        script_apply(joystick, frame);
+
+        // Both managers have to see every event, so they're passed along one at a time.
+        SDL_PumpEvents();
+        SDL_Event e;
+        while(SDL_PollEvent(&e)) {
+            input_manager_event(polled, &e);
+            input_manager_event(evented, &e);
+        }
+
+        input_manager_update(polled);
+        input_manager_update(evented);
+
+        for(int field = 0; field < (int)SDL_arraysize(field_names); field++) {
+            GamepadButtonMask expected = gamepad_field(polled, field);
+            GamepadButtonMask actual = gamepad_field(evented, field);
+            if(expected != actual) {
+                fprintf(stderr, "Frame %d: %s is %016llx when polled and %016llx from events\n",
+                        frame,
+                        field_names[field],
+                        (unsigned long long)expected,
+                        (unsigned long long)actual);
+                failures++;
+            }
+        }
+
+        presses += gamepad_field(polled, 1) != 0;
+    }
+
+    // Makes sure the script actually reached the managers, so an empty session can't pass.
+    if(presses == 0) {
+        fprintf(stderr, "The gamepad never saw a press\n");
+        failures++;
+    }
+
+    input_manager_free(polled);
+    input_manager_free(evented);
+    SDL_JoystickClose(joystick);
+    SDL_JoystickDetachVirtual(index);
+    SDL_Quit();
+
+    if(failures)
+        fprintf(stderr, "%d mismatches\n", failures);
+    else
+        printf("Polled and event gamepad state match for %d frames\n", SCRIPT_FRAMES);
+
+    return failures ? 1 : 0;
+}